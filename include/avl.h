@@ -3,7 +3,10 @@
 
 #include <algorithm> 
 #include <iostream>
+#include <optional>
+#include <string>
 #include <vector>
+#include "stats.h"
 
 struct AVLNode {
     int key;
@@ -16,7 +19,13 @@ struct AVLNode {
 
 class AVLTree {
 private:
+    static constexpr size_t SEARCH_BATCH_WIDTH = 16; // lookups advanced in lockstep by searchBatch
+#ifdef HEAPURI_TREE_STATS
+    mutable TreeStats stats; // mutable so that const lookups are counted too
+#endif
+
     AVLNode *root;
+    size_t scratchPeak; // bytes of the largest temporary node buffer one join or loadSorted held
 
     int getHeight(AVLNode *node);
     int getBalanceFactor(AVLNode *node);
@@ -33,22 +42,51 @@ private:
     AVLNode* floorRecursive(AVLNode* node, int key) const;
     AVLNode* ceilingRecursive(AVLNode* node, int key) const;
     void rangeQueryRecursive(AVLNode* node, int x, int y, std::vector<int>& result) const;
+    void floorBatchRecursive(AVLNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                             const AVLNode* best, std::vector<std::optional<int>>& result) const;
+    void ceilingBatchRecursive(AVLNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                               const AVLNode* best, std::vector<std::optional<int>>& result) const;
     void inOrderTraversal(AVLNode* node, std::vector<AVLNode*>& nodes) const;
     AVLNode* buildBalancedTree(const std::vector<AVLNode*>& nodes, int start, int end);
+    size_t countNodes(const AVLNode* node) const;
 
 public:
     AVLTree();
     ~AVLTree();
+    AVLTree(AVLTree&& other) noexcept;
+    AVLTree& operator=(AVLTree&& other) noexcept;
+    AVLTree(const AVLTree&) = delete;
+    AVLTree& operator=(const AVLTree&) = delete;
 
     void insert(int key); // O(log n)
     void remove(int key); // O(log n)
     bool search(int key) const; // O(log n)
+    // interleaved lookups - found[i] is set to search(keys[i]), child nodes are prefetched
+    // so that up to SEARCH_BATCH_WIDTH cache misses are in flight at once
+    void searchBatch(const int* keys, size_t count, bool* found) const; // O(count * log n)
     bool isEmpty() const; // O(1)
     AVLTree join(const AVLTree& other); // O(n + m)
     int floor(int key) const; // O(log n)
     int ceiling(int key) const; // O(log n)
+    // non-throwing variants - an empty optional means no such key exists
+    std::optional<int> tryFloor(int key) const; // O(log n)
+    std::optional<int> tryCeiling(int key) const; // O(log n)
+    std::optional<int> predecessor(int key) const; // O(log n) - largest key strictly less than key
+    std::optional<int> successor(int key) const; // O(log n) - smallest key strictly greater than key
+    // batched variants - probes must be sorted ascending, answered in one traversal of the tree
+    std::vector<std::optional<int>> floorBatch(const std::vector<int>& probes) const; // O(m log n) - shared path prefixes are visited once
+    std::vector<std::optional<int>> ceilingBatch(const std::vector<int>& probes) const; // O(m log n) - shared path prefixes are visited once
     std::vector<int> rangeQuery(int x, int y) const; // O(k + log n) - k is the number of elements in the range
+    // replaces the contents with a perfectly balanced tree, sortedKeys must be strictly ascending
+    void loadSorted(const std::vector<int>& sortedKeys); // O(n)
+    // freezes the keys into a TreeSnapshot file, query it with TreeSnapshot::open(path)
+    void save(const std::string& path) const; // O(n)
     void printRange(int x, int y) const;
+    // heap bytes held by the nodes as requested from the allocator, whose overhead is not included
+    size_t memoryUsage() const; // O(n)
+    size_t peakScratchBytes() const; // O(1) - largest temporary buffer one join or loadSorted allocated
+    TreeStats getStats() const; // all zero unless built with HEAPURI_TREE_STATS
+    void resetStats();
 };
 
 #endif
@@ -0,0 +1,71 @@
+#ifndef BASELINES_H
+#define BASELINES_H
+
+#include <optional>
+#include <set>
+#include <vector>
+#include "stats.h"
+
+// reference engines with the ordered-set API of AVLTree and ScapegoatTree, so that the
+// benchmarks can show whether the custom trees beat what the standard library already gives;
+// neither is instrumented, getStats() is always zero
+
+// std::set, a red-black tree in every mainstream standard library
+class StdSetTree {
+private:
+    std::set<int> keys;
+    size_t scratchPeak; // bytes of the largest temporary buffer one join or loadSorted held
+
+public:
+    StdSetTree();
+
+    void insert(int key); // O(log n)
+    void remove(int key); // O(log n)
+    bool search(int key) const; // O(log n)
+    bool isEmpty() const; // O(1)
+    StdSetTree join(const StdSetTree& other); // O(n + m)
+    int floor(int key) const; // O(log n)
+    int ceiling(int key) const; // O(log n)
+    // non-throwing variants - an empty optional means no such key exists
+    std::optional<int> tryFloor(int key) const; // O(log n)
+    std::optional<int> tryCeiling(int key) const; // O(log n)
+    std::vector<int> rangeQuery(int x, int y) const; // O(k + log n) - k is the number of elements in the range
+    // replaces the contents, sortedKeys must be strictly ascending
+    void loadSorted(const std::vector<int>& sortedKeys); // O(n)
+    // heap bytes of the nodes, estimated from the usual node layout (colour, three links, key)
+    size_t memoryUsage() const; // O(1)
+    size_t peakScratchBytes() const; // O(1) - largest temporary buffer one join or loadSorted allocated
+    TreeStats getStats() const; // always zero
+    void resetStats();
+};
+
+// sorted std::vector searched with binary search - the fastest lookups and the most compact
+// layout, paid for with O(n) inserts and removes
+class SortedVectorTree {
+private:
+    std::vector<int> keys;
+    size_t scratchPeak; // bytes of the largest temporary buffer one join held
+
+public:
+    SortedVectorTree();
+
+    void insert(int key); // O(n) - O(log n) search plus the shift of the larger keys
+    void remove(int key); // O(n) - O(log n) search plus the shift of the larger keys
+    bool search(int key) const; // O(log n)
+    bool isEmpty() const; // O(1)
+    SortedVectorTree join(const SortedVectorTree& other); // O(n + m)
+    int floor(int key) const; // O(log n)
+    int ceiling(int key) const; // O(log n)
+    // non-throwing variants - an empty optional means no such key exists
+    std::optional<int> tryFloor(int key) const; // O(log n)
+    std::optional<int> tryCeiling(int key) const; // O(log n)
+    std::vector<int> rangeQuery(int x, int y) const; // O(k + log n) - k is the number of elements in the range
+    // replaces the contents, sortedKeys must be strictly ascending
+    void loadSorted(const std::vector<int>& sortedKeys); // O(n)
+    size_t memoryUsage() const; // O(1) - the vector's capacity
+    size_t peakScratchBytes() const; // O(1) - largest temporary buffer one join allocated
+    TreeStats getStats() const; // always zero
+    void resetStats();
+};
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef CONCURRENT_H
+#define CONCURRENT_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "ordered_set.h"
+
+// wrappers that let several threads share one tree engine, each is a mutable ordered set
+// (ordered_set.h) over any engine that is one. lookups of AVLTree and ScapegoatTree only read the tree, except when they
+// are counted (HEAPURI_TREE_STATS, or scapegoat adaptive alpha) - then only MutexTree is safe.
+// the wrappers with shared locks reject engines whose lookups always write (SplayTree) and, in
+// a HEAPURI_TREE_STATS build, every instrumented engine; adaptive alpha is a runtime switch
+// and is not caught, leave it off for trees shared under them
+
+// one global lock around every operation
+template <typename Tree>
+class MutexTree {
+private:
+    mutable std::mutex lock;
+    Tree tree;
+
+public:
+    template <typename... TreeArgs>
+    explicit MutexTree(TreeArgs&&... treeArgs) : tree(std::forward<TreeArgs>(treeArgs)...) {}
+
+    void insert(int key) { // O(log n) + lock
+        std::lock_guard<std::mutex> guard(lock);
+        tree.insert(key);
+    }
+
+    void remove(int key) { // O(log n) + lock
+        std::lock_guard<std::mutex> guard(lock);
+        tree.remove(key);
+    }
+
+    bool search(int key) const { // O(log n) + lock
+        std::lock_guard<std::mutex> guard(lock);
+        return tree.search(key);
+    }
+
+    bool isEmpty() const { // O(1) + lock
+        std::lock_guard<std::mutex> guard(lock);
+        return tree.isEmpty();
+    }
+
+    int floor(int key) const { // O(log n) + lock
+        std::lock_guard<std::mutex> guard(lock);
+        return tree.floor(key);
+    }
+
+    int ceiling(int key) const { // O(log n) + lock
+        std::lock_guard<std::mutex> guard(lock);
+        return tree.ceiling(key);
+    }
+
+    std::optional<int> tryFloor(int key) const { // O(log n) + lock
+        std::lock_guard<std::mutex> guard(lock);
+        return tree.tryFloor(key);
+    }
+
+    std::optional<int> tryCeiling(int key) const { // O(log n) + lock
+        std::lock_guard<std::mutex> guard(lock);
+        return tree.tryCeiling(key);
+    }
+
+    std::vector<int> rangeQuery(int x, int y) const { // O(k + log n) + lock
+        std::lock_guard<std::mutex> guard(lock);
+        return tree.rangeQuery(x, y);
+    }
+};
+
+// readers share the lock, writers take it exclusively
+template <typename Tree>
+class SharedMutexTree {
+private:
+    static_assert(!hasMutatingLookups<Tree>, "lookups of this engine write to the tree, use MutexTree");
+    static_assert(!hasCountedLookups<Tree>, "lookups of this engine are counted (HEAPURI_TREE_STATS), use MutexTree");
+
+    mutable std::shared_mutex lock;
+    Tree tree;
+
+public:
+    template <typename... TreeArgs>
+    explicit SharedMutexTree(TreeArgs&&... treeArgs) : tree(std::forward<TreeArgs>(treeArgs)...) {}
+
+    void insert(int key) { // O(log n) + exclusive lock
+        std::unique_lock<std::shared_mutex> guard(lock);
+        tree.insert(key);
+    }
+
+    void remove(int key) { // O(log n) + exclusive lock
+        std::unique_lock<std::shared_mutex> guard(lock);
+        tree.remove(key);
+    }
+
+    bool search(int key) const { // O(log n) + shared lock
+        std::shared_lock<std::shared_mutex> guard(lock);
+        return tree.search(key);
+    }
+
+    bool isEmpty() const { // O(1) + shared lock
+        std::shared_lock<std::shared_mutex> guard(lock);
+        return tree.isEmpty();
+    }
+
+    int floor(int key) const { // O(log n) + shared lock
+        std::shared_lock<std::shared_mutex> guard(lock);
+        return tree.floor(key);
+    }
+
+    int ceiling(int key) const { // O(log n) + shared lock
+        std::shared_lock<std::shared_mutex> guard(lock);
+        return tree.ceiling(key);
+    }
+
+    std::optional<int> tryFloor(int key) const { // O(log n) + shared lock
+        std::shared_lock<std::shared_mutex> guard(lock);
+        return tree.tryFloor(key);
+    }
+
+    std::optional<int> tryCeiling(int key) const { // O(log n) + shared lock
+        std::shared_lock<std::shared_mutex> guard(lock);
+        return tree.tryCeiling(key);
+    }
+
+    std::vector<int> rangeQuery(int x, int y) const { // O(k + log n) + shared lock
+        std::shared_lock<std::shared_mutex> guard(lock);
+        return tree.rangeQuery(x, y);
+    }
+};
+
+// keys are hashed onto Shards independent trees, each behind its own shared_mutex, so
+// updates to different shards never wait for each other; range, floor and ceiling queries
+// visit every shard in turn and are not atomic across them
+template <typename Tree, size_t Shards = 16>
+class ShardedTree {
+private:
+    static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0, "shard count must be a power of two");
+    static_assert(!hasMutatingLookups<Tree>, "lookups of this engine write to the tree, use MutexTree");
+    static_assert(!hasCountedLookups<Tree>, "lookups of this engine are counted (HEAPURI_TREE_STATS), use MutexTree");
+
+    // a cache line per shard, so that locking one shard does not invalidate its neighbours
+    struct alignas(64) Shard {
+        mutable std::shared_mutex lock;
+        Tree tree;
+    };
+    std::array<Shard, Shards> shards;
+
+    // fibonacci hashing, the top bits spread neighbouring keys over all shards
+    Shard& shardOf(int key) { return shards[shardIndex(key)]; }
+    const Shard& shardOf(int key) const { return shards[shardIndex(key)]; }
+    static size_t shardIndex(int key) {
+        return Shards == 1 ? 0 : (static_cast<uint32_t>(key) * 2654435769u) >> (32 - __builtin_ctzll(Shards));
+    }
+
+public:
+    void insert(int key) { // O(log n) + exclusive lock on one shard
+        Shard& shard = shardOf(key);
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        shard.tree.insert(key);
+    }
+
+    void remove(int key) { // O(log n) + exclusive lock on one shard
+        Shard& shard = shardOf(key);
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        shard.tree.remove(key);
+    }
+
+    bool search(int key) const { // O(log n) + shared lock on one shard
+        const Shard& shard = shardOf(key);
+        std::shared_lock<std::shared_mutex> guard(shard.lock);
+        return shard.tree.search(key);
+    }
+
+    bool isEmpty() const { // O(Shards)
+        for (const Shard& shard : shards) {
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            if (!shard.tree.isEmpty()) return false;
+        }
+        return true;
+    }
+
+    // keys are spread by hash, so the answer is the best of every shard's answer
+    int floor(int key) const { // O(Shards * log n)
+        std::optional<int> result = tryFloor(key);
+        if (!result) {
+            throw std::runtime_error("No floor value exists");
+        }
+        return *result;
+    }
+
+    int ceiling(int key) const { // O(Shards * log n)
+        std::optional<int> result = tryCeiling(key);
+        if (!result) {
+            throw std::runtime_error("No ceiling value exists");
+        }
+        return *result;
+    }
+
+    std::optional<int> tryFloor(int key) const { // O(Shards * log n)
+        std::optional<int> best;
+        for (const Shard& shard : shards) {
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            std::optional<int> candidate = shard.tree.tryFloor(key);
+            if (candidate && (!best || *candidate > *best)) best = candidate;
+        }
+        return best;
+    }
+
+    std::optional<int> tryCeiling(int key) const { // O(Shards * log n)
+        std::optional<int> best;
+        for (const Shard& shard : shards) {
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            std::optional<int> candidate = shard.tree.tryCeiling(key);
+            if (candidate && (!best || *candidate < *best)) best = candidate;
+        }
+        return best;
+    }
+
+    std::vector<int> rangeQuery(int x, int y) const { // O(k log k + Shards * log n)
+        std::vector<int> result;
+        for (const Shard& shard : shards) {
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            std::vector<int> part = shard.tree.rangeQuery(x, y);
+            result.insert(result.end(), part.begin(), part.end());
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+
+#endif
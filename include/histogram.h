@@ -0,0 +1,79 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// HDR-style latency histogram: values are bucketed by power of two, each power of two
+// split into SUB_BUCKETS linear sub-buckets, so every recorded value keeps ~3% precision
+// from 1 ns up to 2^64 ns with a fixed 15 KB footprint
+class LatencyHistogram {
+private:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t maxValue;
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) return value;
+        int shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+    }
+
+    // largest value that maps to bucket i
+    static uint64_t bucketUpperBound(size_t i) {
+        if (i < SUB_BUCKETS) return i;
+        int shift = static_cast<int>(i / SUB_BUCKETS) - 1;
+        uint64_t sub = i % SUB_BUCKETS + SUB_BUCKETS;
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram() : counts(BUCKET_COUNT, 0), total(0), maxValue(0) {}
+
+    void record(uint64_t value) { // O(1)
+        counts[bucketIndex(value)]++;
+        total++;
+        maxValue = std::max(maxValue, value);
+    }
+
+    void merge(const LatencyHistogram& other) { // O(BUCKET_COUNT)
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return maxValue; }
+
+    // smallest recorded value v such that at least p percent of samples are <= v
+    uint64_t percentile(double p) const { // O(BUCKET_COUNT)
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * total + 0.5);
+        rank = std::max<uint64_t>(1, std::min(rank, total));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(bucketUpperBound(i), maxValue);
+        }
+        return maxValue;
+    }
+
+    // number of samples strictly above value (at bucket precision)
+    uint64_t countAbove(uint64_t value) const { // O(BUCKET_COUNT)
+        uint64_t above = 0;
+        for (size_t i = bucketIndex(value) + 1; i < BUCKET_COUNT; ++i) {
+            above += counts[i];
+        }
+        return above;
+    }
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef ORDERED_SET_H
+#define ORDERED_SET_H
+
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// compile-time interface shared by the tree engines, so that code written once as a template
+// (benchmarks, trace replay, wrappers) can be instantiated for any of them with no virtual
+// call on the hot path. C++17 has no concepts, these are detection traits meant for
+// static_assert: a missing or mistyped operation fails at the assertion, not deep inside
+// an instantiation
+
+// read side: search, floor and ceiling (throwing and std::optional), rangeQuery, isEmpty,
+// all on a const tree - TreeSnapshot qualifies
+template <typename T, typename = void>
+struct IsOrderedSetView : std::false_type {};
+
+template <typename T>
+struct IsOrderedSetView<T, std::enable_if_t<
+    std::is_same_v<decltype(std::declval<const T&>().search(0)), bool> &&
+    std::is_same_v<decltype(std::declval<const T&>().isEmpty()), bool> &&
+    std::is_same_v<decltype(std::declval<const T&>().floor(0)), int> &&
+    std::is_same_v<decltype(std::declval<const T&>().ceiling(0)), int> &&
+    std::is_same_v<decltype(std::declval<const T&>().tryFloor(0)), std::optional<int>> &&
+    std::is_same_v<decltype(std::declval<const T&>().tryCeiling(0)), std::optional<int>> &&
+    std::is_same_v<decltype(std::declval<const T&>().rangeQuery(0, 0)), std::vector<int>>>>
+    : std::true_type {};
+
+// a view that also takes insert and remove - the concurrent wrappers qualify
+template <typename T, typename = void>
+struct IsMutableOrderedSet : std::false_type {};
+
+template <typename T>
+struct IsMutableOrderedSet<T, std::enable_if_t<IsOrderedSetView<T>::value,
+    std::void_t<decltype(std::declval<T&>().insert(0)), decltype(std::declval<T&>().remove(0))>>>
+    : std::true_type {};
+
+// a full engine: mutable, default constructible, movable, and join returns a new tree of the
+// same engine holding the keys of both
+template <typename T, typename = void>
+struct IsOrderedSet : std::false_type {};
+
+template <typename T>
+struct IsOrderedSet<T, std::enable_if_t<
+    IsMutableOrderedSet<T>::value && std::is_default_constructible_v<T> && std::is_move_constructible_v<T> &&
+    std::is_same_v<decltype(std::declval<T&>().join(std::declval<const T&>())), T>>>
+    : std::true_type {};
+
+template <typename T>
+constexpr bool isOrderedSetView = IsOrderedSetView<T>::value;
+template <typename T>
+constexpr bool isMutableOrderedSet = IsMutableOrderedSet<T>::value;
+template <typename T>
+constexpr bool isOrderedSet = IsOrderedSet<T>::value;
+
+// optional capabilities, benchmarks of them are only registered for engines that have them
+
+// searchBatch(keys, count, found): interleaved lookups
+template <typename T, typename = void>
+struct HasSearchBatch : std::false_type {};
+
+template <typename T>
+struct HasSearchBatch<T, std::void_t<decltype(std::declval<const T&>().searchBatch(
+    std::declval<const int*>(), size_t(0), std::declval<bool*>()))>> : std::true_type {};
+
+// floorBatch(probes) / ceilingBatch(probes): one merged traversal for sorted probes
+template <typename T, typename = void>
+struct HasFloorBatch : std::false_type {};
+
+template <typename T>
+struct HasFloorBatch<T, std::enable_if_t<
+    std::is_same_v<decltype(std::declval<const T&>().floorBatch(std::declval<const std::vector<int>&>())),
+                   std::vector<std::optional<int>>> &&
+    std::is_same_v<decltype(std::declval<const T&>().ceilingBatch(std::declval<const std::vector<int>&>())),
+                   std::vector<std::optional<int>>>>>
+    : std::true_type {};
+
+// split(key) / merge(other): a key range is moved out of the tree and back by relinking nodes
+template <typename T, typename = void>
+struct HasSplitMerge : std::false_type {};
+
+template <typename T>
+struct HasSplitMerge<T, std::enable_if_t<
+    std::is_same_v<decltype(std::declval<T&>().split(0)), T> &&
+    std::is_void_v<decltype(std::declval<T&>().merge(std::declval<T&>()))>>>
+    : std::true_type {};
+
+// MUTATING_LOOKUPS = true: const lookups restructure the tree (a splay tree moves every key it
+// reaches to the root), so readers must not share the tree under a shared lock
+template <typename T, typename = void>
+struct HasMutatingLookups : std::false_type {};
+
+template <typename T>
+struct HasMutatingLookups<T, std::enable_if_t<T::MUTATING_LOOKUPS>> : std::true_type {};
+
+// built with HEAPURI_TREE_STATS, every engine with getStats() counts its lookups into mutable
+// TreeStats, so a const lookup writes to the tree just the same. the baselines are caught too,
+// their counters stay zero but nothing marks them apart
+template <typename T, typename = void>
+struct HasCountedLookups : std::false_type {};
+
+#ifdef HEAPURI_TREE_STATS
+template <typename T>
+struct HasCountedLookups<T, std::void_t<decltype(std::declval<const T&>().getStats())>> : std::true_type {};
+#endif
+
+template <typename T>
+constexpr bool hasSearchBatch = HasSearchBatch<T>::value;
+template <typename T>
+constexpr bool hasFloorBatch = HasFloorBatch<T>::value;
+template <typename T>
+constexpr bool hasSplitMerge = HasSplitMerge<T>::value;
+template <typename T>
+constexpr bool hasMutatingLookups = HasMutatingLookups<T>::value;
+template <typename T>
+constexpr bool hasCountedLookups = HasCountedLookups<T>::value;
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+
+enum PerfEvent {
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,  // last-level cache misses
+    PERF_BRANCH_MISSES,
+    PERF_DTLB_MISSES,   // data TLB load misses
+    PERF_EVENT_COUNT
+};
+
+// hardware counters of the calling thread through Linux perf_event_open, user space only;
+// each event is opened on its own, so an event the kernel or CPU does not offer (virtual
+// machines often offer none, perf_event_paranoid may forbid all) is skipped and reads as zero
+class PerfCounters {
+private:
+    std::array<int, PERF_EVENT_COUNT> fds;
+
+public:
+    PerfCounters(); // opens every event stopped
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters();
+
+    bool available(PerfEvent event) const { return fds[event] >= 0; }
+    bool anyAvailable() const; // O(1)
+    void start(); // O(1) - counts accumulate over every start/stop period
+    void stop(); // O(1)
+    // count so far, scaled up when the kernel multiplexed the event with others
+    uint64_t count(PerfEvent event) const; // O(1)
+    static const char* name(PerfEvent event);
+};
+
+#endif
@@ -2,27 +2,124 @@
 #define SCAPEGOAT_H
 
 #include <algorithm>
+#include <array>
 #include <iostream>
+#include <limits>
 #include <cmath>
+#include <optional>
+#include <string>
+#include <ratio>
+#include <utility>
 #include <vector>
+#include "stats.h"
+
+// depth d exceeds the scapegoat height bound log_{1/alpha}(size) exactly when
+// size < ceil((1/alpha)^d), so the bound is a table lookup instead of two logarithms;
+// the table ends once (1/alpha)^d no longer fits in an int (any deeper node violates)
+constexpr int depthThresholdCount(long long num, long long den) {
+    int count = 0;
+    long double power = 1.0L;
+    while (power <= std::numeric_limits<int>::max()) {
+        count++;
+        power = power * den / num;
+    }
+    return count;
+}
+
+template <int Count>
+constexpr std::array<int, Count> buildDepthThresholds(long long num, long long den) {
+    std::array<int, Count> thresholds{};
+    long double power = 1.0L;
+    for (int d = 0; d < Count; ++d) {
+        int floorPower = static_cast<int>(power);
+        thresholds[d] = (floorPower == power) ? floorPower : floorPower + 1;
+        power = power * den / num;
+    }
+    return thresholds;
+}
 
 struct SGNode {
     int key;
+    int live; // nodes in this subtree not marked dead, fits in the padding after key
     SGNode *left;
     SGNode *right;
+    int size; // nodes in this subtree
+    bool dead; // tombstone left by a lazy remove, fits in the padding after size
 
-    SGNode(int k) : key(k), left(nullptr), right(nullptr) {}
+    SGNode(int k) : key(k), live(1), left(nullptr), right(nullptr), size(1), dead(false) {}
 };
 
 class ScapegoatTree {
 private:
+    static constexpr size_t SEARCH_BATCH_WIDTH = 16; // lookups advanced in lockstep by searchBatch
+    static constexpr int SYNC_REBUILD_FACTOR = 4;    // incremental mode: per-update work budget is this * log2(size)
+    static constexpr long long NO_LOWER_BOUND = std::numeric_limits<int>::min() - 1LL;
+    static constexpr long long NO_UPPER_BOUND = std::numeric_limits<int>::max() + 1LL;
+    static constexpr double ADAPTIVE_ALPHA_MIN = 0.55;  // adaptive mode: tightest alpha, updates that rarely rebuild
+    static constexpr double ADAPTIVE_ALPHA_MAX = 0.9;   // adaptive mode: loosest alpha, write bursts
+    static constexpr double ADAPTIVE_ALPHA_STEP = 0.05; // adaptive mode: alpha moves on this grid
+    static constexpr long long TUNING_WINDOW = 1024;    // adaptive mode: fewest operations observed per alpha decision
+    static constexpr long long READ_HEAVY_RATIO = 16;   // adaptive mode: lookups per update that make a window read-heavy
+    static constexpr long long LOOKUP_SAMPLE = 16;      // adaptive mode: one search in this many has its descent measured
+#ifdef HEAPURI_TREE_STATS
+    mutable TreeStats stats; // mutable so that const lookups are counted too
+#endif
+
     SGNode *root;
-    int size;           // current size of the tree
+    int size;           // current size of the tree (live keys)
     int maxSize;        // maximum size since last rebuild
     double alpha;       // balance factor (typically between 0.5 and 1)
+    long long rebuilds; // subtree rebuilds since construction
+    size_t scratchPeak; // bytes of the largest temporary node buffer one rebuild, join or loadSorted held
+    std::vector<int> ownedDepthThresholds; // depth bound table when alpha is only known at runtime
+    const int *depthThresholds;            // see depthThresholdCount
+    int depthThresholdsSize;
+
+    // incremental rebuild state - a shadow copy of the scapegoat subtree covering keys in
+    // (rebuildLow, rebuildHigh) is built a few steps per update while the live tree keeps
+    // serving, updates to the range are logged and replayed, then the shadow is swapped in
+    enum RebuildPhase { REBUILD_IDLE, REBUILD_COLLECT, REBUILD_BUILD, REBUILD_REPLAY };
+    struct BuildRange {
+        int start;
+        int end;
+        SGNode **link;  // where the node built for this range is attached
+    };
+    bool incremental;
+    RebuildPhase phase;
+    long long rebuildLow;
+    long long rebuildHigh;
+    std::vector<int> shadowKeys;                  // keys collected from the live tree in order
+    long long collectCursor;                      // last live-tree key the collect pass went past
+    std::vector<BuildRange> buildStack;           // shadow ranges still to build
+    SGNode *shadowRoot;
+    std::vector<std::pair<int, bool>> pendingOps; // (key, inserted) updates the shadow has not seen yet
+    size_t pendingIndex;
+    std::vector<SGNode*> reclaimStack;            // nodes of the retired tree still to free
+    long long rebuildWorkLeft;                    // estimated steps (nodes to collect and build, updates to replay)
+    int deepInsertsLeft;                          // too-deep inserts left before the rebuild must be finished
+
+    // lazy delete state - removed keys stay linked as tombstones until a rebuild drops them
+    bool lazyDelete;
+    int deadCount; // tombstones still in the tree
+
+    // adaptive alpha state - the operation mix and rebuild work seen since the last decision
+    bool adaptive;
+    mutable long long windowReads; // mutable so that const lookups are counted too
+    long long windowWrites;
+    long long windowNodesRebuilt;
+    int deepestInsert;             // upper bound on the tree height since the last full rebuild
+    long long windowInserts;
+    long long windowInsertDepth;   // nodes visited by the window's insert descents
+    mutable long long windowLookups;     // searches sampled, one in LOOKUP_SAMPLE
+    mutable long long windowLookupDepth; // nodes visited by the sampled searches
+    long long readsSinceFullRebuild;
+    bool rebuildFinished;          // set by a completed rebuild, the point at which alpha may move
 
     // Helper functions
     int sizeOf(SGNode *node);
+    int liveOf(SGNode *node) const;
+    bool exceedsDepthBound(int depth) const;
+    void updateSize(SGNode *node);
     bool isAlphaWeightBalanced(SGNode *node, double alpha);
     SGNode* findScapegoat(SGNode *node, int key);
     SGNode* insertRecursive(SGNode *node, int key);
@@ -32,25 +129,118 @@ private:
     SGNode* rebuildTree(const std::vector<SGNode*> &nodes, int start, int end);
     SGNode* rebuildSubtree(SGNode *scapegoat);
     void destroyRecursive(SGNode *node);
+    void releaseNodes();
+    static size_t countNodes(const SGNode *node);
     SGNode* findMin(SGNode* node) const;
     SGNode* findMax(SGNode* node) const;
     SGNode* floorRecursive(SGNode* node, int key) const;
     SGNode* ceilingRecursive(SGNode* node, int key) const;
     void rangeQueryRecursive(SGNode* node, int x, int y, std::vector<int>& result) const;
+    int syncRebuildLimit() const;
+    SGNode** findScapegoatLink(SGNode *&subtreeRoot, int key, long long &low, long long &high);
+    SGNode** findDeleteScapegoatLink(int key, long long &low, long long &high);
+    void startIncrementalRebuild(long long low, long long high, int nodes);
+    void abortIncrementalRebuild();
+    void recordUpdate(int key, bool inserted);
+    void collectStep(int &budget);
+    void buildStep(int &budget);
+    void replayStep(int &budget);
+    void advanceRebuild(bool deepInsert);
+    void shadowInsert(int key);
+    void shadowRemove(int key);
+    void setAlpha(double a);
+    void noteReads(long long count) const;
+    void noteWrite();
+    void tuneAlpha();
+    static int balancedHeight(int nodes);
+    static double balancedLookupDepth(int nodes);
+    bool markDead(int key);
+    void purgeTombstones();
+    void floorBatchRecursive(SGNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                             const SGNode* best, std::vector<std::optional<int>>& result) const;
+    void ceilingBatchRecursive(SGNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                               const SGNode* best, std::vector<std::optional<int>>& result) const;
+
+protected:
+    // used by StaticScapegoatTree, thresholds must outlive the tree
+    ScapegoatTree(double a, bool incremental, const int *thresholds, int thresholdCount);
 
 public:
-    ScapegoatTree(double a = 0.7); // alpha default value is 0.7
+    static constexpr int REBUILD_DEPTH_SLACK = 8; // incremental mode: too-deep inserts an in-flight rebuild may span
+
+    // incremental = true spreads a rebuild of k nodes over later updates: each one advances it
+    // by O(log n) steps, and an insert deeper than the height bound, which the rebuild must
+    // outrun, advances it by k / REBUILD_DEPTH_SLACK. no scapegoat is searched for while one is
+    // in flight, so the height stays within about REBUILD_DEPTH_SLACK levels of
+    // log_{1/alpha}(size) (the rebuilt subtree is held twice while in flight)
+    ScapegoatTree(double a = 0.7, bool incremental = false); // alpha default value is 0.7
     ~ScapegoatTree();
+    // moves every node, an in-flight incremental rebuild included, and leaves other empty;
+    // the runtime depth bound table is copied so that other stays usable
+    ScapegoatTree(ScapegoatTree&& other);
+    ScapegoatTree& operator=(ScapegoatTree&& other);
+    ScapegoatTree(const ScapegoatTree&) = delete;
+    ScapegoatTree& operator=(const ScapegoatTree&) = delete;
 
     void insert(int key); // O(log n) amortized
-    void remove(int key); // O(log n) amortized
+    void remove(int key); // O(log n) amortized - rebalancing rebuilds only the highest unbalanced subtree on the path
     bool search(int key) const; // O(log n)
+    // interleaved lookups - found[i] is set to search(keys[i]), child nodes are prefetched
+    // so that up to SEARCH_BATCH_WIDTH cache misses are in flight at once
+    void searchBatch(const int* keys, size_t count, bool* found) const; // O(count * log n)
     bool isEmpty() const; // O(1)
     ScapegoatTree join(const ScapegoatTree& other); // O(n + m)
     int floor(int key) const; // O(log n)
     int ceiling(int key) const; // O(log n)
+    // non-throwing variants - an empty optional means no such key exists
+    std::optional<int> tryFloor(int key) const; // O(log n)
+    std::optional<int> tryCeiling(int key) const; // O(log n)
+    std::optional<int> predecessor(int key) const; // O(log n) - largest key strictly less than key
+    std::optional<int> successor(int key) const; // O(log n) - smallest key strictly greater than key
+    // batched variants - probes must be sorted ascending, answered in one traversal of the tree
+    std::vector<std::optional<int>> floorBatch(const std::vector<int>& probes) const; // O(m log n) - shared path prefixes are visited once
+    std::vector<std::optional<int>> ceilingBatch(const std::vector<int>& probes) const; // O(m log n) - shared path prefixes are visited once
     std::vector<int> rangeQuery(int x, int y) const; // O(k + log n) - k is the number of elements in the range
+    // replaces the contents with a perfectly balanced tree, sortedKeys must be strictly ascending
+    void loadSorted(const std::vector<int>& sortedKeys); // O(n)
+    // freezes the keys into a TreeSnapshot file, query it with TreeSnapshot::open(path)
+    void save(const std::string& path) const; // O(n)
     void printRange(int x, int y) const;
+    long long getRebuildCount() const; // O(1)
+    // heap bytes held by the nodes (tombstones, an in-flight shadow and retired nodes not yet
+    // freed included) and the incremental rebuild buffers, as requested from the allocator,
+    // whose overhead is not included
+    size_t memoryUsage() const; // O(1), O(k) while an incremental rebuild of k nodes is in flight
+    size_t peakScratchBytes() const; // O(1) - largest temporary buffer one rebuild, join or loadSorted allocated
+    bool isRebuilding() const; // O(1) - an incremental rebuild is in flight
+    // adaptive alpha - at rebuild boundaries, once TUNING_WINDOW operations have passed since the
+    // last decision, alpha is moved within [0.55, 0.9] by the updates' descents against their
+    // rebuild work, looser when rebuilds dominate; a window of mostly lookups instead schedules a
+    // full rebuild, run by its next update once the lookups' excess depth outweighs it. lookups
+    // update the window counters, so concurrent readers need exclusive access
+    void setAdaptiveAlpha(bool enabled); // O(1)
+    // lazy delete - remove only marks the key dead, lookups skip dead keys, and once more than
+    // (1 - alpha) of the nodes are dead a single rebuild purges them all
+    void setLazyDelete(bool enabled); // O(1), O(n) when disabling purges remaining tombstones
+    double getAlpha() const; // O(1)
+    TreeStats getStats() const; // all zero unless built with HEAPURI_TREE_STATS
+    void resetStats();
+};
+
+// scapegoat tree with alpha fixed at compile time, e.g. StaticScapegoatTree<std::ratio<7, 10>>;
+// the depth bound table is computed by the compiler and shared by every tree of the same alpha
+template <typename Alpha>
+class StaticScapegoatTree : public ScapegoatTree {
+private:
+    static_assert(2 * Alpha::num > Alpha::den && Alpha::num < Alpha::den, "alpha must be in (0.5, 1)");
+    static constexpr int THRESHOLD_COUNT = depthThresholdCount(Alpha::num, Alpha::den);
+    static constexpr std::array<int, THRESHOLD_COUNT> THRESHOLDS =
+        buildDepthThresholds<THRESHOLD_COUNT>(Alpha::num, Alpha::den);
+
+public:
+    StaticScapegoatTree(bool incremental = false)
+        : ScapegoatTree(static_cast<double>(Alpha::num) / Alpha::den, incremental,
+                        THRESHOLDS.data(), THRESHOLD_COUNT) {}
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// order of the key array, both are implicit balanced search trees
+enum SnapshotLayout : uint32_t {
+    SNAPSHOT_EYTZINGER = 1, // breadth-first, written by save()
+    SNAPSHOT_SORTED = 2     // ascending, written by the streaming bulk build
+};
+
+// on-disk header of a frozen tree, followed at keysOffset by the keys as native int32,
+// 1-indexed so slot 0 is an unused pad
+struct SnapshotHeader {
+    char magic[8];        // "HEAPURI\0"
+    uint32_t version;     // SNAPSHOT_VERSION of the writer
+    uint32_t keyBytes;    // sizeof(int) of the writer, rejected on mismatch
+    uint32_t layout;      // SnapshotLayout
+    uint32_t reserved;
+    uint64_t keyCount;
+    uint64_t checksum;    // FNV-1a over the key array, checked by verifyChecksum()
+    uint64_t keysOffset;  // byte offset of slot 0, cache line aligned
+};
+
+// what a streaming bulk build did, see TreeSnapshot::buildFromKeyFile
+struct BulkBuildStats {
+    uint64_t keysRead = 0;
+    uint64_t keysWritten = 0; // after dropping duplicates
+    size_t runs = 0;          // sorted runs spilled by the first pass
+    int mergePasses = 0;      // passes over the data after run formation
+};
+
+// read-only view of a saved tree - the file is mmap'ed and queried in place, so opening
+// costs one page fault per touched page instead of a re-insert of every key
+class TreeSnapshot {
+private:
+    static constexpr uint32_t SNAPSHOT_VERSION = 2;
+    static constexpr size_t KEYS_ALIGNMENT = 64;
+    static constexpr uint64_t FNV_OFFSET = 1469598103934665603ull;
+
+    void* mapping;
+    size_t mappingBytes;
+    const int* keys; // keys[1..count] in layout order
+    size_t count;
+    uint32_t layout;
+
+    TreeSnapshot(void* mapping, size_t mappingBytes, const int* keys, size_t count, uint32_t layout);
+    size_t lowerBoundSlot(int key) const; // first slot >= key, 0 if none
+    size_t floorSlot(int key) const; // last slot <= key, 0 if none
+    size_t nextSlot(size_t slot) const; // in-order successor slot, 0 past the end
+    // FNV-1a over count keys starting at keys, hash chains partial checksums
+    static uint64_t checksumOf(const int* keys, size_t count, uint64_t hash = FNV_OFFSET);
+    static SnapshotHeader makeHeader(uint32_t layout, uint64_t keyCount, uint64_t checksum);
+
+public:
+    TreeSnapshot(TreeSnapshot&& other) noexcept;
+    TreeSnapshot& operator=(TreeSnapshot&& other) noexcept;
+    TreeSnapshot(const TreeSnapshot&) = delete;
+    TreeSnapshot& operator=(const TreeSnapshot&) = delete;
+    ~TreeSnapshot();
+
+    // sortedKeys must be strictly ascending, throws std::runtime_error on I/O failure
+    static void write(const std::string& path, const std::vector<int>& sortedKeys); // O(n)
+    // maps the file without reading the keys, throws std::runtime_error on a bad header
+    static TreeSnapshot open(const std::string& path); // O(1)
+    // external merge sort of a file of native int32 keys into a SNAPSHOT_SORTED file using at
+    // most memoryBytes of buffers (raised to 128 KB if smaller), all key I/O is sequential,
+    // spilled runs are put next to outputPath and removed afterwards, duplicates are dropped,
+    // throws std::runtime_error on I/O failure
+    static BulkBuildStats buildFromKeyFile(const std::string& keyPath, const std::string& outputPath,
+                                           size_t memoryBytes); // O(n log n)
+
+    bool verifyChecksum() const; // O(n) - touches every page of the file
+    size_t size() const; // O(1)
+    bool isEmpty() const; // O(1)
+    bool search(int key) const; // O(log n)
+    int floor(int key) const; // O(log n)
+    int ceiling(int key) const; // O(log n)
+    // non-throwing variants - an empty optional means no such key exists
+    std::optional<int> tryFloor(int key) const; // O(log n)
+    std::optional<int> tryCeiling(int key) const; // O(log n)
+    std::vector<int> rangeQuery(int x, int y) const; // O(k + log n) - k is the number of elements in the range
+};
+
+#endif
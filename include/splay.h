@@ -0,0 +1,78 @@
+#ifndef SPLAY_H
+#define SPLAY_H
+
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+#include "stats.h"
+
+// no balance information at all, the node packs into 24 bytes like WAVLNode
+struct SplayNode {
+    int key;
+    SplayNode *left;
+    SplayNode *right;
+
+    SplayNode(int k) : key(k), left(nullptr), right(nullptr) {}
+};
+
+// top-down splay tree (Sleator, Tarjan, "Self-Adjusting Binary Search Trees"): every access
+// moves the key it reaches to the root, so recently and frequently used keys stay near the
+// top and a run of lookups over a narrow band, or in key order, costs far less than log n
+// each. bounds are amortized only: one operation can walk a path of n nodes (ascending
+// inserts build one), so nothing here recurses on the tree's height.
+// lookups restructure the tree through a mutable root. a const SplayTree is therefore not
+// safe to share between threads without a lock, SharedMutexTree and ShardedTree refuse it
+class SplayTree {
+private:
+#ifdef HEAPURI_TREE_STATS
+    mutable TreeStats stats; // mutable so that const lookups are counted too
+#endif
+
+    mutable SplayNode *root;
+    size_t count;
+    size_t scratchPeak; // bytes of the largest temporary buffer one join held
+
+    SplayNode* splay(SplayNode *node, int key) const;
+    void destroyTree(SplayNode *node);
+    void rangeQueryIterative(const SplayNode* node, int x, int y, std::vector<int>& result) const;
+    SplayNode* buildBalancedTree(const std::vector<int>& keys, int start, int end);
+
+public:
+    // lookups write to the tree, see HasMutatingLookups in ordered_set.h
+    static constexpr bool MUTATING_LOOKUPS = true;
+
+    SplayTree();
+    ~SplayTree();
+    SplayTree(SplayTree&& other) noexcept;
+    SplayTree& operator=(SplayTree&& other) noexcept;
+    SplayTree(const SplayTree&) = delete;
+    SplayTree& operator=(const SplayTree&) = delete;
+
+    void insert(int key); // O(log n) amortized - the new key becomes the root
+    void remove(int key); // O(log n) amortized
+    bool search(int key) const; // O(log n) amortized - the key, or the last node visited, becomes the root
+    bool isEmpty() const; // O(1)
+    SplayTree join(const SplayTree& other); // O(n + m) - merged keys are built into a balanced tree
+    int floor(int key) const; // O(log n) amortized
+    int ceiling(int key) const; // O(log n) amortized
+    // non-throwing variants - an empty optional means no such key exists
+    std::optional<int> tryFloor(int key) const; // O(log n) amortized
+    std::optional<int> tryCeiling(int key) const; // O(log n) amortized
+    std::optional<int> predecessor(int key) const; // O(log n) amortized - largest key strictly less than key
+    std::optional<int> successor(int key) const; // O(log n) amortized - smallest key strictly greater than key
+    std::vector<int> rangeQuery(int x, int y) const; // O(k + log n) amortized - k is the number of elements in the range
+    // replaces the contents with a perfectly balanced tree, sortedKeys must be strictly ascending
+    void loadSorted(const std::vector<int>& sortedKeys); // O(n)
+    // freezes the keys into a TreeSnapshot file, query it with TreeSnapshot::open(path)
+    void save(const std::string& path) const; // O(n)
+    void printRange(int x, int y) const;
+    // heap bytes held by the nodes as requested from the allocator, whose overhead is not included
+    size_t memoryUsage() const; // O(1)
+    size_t peakScratchBytes() const; // O(1) - largest temporary buffer one join allocated
+    TreeStats getStats() const; // all zero unless built with HEAPURI_TREE_STATS, zig-zig rotations use the LL/RR counters, maxDepth stays 0
+    void resetStats();
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <algorithm>
+
+// per-tree operation counters, only collected when built with HEAPURI_TREE_STATS
+// (cmake -DHEAPURI_TREE_STATS=ON), otherwise every counting site compiles away
+struct TreeStats {
+    long long comparisons = 0;   // key comparisons
+    long long nodesVisited = 0;  // nodes touched while descending
+    long long rotationsLL = 0;   // AVL single right rotations
+    long long rotationsLR = 0;   // AVL left-right double rotations
+    long long rotationsRR = 0;   // AVL single left rotations
+    long long rotationsRL = 0;   // AVL right-left double rotations
+    long long rebuilds = 0;      // scapegoat subtree rebuilds
+    long long nodesRebuilt = 0;  // total nodes relinked by rebuilds
+    int maxDepth = 0;            // deepest node reached by an insert (root is depth 1)
+
+    TreeStats& operator+=(const TreeStats& other) {
+        comparisons += other.comparisons;
+        nodesVisited += other.nodesVisited;
+        rotationsLL += other.rotationsLL;
+        rotationsLR += other.rotationsLR;
+        rotationsRR += other.rotationsRR;
+        rotationsRL += other.rotationsRL;
+        rebuilds += other.rebuilds;
+        nodesRebuilt += other.nodesRebuilt;
+        maxDepth = std::max(maxDepth, other.maxDepth);
+        return *this;
+    }
+};
+
+#ifdef HEAPURI_TREE_STATS
+#define TREE_STATS(expr) (expr)
+#else
+#define TREE_STATS(expr) ((void)0)
+#endif
+
+#endif
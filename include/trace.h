@@ -0,0 +1,119 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "histogram.h"
+#include "ordered_set.h"
+
+enum TraceOp : uint32_t {
+    TRACE_INSERT = 0,
+    TRACE_REMOVE = 1,
+    TRACE_SEARCH = 2,
+    TRACE_FLOOR = 3,   // tryFloor
+    TRACE_CEILING = 4, // tryCeiling
+    TRACE_RANGE = 5    // rangeQuery(key, rangeEnd)
+};
+
+// one recorded operation, stored as is in the trace file
+struct TraceRecord {
+    uint32_t op;      // TraceOp
+    int32_t key;
+    int32_t rangeEnd; // only read by TRACE_RANGE
+};
+
+// on-disk header, the records follow directly
+struct TraceHeader {
+    char magic[8];        // "HPTRACE\0"
+    uint32_t version;
+    uint32_t recordBytes; // sizeof(TraceRecord) of the writer, rejected on mismatch
+    uint64_t recordCount;
+};
+
+// read-only, mmap'ed operation trace - replays read the records straight from the page
+// cache, so a trace of captured traffic costs one validating pass and no parse or copy
+class OperationTrace {
+private:
+    static constexpr uint32_t TRACE_VERSION = 1;
+
+    void* mapping;
+    size_t mappingBytes;
+    const TraceRecord* records;
+    size_t count;
+
+    OperationTrace(void* mapping, size_t mappingBytes, const TraceRecord* records, size_t count);
+
+public:
+    OperationTrace(OperationTrace&& other) noexcept;
+    OperationTrace& operator=(OperationTrace&& other) noexcept;
+    OperationTrace(const OperationTrace&) = delete;
+    OperationTrace& operator=(const OperationTrace&) = delete;
+    ~OperationTrace();
+
+    // throws std::runtime_error on I/O failure
+    static void write(const std::string& path, const std::vector<TraceRecord>& records); // O(n)
+    // throws std::runtime_error on a bad header, a truncated file or an unknown op code
+    static OperationTrace open(const std::string& path); // O(n)
+
+    size_t size() const { return count; }
+    const TraceRecord* begin() const { return records; }
+    const TraceRecord* end() const { return records + count; }
+};
+
+struct ReplayResult {
+    uint64_t operations = 0;
+    double seconds = 0;        // wall time of the whole replay
+    uint64_t digest = 0;       // folds every result in, equal across engines for the same trace
+    LatencyHistogram latency;  // per operation, empty unless recorded
+};
+
+// drives any mutable ordered set through a trace, engines and concurrent wrappers alike;
+// per-operation timing adds two clock reads to every operation,
+// so throughput is best taken from a replay without it
+template <typename Tree>
+ReplayResult replayTrace(Tree& tree, const OperationTrace& trace, bool recordLatency) {
+    static_assert(isMutableOrderedSet<Tree>, "replayTrace needs a mutable ordered set");
+    ReplayResult result;
+    auto fold = [&result](uint64_t value) { result.digest = (result.digest ^ value) * 1099511628211ull; };
+    auto foldOptional = [&fold](const std::optional<int>& value) {
+        fold(value ? static_cast<uint32_t>(*value) : 0x100000000ull);
+    };
+
+    auto replayStart = std::chrono::steady_clock::now();
+    for (const TraceRecord& record : trace) {
+        auto start = recordLatency ? std::chrono::steady_clock::now() : replayStart;
+        switch (record.op) {
+            case TRACE_INSERT:
+                tree.insert(record.key);
+                break;
+            case TRACE_REMOVE:
+                tree.remove(record.key);
+                break;
+            case TRACE_SEARCH:
+                fold(tree.search(record.key));
+                break;
+            case TRACE_FLOOR:
+                foldOptional(tree.tryFloor(record.key));
+                break;
+            case TRACE_CEILING:
+                foldOptional(tree.tryCeiling(record.key));
+                break;
+            case TRACE_RANGE:
+                fold(tree.rangeQuery(record.key, record.rangeEnd).size());
+                break;
+        }
+        if (recordLatency) {
+            result.latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+    result.operations = trace.size();
+    return result;
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef TREAP_H
+#define TREAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+#include "stats.h"
+
+// priority next to key, so the node packs into 24 bytes like WAVLNode
+struct TreapNode {
+    int key;
+    uint32_t priority; // random, every node's priority is at least its children's
+    TreapNode *left;
+    TreapNode *right;
+
+    TreapNode(int k, uint32_t p) : key(k), priority(p), left(nullptr), right(nullptr) {}
+};
+
+// randomized treap (Seidel, Aragon): a search tree on the keys that is a heap on random
+// priorities, so its shape is that of a random insertion order and every operation takes
+// expected O(log n) whatever order the keys arrive in. split and merge relink nodes in
+// place, which makes carving a key range off and merging it elsewhere O(log n) instead of
+// the O(n + m) copy that join does
+class TreapTree {
+private:
+    static constexpr size_t SEARCH_BATCH_WIDTH = 16; // lookups advanced in lockstep by searchBatch
+    static constexpr uint64_t DEFAULT_SEED = 0x9E3779B97F4A7C15ull;
+#ifdef HEAPURI_TREE_STATS
+    mutable TreeStats stats; // mutable so that const lookups are counted too
+#endif
+
+    TreapNode *root;
+    uint64_t priorityState; // xorshift state, from the constructor's seed
+    size_t scratchPeak; // bytes of the largest temporary buffer one join or loadSorted held
+
+    uint32_t nextPriority();
+    uint64_t forkSeed();
+    TreapNode* rotateRight(TreapNode *node);
+    TreapNode* rotateLeft(TreapNode *node);
+    TreapNode* insertRecursive(TreapNode *node, int key, int depth);
+    TreapNode* deleteRecursive(TreapNode *node, int key);
+    void splitRecursive(TreapNode *node, int key, TreapNode *&less, TreapNode *&greaterEqual);
+    TreapNode* mergeRecursive(TreapNode *less, TreapNode *greater);
+    TreapNode* unionRecursive(TreapNode *a, TreapNode *b);
+    void destroyRecursive(TreapNode *node);
+    void rangeQueryRecursive(const TreapNode* node, int x, int y, std::vector<int>& result) const;
+    void floorBatchRecursive(const TreapNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                             const TreapNode* best, std::vector<std::optional<int>>& result) const;
+    void ceilingBatchRecursive(const TreapNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                               const TreapNode* best, std::vector<std::optional<int>>& result) const;
+    TreapNode* buildFromSorted(const std::vector<int>& keys);
+    size_t countNodes(const TreapNode* node) const;
+
+public:
+    // the shape depends only on the keys and the seed, so equal seeds give equal trees; trees
+    // that are merged later should be given different seeds
+    explicit TreapTree(uint64_t seed = DEFAULT_SEED);
+    ~TreapTree();
+    TreapTree(TreapTree&& other) noexcept;
+    TreapTree& operator=(TreapTree&& other) noexcept;
+    TreapTree(const TreapTree&) = delete;
+    TreapTree& operator=(const TreapTree&) = delete;
+
+    void insert(int key); // O(log n) expected - the new leaf is rotated up to its heap position
+    void remove(int key); // O(log n) expected - the node's two subtrees are merged in its place
+    bool search(int key) const; // O(log n) expected
+    // interleaved lookups - found[i] is set to search(keys[i]), child nodes are prefetched
+    // so that up to SEARCH_BATCH_WIDTH cache misses are in flight at once
+    void searchBatch(const int* keys, size_t count, bool* found) const; // O(count * log n) expected
+    bool isEmpty() const; // O(1)
+    TreapTree join(const TreapTree& other); // O(n + m) - copies, both trees are left as they were
+    // moves every key >= key into the returned treap, the smaller keys stay here; the returned
+    // treap, like join's, is seeded from this one's priority stream
+    TreapTree split(int key); // O(log n) expected - nodes are relinked, not copied
+    // moves every key of other into this treap and leaves other empty, a key in both is kept once
+    void merge(TreapTree& other); // O(log n) expected when the key ranges do not overlap, O(m log(n/m + 1)) otherwise
+    int floor(int key) const; // O(log n) expected
+    int ceiling(int key) const; // O(log n) expected
+    // non-throwing variants - an empty optional means no such key exists
+    std::optional<int> tryFloor(int key) const; // O(log n) expected
+    std::optional<int> tryCeiling(int key) const; // O(log n) expected
+    std::optional<int> predecessor(int key) const; // O(log n) expected - largest key strictly less than key
+    std::optional<int> successor(int key) const; // O(log n) expected - smallest key strictly greater than key
+    // batched variants - probes must be sorted ascending, answered in one traversal of the tree
+    std::vector<std::optional<int>> floorBatch(const std::vector<int>& probes) const; // O(m log n) - shared path prefixes are visited once
+    std::vector<std::optional<int>> ceilingBatch(const std::vector<int>& probes) const; // O(m log n) - shared path prefixes are visited once
+    std::vector<int> rangeQuery(int x, int y) const; // O(k + log n) expected - k is the number of elements in the range
+    // replaces the contents with a treap built bottom-up, sortedKeys must be strictly ascending
+    void loadSorted(const std::vector<int>& sortedKeys); // O(n)
+    // freezes the keys into a TreeSnapshot file, query it with TreeSnapshot::open(path)
+    void save(const std::string& path) const; // O(n)
+    void printRange(int x, int y) const;
+    // heap bytes held by the nodes as requested from the allocator, whose overhead is not included
+    size_t memoryUsage() const; // O(n)
+    size_t peakScratchBytes() const; // O(1) - largest temporary buffer one join or loadSorted allocated
+    TreeStats getStats() const; // all zero unless built with HEAPURI_TREE_STATS, rotations use the AVL counters
+    void resetStats();
+};
+
+#endif
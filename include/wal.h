@@ -0,0 +1,152 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "snapshot.h"
+
+enum LogOp : uint32_t { LOG_INSERT = 1, LOG_REMOVE = 2 };
+
+struct LogRecord {
+    int32_t key;
+    uint32_t op; // LogOp
+};
+
+struct WalOptions {
+    size_t groupCommitOps = 256;                          // records per fsync
+    std::chrono::microseconds groupCommitDelay{1000};     // commit on the next append once a record waited this long
+    size_t checkpointEveryOps = 0;                        // 0 = only on checkpoint()
+    bool sync = true;                                     // false skips fsync, for benchmarks
+};
+
+// append-only operation log: records are buffered and written as one checksummed batch per
+// group commit, so a crash loses at most the uncommitted group and a torn batch at the tail
+// is detected and cut off on recovery
+class WriteAheadLog {
+private:
+    static constexpr uint32_t WAL_VERSION = 1;
+
+    std::string path;
+    int fd;
+    WalOptions options;
+    std::vector<LogRecord> pending;
+    std::chrono::steady_clock::time_point oldestPending;
+    uint64_t commits;
+
+public:
+    // opens or creates the log, anything after the last intact batch is truncated,
+    // throws std::runtime_error on I/O failure
+    WriteAheadLog(const std::string& path, const WalOptions& options);
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+    ~WriteAheadLog(); // commits what is pending
+
+    void append(LogOp op, int key); // O(1) amortized - commits when the group is full or too old
+    void commit(); // writes the pending group as one batch and fsyncs it
+    void truncate(); // drops every record, called once a checkpoint covers them
+    uint64_t commitCount() const { return commits; }
+
+    // calls apply(op, key) for every record of every intact batch, in log order
+    template <typename Apply>
+    static uint64_t replay(const std::string& path, Apply apply); // O(records)
+    // batch scan behind replay, appends the records to records if given and returns the byte
+    // offset just past the last intact batch, 0 if the file is missing or not a log
+    static uint64_t scan(const std::string& path, std::vector<LogRecord>* records);
+    // fsyncs a file, or the directory holding it when directory is set
+    static void syncPath(const std::string& path, bool directory = false);
+};
+
+template <typename Apply>
+uint64_t WriteAheadLog::replay(const std::string& path, Apply apply) {
+    std::vector<LogRecord> records;
+    scan(path, &records);
+    for (const LogRecord& record : records) {
+        apply(static_cast<LogOp>(record.op), record.key);
+    }
+    return records.size();
+}
+
+// tree whose updates are logged before they are applied, with checkpoints to a snapshot
+// file so that recovery loads the checkpoint and replays only the log written since
+// Tree needs insert, remove, loadSorted and save
+template <typename Tree>
+class DurableTree {
+private:
+    std::string checkpointPath;
+    WalOptions options;
+    Tree tree;
+    uint64_t recoveredRecords; // set by recover(), which runs before log opens the file for appending
+    WriteAheadLog log;
+    size_t opsSinceCheckpoint;
+
+    // runs before the log is opened for appending
+    static uint64_t recover(const std::string& checkpointPath, const std::string& logPath, Tree& tree) {
+        if (std::FILE* file = std::fopen(checkpointPath.c_str(), "rb")) {
+            std::fclose(file);
+            TreeSnapshot checkpoint = TreeSnapshot::open(checkpointPath);
+            tree.loadSorted(checkpoint.rangeQuery(INT_MIN, INT_MAX));
+        }
+        return WriteAheadLog::replay(logPath, [&tree](LogOp op, int key) {
+            if (op == LOG_INSERT) {
+                tree.insert(key);
+            } else {
+                tree.remove(key);
+            }
+        });
+    }
+
+public:
+    // files are <basePath>.checkpoint and <basePath>.wal, existing ones are recovered
+    template <typename... TreeArgs>
+    DurableTree(const std::string& basePath, const WalOptions& options, TreeArgs&&... treeArgs)
+        : checkpointPath(basePath + ".checkpoint"), options(options), tree(std::forward<TreeArgs>(treeArgs)...),
+          recoveredRecords(recover(checkpointPath, basePath + ".wal", tree)), log(basePath + ".wal", options),
+          opsSinceCheckpoint(0) {}
+
+    void insert(int key) { // O(log n) + amortized log write
+        log.append(LOG_INSERT, key);
+        tree.insert(key);
+        afterUpdate();
+    }
+
+    void remove(int key) { // O(log n) + amortized log write
+        log.append(LOG_REMOVE, key);
+        tree.remove(key);
+        afterUpdate();
+    }
+
+    // saves the tree next to the old checkpoint, renames it into place and empties the log;
+    // a crash before the rename recovers from the old checkpoint and the full log, a crash
+    // after it replays records the checkpoint already holds, which is harmless because
+    // insert and remove are idempotent
+    void checkpoint() { // O(n)
+        log.commit();
+        std::string temporary = checkpointPath + ".tmp";
+        tree.save(temporary);
+        if (options.sync) WriteAheadLog::syncPath(temporary);
+        if (std::rename(temporary.c_str(), checkpointPath.c_str()) != 0) {
+            throw std::runtime_error("Cannot install checkpoint " + checkpointPath);
+        }
+        if (options.sync) WriteAheadLog::syncPath(checkpointPath, true);
+        log.truncate();
+        opsSinceCheckpoint = 0;
+    }
+
+    void commit() { log.commit(); }
+    const Tree& get() const { return tree; }
+    uint64_t recoveredLogRecords() const { return recoveredRecords; } // replayed by the constructor
+    uint64_t commitCount() const { return log.commitCount(); }
+
+private:
+    void afterUpdate() {
+        if (++opsSinceCheckpoint == options.checkpointEveryOps) checkpoint();
+    }
+};
+
+#endif
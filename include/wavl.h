@@ -0,0 +1,93 @@
+#ifndef WAVL_H
+#define WAVL_H
+
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+#include "stats.h"
+
+// rank next to key, so the node packs into 24 bytes instead of AVLNode's 32
+struct WAVLNode {
+    int key;
+    int rank; // leaves have rank 0, a missing child counts as rank -1
+    WAVLNode *left;
+    WAVLNode *right;
+
+    WAVLNode(int k) : key(k), rank(0), left(nullptr), right(nullptr) {}
+};
+
+// weak AVL tree (Haeupler, Sen, Tarjan, "Rank-Balanced Trees"): every rank difference
+// between a node and its child is 1 or 2 and every leaf has rank 0. an insert-only tree is
+// an AVL tree (height <= 1.44 log n), deletions keep the height within 2 log n; inserts and
+// deletes each do at most two rotations, and promotions/demotions are amortized O(1), where
+// AVL deletion may rotate at every level on the way up
+class WAVLTree {
+private:
+    static constexpr size_t SEARCH_BATCH_WIDTH = 16; // lookups advanced in lockstep by searchBatch
+#ifdef HEAPURI_TREE_STATS
+    mutable TreeStats stats; // mutable so that const lookups are counted too
+#endif
+
+    WAVLNode *root;
+    size_t scratchPeak; // bytes of the largest temporary key buffer one join held
+
+    static int rankOf(const WAVLNode *node);
+    WAVLNode* rotateRight(WAVLNode *node);
+    WAVLNode* rotateLeft(WAVLNode *node);
+    WAVLNode* fixInsertLeft(WAVLNode *node);
+    WAVLNode* fixInsertRight(WAVLNode *node);
+    WAVLNode* fixDeleteLeft(WAVLNode *node);
+    WAVLNode* fixDeleteRight(WAVLNode *node);
+    WAVLNode* insertRecursive(WAVLNode *node, int key, int depth);
+    WAVLNode* deleteRecursive(WAVLNode *node, int key);
+    void destroyRecursive(WAVLNode *node);
+    void rangeQueryRecursive(const WAVLNode* node, int x, int y, std::vector<int>& result) const;
+    void floorBatchRecursive(const WAVLNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                             const WAVLNode* best, std::vector<std::optional<int>>& result) const;
+    void ceilingBatchRecursive(const WAVLNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                               const WAVLNode* best, std::vector<std::optional<int>>& result) const;
+    WAVLNode* buildBalancedTree(const std::vector<int>& keys, int start, int end);
+    size_t countNodes(const WAVLNode* node) const;
+
+public:
+    WAVLTree();
+    ~WAVLTree();
+    WAVLTree(WAVLTree&& other) noexcept;
+    WAVLTree& operator=(WAVLTree&& other) noexcept;
+    WAVLTree(const WAVLTree&) = delete;
+    WAVLTree& operator=(const WAVLTree&) = delete;
+
+    void insert(int key); // O(log n) - at most two rotations
+    void remove(int key); // O(log n) - at most two rotations
+    bool search(int key) const; // O(log n)
+    // interleaved lookups - found[i] is set to search(keys[i]), child nodes are prefetched
+    // so that up to SEARCH_BATCH_WIDTH cache misses are in flight at once
+    void searchBatch(const int* keys, size_t count, bool* found) const; // O(count * log n)
+    bool isEmpty() const; // O(1)
+    WAVLTree join(const WAVLTree& other); // O(n + m) - merged keys are built into a balanced tree
+    int floor(int key) const; // O(log n)
+    int ceiling(int key) const; // O(log n)
+    // non-throwing variants - an empty optional means no such key exists
+    std::optional<int> tryFloor(int key) const; // O(log n)
+    std::optional<int> tryCeiling(int key) const; // O(log n)
+    std::optional<int> predecessor(int key) const; // O(log n) - largest key strictly less than key
+    std::optional<int> successor(int key) const; // O(log n) - smallest key strictly greater than key
+    // batched variants - probes must be sorted ascending, answered in one traversal of the tree
+    std::vector<std::optional<int>> floorBatch(const std::vector<int>& probes) const; // O(m log n) - shared path prefixes are visited once
+    std::vector<std::optional<int>> ceilingBatch(const std::vector<int>& probes) const; // O(m log n) - shared path prefixes are visited once
+    std::vector<int> rangeQuery(int x, int y) const; // O(k + log n) - k is the number of elements in the range
+    // replaces the contents with a perfectly balanced tree, sortedKeys must be strictly ascending
+    void loadSorted(const std::vector<int>& sortedKeys); // O(n)
+    // freezes the keys into a TreeSnapshot file, query it with TreeSnapshot::open(path)
+    void save(const std::string& path) const; // O(n)
+    void printRange(int x, int y) const;
+    // heap bytes held by the nodes as requested from the allocator, whose overhead is not included
+    size_t memoryUsage() const; // O(n)
+    size_t peakScratchBytes() const; // O(1) - largest temporary buffer one join allocated
+    TreeStats getStats() const; // all zero unless built with HEAPURI_TREE_STATS, rotations use the AVL counters
+    void resetStats();
+};
+
+#endif
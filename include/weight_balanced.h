@@ -0,0 +1,103 @@
+#ifndef WEIGHT_BALANCED_H
+#define WEIGHT_BALANCED_H
+
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+#include "stats.h"
+
+// subtree size next to key, so the node packs into 24 bytes like WAVLNode
+struct WBNode {
+    int key;
+    int size; // nodes in the subtree rooted here, including this one
+    WBNode *left;
+    WBNode *right;
+
+    WBNode(int k) : key(k), size(1), left(nullptr), right(nullptr) {}
+};
+
+// weight-balanced tree, BB[alpha] (Nievergelt, Reingold): the same balance condition as
+// ScapegoatTree, size(child) <= alpha * size(node), but it holds at every node after every
+// update and is restored with rotations on the way back up instead of subtree rebuilds.
+// the sizes it keeps for that give rank and select in O(log n).
+// rotations alone settle every imbalance for alpha >= about 2/3; below that a node can stay
+// out of balance after a few rounds of rotations, and then only that small subtree is rebuilt
+class WeightBalancedTree {
+private:
+    static constexpr size_t SEARCH_BATCH_WIDTH = 16; // lookups advanced in lockstep by searchBatch
+    static constexpr int MAX_REBALANCE_ROUNDS = 4;   // rotation rounds at one node before it is rebuilt
+#ifdef HEAPURI_TREE_STATS
+    mutable TreeStats stats; // mutable so that const lookups are counted too
+#endif
+
+    WBNode *root;
+    double alpha;
+    long long rebuilds; // subtrees that rotations could not balance, only with alpha below about 2/3
+    size_t scratchPeak; // bytes of the largest temporary buffer one rebuild or join held
+
+    static int sizeOf(const WBNode *node);
+    static void updateSize(WBNode *node);
+    bool isBalanced(const WBNode *node) const;
+    WBNode* rotateRight(WBNode *node);
+    WBNode* rotateLeft(WBNode *node);
+    WBNode* rebalance(WBNode *node, int round);
+    void flattenToVector(WBNode *node, std::vector<WBNode*> &nodes);
+    WBNode* rebuildTree(const std::vector<WBNode*> &nodes, int start, int end);
+    WBNode* rebuildSubtree(WBNode *node);
+    WBNode* insertRecursive(WBNode *node, int key, int depth, bool &inserted);
+    WBNode* deleteRecursive(WBNode *node, int key, bool &removed);
+    void destroyRecursive(WBNode *node);
+    void rangeQueryRecursive(const WBNode* node, int x, int y, std::vector<int>& result) const;
+    void floorBatchRecursive(const WBNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                             const WBNode* best, std::vector<std::optional<int>>& result) const;
+    void ceilingBatchRecursive(const WBNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                               const WBNode* best, std::vector<std::optional<int>>& result) const;
+    WBNode* buildBalancedTree(const std::vector<int>& keys, int start, int end);
+
+public:
+    WeightBalancedTree(double a = 0.7); // alpha in (0.5, 1), the same meaning as ScapegoatTree's
+    ~WeightBalancedTree();
+    WeightBalancedTree(WeightBalancedTree&& other) noexcept;
+    WeightBalancedTree& operator=(WeightBalancedTree&& other) noexcept;
+    WeightBalancedTree(const WeightBalancedTree&) = delete;
+    WeightBalancedTree& operator=(const WeightBalancedTree&) = delete;
+
+    void insert(int key); // O(log n) - amortized O(1) rotations
+    void remove(int key); // O(log n) - amortized O(1) rotations
+    bool search(int key) const; // O(log n)
+    // interleaved lookups - found[i] is set to search(keys[i]), child nodes are prefetched
+    // so that up to SEARCH_BATCH_WIDTH cache misses are in flight at once
+    void searchBatch(const int* keys, size_t count, bool* found) const; // O(count * log n)
+    bool isEmpty() const; // O(1)
+    size_t size() const; // O(1)
+    WeightBalancedTree join(const WeightBalancedTree& other); // O(n + m) - merged keys are built into a balanced tree
+    int floor(int key) const; // O(log n)
+    int ceiling(int key) const; // O(log n)
+    // non-throwing variants - an empty optional means no such key exists
+    std::optional<int> tryFloor(int key) const; // O(log n)
+    std::optional<int> tryCeiling(int key) const; // O(log n)
+    std::optional<int> predecessor(int key) const; // O(log n) - largest key strictly less than key
+    std::optional<int> successor(int key) const; // O(log n) - smallest key strictly greater than key
+    size_t rank(int key) const; // O(log n) - number of keys strictly less than key
+    int select(size_t index) const; // O(log n) - the index-th smallest key, counting from 0
+    // batched variants - probes must be sorted ascending, answered in one traversal of the tree
+    std::vector<std::optional<int>> floorBatch(const std::vector<int>& probes) const; // O(m log n) - shared path prefixes are visited once
+    std::vector<std::optional<int>> ceilingBatch(const std::vector<int>& probes) const; // O(m log n) - shared path prefixes are visited once
+    std::vector<int> rangeQuery(int x, int y) const; // O(k + log n) - k is the number of elements in the range
+    // replaces the contents with a perfectly balanced tree, sortedKeys must be strictly ascending
+    void loadSorted(const std::vector<int>& sortedKeys); // O(n)
+    // freezes the keys into a TreeSnapshot file, query it with TreeSnapshot::open(path)
+    void save(const std::string& path) const; // O(n)
+    void printRange(int x, int y) const;
+    // heap bytes held by the nodes as requested from the allocator, whose overhead is not included
+    size_t memoryUsage() const; // O(1) - the root's size is the node count
+    size_t peakScratchBytes() const; // O(1) - largest temporary buffer one rebuild or join allocated
+    double getAlpha() const; // O(1)
+    long long getRebuildCount() const; // O(1)
+    TreeStats getStats() const; // all zero unless built with HEAPURI_TREE_STATS, rotations use the AVL counters
+    void resetStats();
+};
+
+#endif
@@ -0,0 +1,208 @@
+import argparse
+import json
+import os
+import random
+import statistics
+import subprocess
+import sys
+
+# CONFIG
+
+DEFAULT_REPETITIONS = 5
+DEFAULT_SEED = 1             # fixed, so that both runs time the same inputs
+DEFAULT_THRESHOLD = 5.0      # percent slowdown that counts as a regression
+BOOTSTRAP_RESAMPLES = 2000
+CONFIDENCE = 0.95
+TIME_UNITS = {'ns': 1, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+
+# RECORDING
+
+def record(binary, output, repetitions, seed, extra_args):
+    # google benchmark writes json to --benchmark_out, the console output stays as it was
+    command = [binary, f'--seed={seed}', f'--benchmark_out={output}', '--benchmark_out_format=json',
+               f'--benchmark_repetitions={repetitions}'] + extra_args
+    print(' '.join(command))
+    return subprocess.call(command)
+
+# LOADING
+
+def load_run(filepath):
+    # benchmark name -> per-repetition times in ns, aggregates are recomputed here
+    with open(filepath, 'r') as f:
+        run = json.load(f)
+    samples = {}
+    for entry in run.get('benchmarks', []):
+        if entry.get('run_type') != 'iteration' or entry.get('error_occurred'):
+            continue
+        scale = TIME_UNITS.get(entry.get('time_unit', 'ns'), 1)
+        samples.setdefault(entry['run_name'], {'real_time': [], 'cpu_time': []})
+        samples[entry['run_name']]['real_time'].append(entry['real_time'] * scale)
+        samples[entry['run_name']]['cpu_time'].append(entry['cpu_time'] * scale)
+    return run.get('context', {}), samples
+
+# STATISTICS
+
+def relative_delta(baseline, candidate):
+    return (statistics.median(candidate) - statistics.median(baseline)) / statistics.median(baseline) * 100.0
+
+def bootstrap_interval(baseline, candidate, rng):
+    # percentile bootstrap of the relative change of the medians, None without repetitions
+    if len(baseline) < 2 or len(candidate) < 2:
+        return None
+    deltas = []
+    for _ in range(BOOTSTRAP_RESAMPLES):
+        base = [rng.choice(baseline) for _ in baseline]
+        cand = [rng.choice(candidate) for _ in candidate]
+        deltas.append(relative_delta(base, cand))
+    deltas.sort()
+    tail = (1.0 - CONFIDENCE) / 2.0
+    return deltas[int(tail * len(deltas))], deltas[int((1.0 - tail) * len(deltas)) - 1]
+
+def compare(baseline, candidate, metric, threshold):
+    # one row per benchmark present in both runs; a change is flagged only when its whole
+    # confidence interval lies beyond zero and the median change exceeds the threshold
+    rng = random.Random(0)
+    rows = []
+    for name in baseline:
+        if name not in candidate:
+            continue
+        base = baseline[name][metric]
+        cand = candidate[name][metric]
+        delta = relative_delta(base, cand)
+        interval = bootstrap_interval(base, cand, rng)
+        if interval is None:
+            verdict = 'noisy' if abs(delta) > threshold else ''
+        elif delta > threshold and interval[0] > 0:
+            verdict = 'REGRESSION'
+        elif delta < -threshold and interval[1] < 0:
+            verdict = 'improved'
+        else:
+            verdict = ''
+        rows.append({'name': name, 'baseline': statistics.median(base), 'candidate': statistics.median(cand),
+                     'delta': delta, 'interval': interval, 'verdict': verdict,
+                     'repetitions': min(len(base), len(cand))})
+    return rows
+
+# REPORTING
+
+def format_time(ns):
+    for unit, scale in [('s', 1e9), ('ms', 1e6), ('us', 1e3)]:
+        if ns >= scale:
+            return f'{ns / scale:.3g} {unit}'
+    return f'{ns:.3g} ns'
+
+def print_report(rows, baseline_context, candidate_context, metric, threshold):
+    if baseline_context.get('seed') != candidate_context.get('seed'):
+        print(f"warning: runs used different seeds ({baseline_context.get('seed')} vs "
+              f"{candidate_context.get('seed')}), inputs differ between them")
+    width = max([len(row['name']) for row in rows] + [9])
+    print(f"{'Benchmark':<{width}}  {'Baseline':>10}  {'Candidate':>10}  {'Delta':>8}  "
+          f"{int(CONFIDENCE * 100)}% CI")
+    for row in rows:
+        interval = row['interval']
+        interval_str = f"[{interval[0]:+.1f}%, {interval[1]:+.1f}%]" if interval else 'n/a'
+        print(f"{row['name']:<{width}}  {format_time(row['baseline']):>10}  {format_time(row['candidate']):>10}  "
+              f"{row['delta']:+7.1f}%  {interval_str:<20} {row['verdict']}")
+    regressions = [row for row in rows if row['verdict'] == 'REGRESSION']
+    improved = [row for row in rows if row['verdict'] == 'improved']
+    print(f"\n{len(rows)} benchmarks compared on {metric}, threshold {threshold}%: "
+          f"{len(regressions)} regressions, {len(improved)} improvements")
+    if rows and min(row['repetitions'] for row in rows) < 2:
+        print("some benchmarks have a single repetition, record with --repetitions >= 5 for intervals")
+    return regressions
+
+# PLOTTING
+
+def split_name(name):
+    # BM_<Tree>_<Operation>/<size>/... -> (operation, tree, size)
+    parts = name.split('/')
+    base = parts[0][3:] if parts[0].startswith('BM_') else parts[0]
+    tree, _, operation = base.partition('_')
+    size = int(parts[1]) if len(parts) > 1 and parts[1].isdigit() else None
+    return operation, tree, size
+
+def plot_charts(rows, output_dir, threshold):
+    import matplotlib
+    matplotlib.use('Agg')
+    import matplotlib.pyplot as plt
+
+    if not os.path.exists(output_dir):
+        os.makedirs(output_dir)
+
+    # every benchmark's change with its interval, worst first
+    ordered = sorted(rows, key=lambda row: row['delta'])
+    fig, ax = plt.subplots(figsize=(12, max(4, 0.25 * len(ordered))))
+    colors = {'REGRESSION': 'tab:red', 'improved': 'tab:green'}
+    for i, row in enumerate(ordered):
+        interval = row['interval'] or (row['delta'], row['delta'])
+        ax.plot(interval, [i, i], color='gray', linewidth=1)
+        ax.plot(row['delta'], i, 'o', color=colors.get(row['verdict'], 'tab:blue'))
+    ax.axvline(0, color='black', linewidth=0.8)
+    ax.axvline(threshold, color='tab:red', linestyle='--', linewidth=0.8)
+    ax.axvline(-threshold, color='tab:green', linestyle='--', linewidth=0.8)
+    ax.set_yticks(range(len(ordered)))
+    ax.set_yticklabels([row['name'] for row in ordered], fontsize=7)
+    ax.set_xlabel('Median change (%), candidate vs baseline')
+    ax.set_title('Benchmark Deltas with Confidence Intervals')
+    plt.tight_layout()
+    plt.savefig(os.path.join(output_dir, 'compare_deltas.png'))
+    plt.close()
+
+    # baseline and candidate side by side for every operation measured over sizes
+    families = {}
+    for row in rows:
+        operation, tree, size = split_name(row['name'])
+        if size is not None:
+            families.setdefault(operation, []).append((tree, size, row))
+    for operation, entries in families.items():
+        fig, ax = plt.subplots(figsize=(12, 7))
+        for tree in sorted(set(tree for tree, _, _ in entries)):
+            points = sorted((size, row) for t, size, row in entries if t == tree)
+            sizes = [size for size, _ in points]
+            ax.plot(sizes, [row['baseline'] for _, row in points], 'o--', label=f'{tree} baseline')
+            ax.plot(sizes, [row['candidate'] for _, row in points], 'o-', label=f'{tree} candidate')
+        ax.set_xscale('log', base=2)
+        ax.set_yscale('log')
+        ax.set_xlabel('Input Size (n)')
+        ax.set_ylabel('Median time (ns)')
+        ax.set_title(f'{operation}: Baseline vs Candidate')
+        ax.legend()
+        plt.tight_layout()
+        plt.savefig(os.path.join(output_dir, f'compare_{operation}.png'))
+        plt.close()
+
+# MAIN
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Record benchmark runs as JSON and compare two of them.')
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    record_parser = commands.add_parser('record', help='run the benchmarks binary and store its results')
+    record_parser.add_argument('binary')
+    record_parser.add_argument('output', help='JSON file to write')
+    record_parser.add_argument('--repetitions', type=int, default=DEFAULT_REPETITIONS)
+    record_parser.add_argument('--seed', type=int, default=DEFAULT_SEED)
+
+    compare_parser = commands.add_parser('compare', help='compare a candidate run against a baseline run')
+    compare_parser.add_argument('baseline')
+    compare_parser.add_argument('candidate')
+    compare_parser.add_argument('--metric', choices=['real_time', 'cpu_time'], default='real_time')
+    compare_parser.add_argument('--threshold', type=float, default=DEFAULT_THRESHOLD,
+                                help='percent slowdown that counts as a regression')
+    compare_parser.add_argument('--charts', metavar='DIR', help='write side-by-side charts to DIR')
+
+    # anything record does not know is passed on to the binary, e.g. --benchmark_filter
+    args, extra = parser.parse_known_args()
+    if args.command == 'record':
+        sys.exit(record(args.binary, args.output, args.repetitions, args.seed, extra))
+    if extra:
+        parser.error(f"unrecognized arguments: {' '.join(extra)}")
+
+    baseline_context, baseline = load_run(args.baseline)
+    candidate_context, candidate = load_run(args.candidate)
+    rows = compare(baseline, candidate, args.metric, args.threshold)
+    regressions = print_report(rows, baseline_context, candidate_context, args.metric, args.threshold)
+    if args.charts:
+        plot_charts(rows, args.charts, args.threshold)
+        print(f"Charts saved to {args.charts}")
+    sys.exit(1 if regressions else 0)
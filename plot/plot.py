@@ -3,6 +3,8 @@ import matplotlib.pyplot as plt
 import seaborn as sns
 import re
 import os
+import sys
+import json
 import numpy as np
 
 # CONFIG
@@ -27,6 +29,15 @@ def parse_time(time_str):
         except ValueError:
             return None
 
+COUNTER_SUFFIXES = {'': 1, 'k': 1e3, 'M': 1e6, 'G': 1e9, 'T': 1e12}
+
+def parse_counters(line):
+    # user counters are printed as name=value with an optional k/M/G suffix
+    counters = {}
+    for name, value, suffix in re.findall(r'(\w+)=([\d.]+)([kMGT]?)', line):
+        counters[name] = float(value) * COUNTER_SUFFIXES[suffix]
+    return counters
+
 def parse_benchmark_name(name):
     parts = name.split('/')
     base_name = parts[0]
@@ -39,23 +50,83 @@ def parse_benchmark_name(name):
     if base_name.startswith('BM_AVL'):
         tree_type = 'AVL'
         operation = base_name.replace('BM_AVL_', '')
-    elif base_name.startswith('BM_Scapegoat_AlphaTuning'):
-        tree_type = 'Scapegoat'
+    elif base_name.startswith('BM_WAVL'):
+        tree_type = 'WAVL'
+        operation = base_name.replace('BM_WAVL_', '')
+    elif re.match(r'BM_(Scapegoat|WeightBalanced)_AlphaTuning', base_name):
+        # both engines read alpha the same way, their tuning runs share one chart
+        tree_type = 'Scapegoat' if base_name.startswith('BM_Scapegoat') else 'WeightBalanced'
+        variant = 'AlphaTuningStatic' if '_AlphaTuningStatic' in base_name else 'AlphaTuning'
         alpha_match = re.search(r'_(\d+)$', base_name)
         if alpha_match:
             alpha = int(alpha_match.group(1)) / 100.0
-            operation = f'AlphaTuning_{alpha}'
+            operation = f'{variant}_{alpha}'
         else:
-            operation = 'AlphaTuning_Unknown'
+            operation = f'{variant}_Unknown'
     elif base_name.startswith('BM_Scapegoat'):
         tree_type = 'Scapegoat'
         operation = base_name.replace('BM_Scapegoat_', '')
         alpha = 0.7
+    elif base_name.startswith('BM_WeightBalanced'):
+        tree_type = 'WeightBalanced'
+        operation = base_name.replace('BM_WeightBalanced_', '')
+        alpha = 0.7
+    elif base_name.startswith('BM_Treap'):
+        tree_type = 'Treap'
+        operation = base_name.replace('BM_Treap_', '')
+    elif base_name.startswith('BM_Splay'):
+        tree_type = 'Splay'
+        operation = base_name.replace('BM_Splay_', '')
+    elif base_name.startswith('BM_StdSet'):
+        tree_type = 'StdSet'
+        operation = base_name.replace('BM_StdSet_', '')
+    elif base_name.startswith('BM_SortedVector'):
+        tree_type = 'SortedVector'
+        operation = base_name.replace('BM_SortedVector_', '')
+    elif base_name.startswith('BM_Snapshot'):
+        tree_type = 'Snapshot'
+        operation = base_name.replace('BM_Snapshot_', '')
+
+    # contention benchmarks are threads/read percent, the percent tells the workloads apart
+    if operation and operation.startswith('Contention_') and len(parts) > 2 and parts[2].isdigit():
+        operation = f'{operation}_{parts[2]}'
 
     return tree_type, operation, size_n, alpha
 
 
+def load_json_data(filepath):
+    # google benchmark --benchmark_out json, one row per repetition (aggregates are skipped,
+    # the line plots average repetitions themselves)
+    with open(filepath, 'r') as f:
+        run = json.load(f)
+    time_units = {'ns': 1, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+    fields = {'name', 'family_index', 'per_family_instance_index', 'run_name', 'run_type', 'repetitions',
+              'repetition_index', 'threads', 'iterations', 'real_time', 'cpu_time', 'time_unit'}
+    data = []
+    for entry in run.get('benchmarks', []):
+        if entry.get('run_type') != 'iteration' or entry.get('error_occurred'):
+            continue
+        tree_type, operation, size_n, alpha = parse_benchmark_name(entry['name'])
+        if not (tree_type and operation and size_n is not None):
+            print(f"Skipping benchmark due to parsing error: {entry['name']}")
+            continue
+        scale = time_units.get(entry.get('time_unit', 'ns'), 1)
+        row = {
+            'Benchmark': entry['name'],
+            'TreeType': tree_type,
+            'Operation': operation,
+            'Size': size_n,
+            'Alpha': alpha,
+            'Time_ns': entry['real_time'] * scale,
+            'CPUTime_ns': entry['cpu_time'] * scale
+        }
+        row.update({name: value for name, value in entry.items() if name not in fields})
+        data.append(row)
+    return pd.DataFrame(data)
+
 def load_data(filepath):
+    if filepath.endswith('.json'):
+        return load_json_data(filepath)
     data = []
     with open(filepath, 'r') as f:
         lines = f.readlines()
@@ -80,7 +151,7 @@ def load_data(filepath):
         cpu_time_ns = parse_time(cpu_time_str)
 
         if tree_type and operation and size_n is not None and time_ns is not None:
-            data.append({
+            row = {
                 'Benchmark': benchmark_full_name,
                 'TreeType': tree_type,
                 'Operation': operation,
@@ -88,7 +159,9 @@ def load_data(filepath):
                 'Alpha': alpha,
                 'Time_ns': time_ns,
                 'CPUTime_ns': cpu_time_ns
-            })
+            }
+            row.update(parse_counters(line))
+            data.append(row)
         else:
              print(f"Skipping line due to parsing error: {line}")
 
@@ -97,7 +170,8 @@ def load_data(filepath):
 
 # PLOTTING
 
-def plot_comparison(df, operations, title, filename, y_col='Time_ns', y_label='Time (ns)', log_y=True):
+def plot_comparison(df, operations, title, filename, y_col='Time_ns', y_label='Time (ns)', log_y=True,
+                    x_label='Input Size (n)'):
     plt.style.use(PLOT_STYLE)
     fig, ax = plt.subplots(figsize=(12, 7))
 
@@ -109,7 +183,7 @@ def plot_comparison(df, operations, title, filename, y_col='Time_ns', y_label='T
     sns.lineplot(data=plot_df, x='Size', y=y_col, hue='TreeType', style='Operation', marker='o', ax=ax)
 
     ax.set_title(title, fontsize=16)
-    ax.set_xlabel('Input Size (n)', fontsize=12)
+    ax.set_xlabel(x_label, fontsize=12)
     ax.set_ylabel(y_label, fontsize=12)
     ax.set_xscale('log', base=2)
     if log_y:
@@ -132,7 +206,7 @@ def plot_alpha_tuning(df, filename, y_col='Time_ns', y_label='Time (ns)', log_y=
     plt.style.use(PLOT_STYLE)
     fig, ax = plt.subplots(figsize=(12, 7))
 
-    plot_df = df[df['Operation'].str.startswith('AlphaTuning_')].copy()
+    plot_df = df[df['Operation'].str.startswith('AlphaTuning')].copy()
     if plot_df.empty:
         print("No AlphaTuning data found to plot.")
         plt.close(fig)
@@ -141,16 +215,18 @@ def plot_alpha_tuning(df, filename, y_col='Time_ns', y_label='Time (ns)', log_y=
     plot_df['Size'] = pd.to_numeric(plot_df['Size'])
     plot_df = plot_df.sort_values(by=['Alpha', 'Size'])
 
-    sns.lineplot(data=plot_df, x='Size', y=y_col, hue='Alpha', palette='viridis', marker='o', ax=ax)
+    # runtime alpha (AlphaTuning) vs compile-time alpha (AlphaTuningStatic), per engine
+    plot_df['Variant'] = plot_df['TreeType'] + ' ' + plot_df['Operation'].str.split('_').str[0]
+    sns.lineplot(data=plot_df, x='Size', y=y_col, hue='Alpha', style='Variant', palette='viridis', marker='o', ax=ax)
 
-    ax.set_title('Scapegoat Tree Performance by Alpha Value (Random Insert)', fontsize=16)
+    ax.set_title('Scapegoat vs. Weight-Balanced Tree by Alpha Value (Random Insert)', fontsize=16)
     ax.set_xlabel('Input Size (n)', fontsize=12)
     ax.set_ylabel(y_label, fontsize=12)
     ax.set_xscale('log', base=2)
     if log_y:
         ax.set_yscale('log')
 
-    ax.legend(title='Alpha Value', bbox_to_anchor=(1.05, 1), loc='upper left')
+    ax.legend(title='Alpha / Variant', bbox_to_anchor=(1.05, 1), loc='upper left')
     plt.xticks(fontsize=10)
     plt.yticks(fontsize=10)
     plt.tight_layout(rect=[0, 0, 0.85, 1])
@@ -167,8 +243,10 @@ def plot_alpha_tuning(df, filename, y_col='Time_ns', y_label='Time (ns)', log_y=
 # MAIN
 
 if __name__ == "__main__":
-    print(f"Loading data from {RESULTS_FILE}...")
-    df_results = load_data(RESULTS_FILE)
+    # console dump by default, or a json run: plot.py results.json
+    results_file = sys.argv[1] if len(sys.argv) > 1 else RESULTS_FILE
+    print(f"Loading data from {results_file}...")
+    df_results = load_data(results_file)
 
     if df_results.empty:
         print("No data loaded. Exiting.")
@@ -184,15 +262,15 @@ if __name__ == "__main__":
             'RandomInsert', 'MixedPatternInsert'
         ]
         plot_comparison(df_results, insertion_ops,
-                        'Insertion Performance: AVL vs. Scapegoat',
+                        'Insertion Performance: AVL vs. Scapegoat vs. Baselines',
                         'insertion_comparison.png')
 
         # 2. Deletion Comparison (Random, Sequential, Delete-Heavy)
         deletion_ops = [
-            'RandomDeletion', 'SequentialDeletion', 'DeleteHeavyWorkload'
+            'RandomDeletion', 'SequentialDeletion', 'DeleteHeavyWorkload', 'DeleteHeavyWorkloadLazy'
         ]
         plot_comparison(df_results, deletion_ops,
-                        'Deletion Performance: AVL vs. Scapegoat',
+                        'Deletion Performance: AVL vs. Scapegoat vs. Baselines',
                         'deletion_comparison.png')
 
         # 3. Search Comparison (Successful, Unsuccessful, Distribution)
@@ -200,29 +278,50 @@ if __name__ == "__main__":
             'SuccessfulSearch', 'UnsuccessfulSearch', 'SearchDistribution'
         ]
         plot_comparison(df_results, search_ops,
-                        'Search Performance: AVL vs. Scapegoat',
+                        'Search Performance: AVL vs. Scapegoat vs. Baselines',
                         'search_comparison.png')
 
+        # 3b. Serial vs Interleaved Lookups on Large Trees
+        large_search_ops = ['LargeSearch', 'LargeSearchBatch']
+        plot_comparison(df_results, large_search_ops,
+                        'Serial vs Batched Search on Large Trees: AVL vs. Scapegoat',
+                        'large_search_comparison.png')
+
         # 4. Range Query Comparison (Small, Large, Empty)
         range_query_ops = [
             'SmallRangeQuery', 'LargeRangeQuery', 'EmptyRangeQuery'
         ]
         plot_comparison(df_results, range_query_ops,
-                        'Range Query Performance: AVL vs. Scapegoat',
+                        'Range Query Performance: AVL vs. Scapegoat vs. Baselines',
                         'range_query_comparison.png')
 
+        # 4b. Floor / Ceiling Miss-Heavy Comparison (throwing vs optional vs batched)
+        floor_ceiling_ops = [
+            'FloorMissHeavy_Throwing', 'FloorMissHeavy', 'FloorMissHeavyBatch',
+            'CeilingMissHeavy_Throwing', 'CeilingMissHeavy', 'CeilingMissHeavyBatch'
+        ]
+        plot_comparison(df_results, floor_ceiling_ops,
+                        'Floor / Ceiling Miss-Heavy Performance: AVL vs. Scapegoat',
+                        'floor_ceiling_comparison.png')
+
         # 5. Mixed Workload Comparison (Dictionary, Database Index)
         mixed_workload_ops = [
             'DictionaryOperations', 'DatabaseIndex'
         ]
         plot_comparison(df_results, mixed_workload_ops,
-                        'Mixed Workload Performance: AVL vs. Scapegoat',
+                        'Mixed Workload Performance: AVL vs. Scapegoat vs. Baselines',
                         'mixed_workload_comparison.png')
 
+        # 5b. Rank-balanced vs height-balanced on the workloads that delete
+        plot_comparison(df_results[df_results['TreeType'].isin(['AVL', 'WAVL'])],
+                        ['RandomDeletion', 'SequentialDeletion', 'DeleteHeavyWorkload'] + mixed_workload_ops,
+                        'Deletion and Mixed Workloads: AVL vs. WAVL',
+                        'wavl_comparison.png')
+
         # 6. Worst Case Comparison
         worst_case_ops = ['WorstCase']
         plot_comparison(df_results, worst_case_ops,
-                        'Worst Case Performance: AVL vs. Scapegoat',
+                        'Worst Case Performance: AVL vs. Scapegoat vs. Baselines',
                         'worst_case_comparison.png')
 
         # 7. Large Dataset Comparison (Using ms unit might be better here)
@@ -231,11 +330,133 @@ if __name__ == "__main__":
         df_large = df_results[df_results['Operation'].isin(large_data_ops)].copy()
         df_large['Time_ms'] = df_large['Time_ns'] / 1_000_000
         plot_comparison(df_large, large_data_ops,
-                        'Large Dataset Performance: AVL vs. Scapegoat',
+                        'Large Dataset Performance: AVL vs. Scapegoat vs. Baselines',
                         'large_dataset_comparison.png',
                         y_col='Time_ms', y_label='Time (ms)', log_y=False) # Often better linear for ms
 
-        # 8. Scapegoat Alpha Tuning Comparison
+        # 7b. Lookups and sliding-window updates on trees far larger than the LLC
+        large_scale_ops = ['LargeScale_Uniform', 'LargeScale_Zipfian', 'LargeScale_Hotspot',
+                           'LargeScale_Latest', 'LargeScale_MovingWindow', 'LargeScale_SlidingWindowUpdates']
+        plot_comparison(df_results, large_scale_ops,
+                        'Large-Scale Key Distributions: AVL vs. Scapegoat',
+                        'large_scale_comparison.png')
+
+        # 7c. Carving key ranges off and merging them back: treap split/merge vs copying join
+        range_partition_ops = ['RangeMerge', 'RangePartition']
+        plot_comparison(df_results[df_results['TreeType'].isin(['AVL', 'WAVL', 'Scapegoat', 'Treap'])],
+                        range_partition_ops,
+                        'Range Partitioning: Treap split/merge vs. join',
+                        'range_partition_comparison.png')
+
+        # 7d. Skewed and in-order lookups, where a splay tree keeps the hot keys near the root
+        locality_ops = ['SearchDistribution', 'SequentialSearch', 'LargeScale_Zipfian', 'LargeScale_Hotspot',
+                        'LargeScale_Uniform']
+        plot_comparison(df_results[df_results['TreeType'].isin(['AVL', 'Scapegoat', 'Splay'])], locality_ops,
+                        'Access Locality: Splay vs. AVL vs. Scapegoat',
+                        'splay_locality_comparison.png')
+
+        # 7a. Restart cost: re-inserting every key vs mapping a saved snapshot
+        startup_ops = ['StartupReinsert', 'StartupOpen']
+        df_startup = df_results[df_results['Operation'].isin(startup_ops)].copy()
+        df_startup['Time_ms'] = df_startup['Time_ns'] / 1_000_000
+        plot_comparison(df_startup, startup_ops,
+                        'Startup Cost: Re-insert vs Mapped Snapshot',
+                        'startup_comparison.png',
+                        y_col='Time_ms', y_label='Time (ms)')
+
+        # 8. Alpha Tuning Comparison: scapegoat rebuilds vs weight-balanced rotations
         plot_alpha_tuning(df_results, 'scapegoat_alpha_tuning.png')
 
+        # 8a. Fixed vs adaptive alpha on a phase-changing workload
+        phase_change_ops = ['PhaseChange_55', 'PhaseChange_60', 'PhaseChange_70',
+                            'PhaseChange_80', 'PhaseChange_90', 'PhaseChange_Adaptive']
+        plot_comparison(df_results, phase_change_ops,
+                        'Phase-Changing Workload: Fixed vs Adaptive Alpha',
+                        'scapegoat_phase_change.png')
+
+        # 8b. Tail latency (per-operation percentiles)
+        if 'p99_ns' in df_results.columns:
+            tail_ops = ['TailLatency_RandomInsert', 'TailLatency_DeleteHeavy', 'TailLatency_Dictionary',
+                        'TailLatencyIncremental_RandomInsert', 'TailLatencyIncremental_DeleteHeavy',
+                        'TailLatencyIncremental_Dictionary']
+            for percentile_col, label in [('p99_ns', 'p99'), ('p999_ns', 'p99.9'), ('max_ns', 'max')]:
+                plot_comparison(df_results, tail_ops,
+                                f'{label} Operation Latency: AVL vs. Scapegoat',
+                                f'tail_latency_{label.replace(".", "")}.png',
+                                y_col=percentile_col, y_label=f'{label} latency (ns)')
+
+        # 8c. Shared-tree contention: aggregate throughput and fairness per sync strategy
+        if 'fairness' in df_results.columns:
+            for read_percent in [50, 90, 99]:
+                contention_ops = [f'Contention_{strategy}_{read_percent}'
+                                  for strategy in ['Mutex', 'SharedMutex', 'Sharded']]
+                plot_comparison(df_results, contention_ops,
+                                f'Shared-Tree Throughput, {read_percent}% Lookups',
+                                f'contention_throughput_{read_percent}.png',
+                                y_col='items_per_second', y_label='Operations / s', log_y=False,
+                                x_label='Threads')
+                plot_comparison(df_results, contention_ops,
+                                f'Shared-Tree Fairness (Jain), {read_percent}% Lookups',
+                                f'contention_fairness_{read_percent}.png',
+                                y_col='fairness', y_label='Fairness index', log_y=False,
+                                x_label='Threads')
+
+        # 8e. Memory footprint: tree heap bytes per key and process peak RSS
+        if 'bytes_per_key' in df_results.columns:
+            memory_ops = (insertion_ops + deletion_ops + search_ops + range_query_ops
+                          + mixed_workload_ops + large_data_ops)
+            plot_comparison(df_results, memory_ops,
+                            'Heap Bytes per Key: AVL vs. Scapegoat',
+                            'memory_bytes_per_key.png',
+                            y_col='bytes_per_key', y_label='Bytes / key', log_y=False)
+            plot_comparison(df_results, memory_ops,
+                            'Rebuild / Join Scratch Bytes per Key: AVL vs. Scapegoat',
+                            'memory_scratch_bytes_per_key.png',
+                            y_col='scratch_bytes_per_key', y_label='Bytes / key', log_y=False)
+            plot_comparison(df_results, large_scale_ops,
+                            'Peak RSS on Large Trees: AVL vs. Scapegoat',
+                            'memory_peak_rss_large_scale.png',
+                            y_col='peak_rss_MB', y_label='Peak RSS (MB)')
+            plot_comparison(df_results, ['BulkBuild'],
+                            'Peak RSS of the Streaming Snapshot Build',
+                            'memory_peak_rss_bulk_build.png',
+                            y_col='peak_rss_MB', y_label='Peak RSS (MB)')
+
+        # 8d. Hardware counters per operation (only present when run with --perf_counters)
+        perf_ops = ['RandomInsert', 'RandomDeletion', 'SuccessfulSearch', 'UnsuccessfulSearch']
+        perf_counters = [('instructions_per_op', 'Instructions'), ('cache_misses_per_op', 'Cache misses'),
+                         ('branch_misses_per_op', 'Branch misses'), ('dtlb_misses_per_op', 'dTLB misses')]
+        for counter_col, label in perf_counters:
+            if counter_col in df_results.columns:
+                plot_comparison(df_results, perf_ops,
+                                f'{label} per Operation: AVL vs. Scapegoat',
+                                f'perf_{counter_col}.png',
+                                y_col=counter_col, y_label=f'{label} / op')
+                plot_comparison(df_results, large_scale_ops[:-1],
+                                f'{label} per Lookup on Large Trees: AVL vs. Scapegoat',
+                                f'perf_large_scale_{counter_col}.png',
+                                y_col=counter_col, y_label=f'{label} / op')
+
+        # 9. Tree counters (only present when the benchmarks were built with HEAPURI_TREE_STATS)
+        if 'nodes_visited' in df_results.columns:
+            df_counters = df_results.copy()
+            df_counters['rotations'] = df_counters[['rot_LL', 'rot_LR', 'rot_RR', 'rot_RL']].sum(axis=1)
+            counter_ops = insertion_ops + deletion_ops + mixed_workload_ops
+            plot_comparison(df_counters, counter_ops,
+                            'Nodes Visited per Iteration: AVL vs. Scapegoat',
+                            'counters_nodes_visited.png',
+                            y_col='nodes_visited', y_label='Nodes visited')
+            plot_comparison(df_counters[df_counters['TreeType'].isin(['AVL', 'WAVL', 'WeightBalanced'])], counter_ops,
+                            'Rotations per Iteration: AVL vs. WAVL vs. Weight-Balanced',
+                            'counters_avl_rotations.png',
+                            y_col='rotations', y_label='Rotations')
+            plot_comparison(df_counters[df_counters['TreeType'] == 'Scapegoat'], counter_ops,
+                            'Scapegoat Nodes Rebuilt per Iteration',
+                            'counters_scapegoat_rebuilds.png',
+                            y_col='nodes_rebuilt', y_label='Nodes rebuilt')
+            plot_comparison(df_counters, counter_ops,
+                            'Maximum Insert Depth: AVL vs. Scapegoat',
+                            'counters_max_depth.png',
+                            y_col='max_depth', y_label='Depth', log_y=False)
+
         print(f"\nAll plots saved to {OUTPUT_DIR}")
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "avl.h" 
+#include "snapshot.h"
+#include <limits>
 #include <stdexcept> 
+#include <utility>
 
 // PRIVATE
 int AVLTree::getHeight(AVLNode *node) {
@@ -58,9 +61,12 @@ AVLNode* AVLTree::balance(AVLNode *node) {
     if (balanceFactor > 1) {
         // left-right Case
         if (getBalanceFactor(node->left) < 0) {
+            TREE_STATS(stats.rotationsLR++);
             node->left = rotateLeft(node->left);
+        } else {
+            // left-left Case
+            TREE_STATS(stats.rotationsLL++);
         }
-        // left-left Case
         return rotateRight(node);
     }
 
@@ -68,9 +74,12 @@ AVLNode* AVLTree::balance(AVLNode *node) {
     if (balanceFactor < -1) {
         // right-keft Case
         if (getBalanceFactor(node->right) > 0) {
+            TREE_STATS(stats.rotationsRL++);
             node->right = rotateRight(node->right);
+        } else {
+            // right-right Case
+            TREE_STATS(stats.rotationsRR++);
         }
-        // right-right Case
         return rotateLeft(node);
     }
 
@@ -85,6 +94,9 @@ AVLNode* AVLTree::insertRecursive(AVLNode *node, int key) {
         return new AVLNode(key);
     }
 
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
     if (key < node->key) {
         node->left = insertRecursive(node->left, key);
     } else if (key > node->key) {
@@ -117,7 +129,11 @@ AVLNode* AVLTree::findMax(AVLNode *node) {
 }
 
 AVLNode* AVLTree::searchRecursive(AVLNode *node, int key) const {
-    if (!node || node->key == key) {
+    if (!node) return nullptr;
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    if (node->key == key) {
         return node;
     }
     if (key < node->key) {
@@ -129,6 +145,8 @@ AVLNode* AVLTree::searchRecursive(AVLNode *node, int key) const {
 
 AVLNode* AVLTree::floorRecursive(AVLNode* node, int key) const {
     if (!node) return nullptr;
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
     
     // if key equals node's key, we found exact floor
     if (node->key == key) return node;
@@ -147,6 +165,8 @@ AVLNode* AVLTree::floorRecursive(AVLNode* node, int key) const {
 
 AVLNode* AVLTree::ceilingRecursive(AVLNode* node, int key) const {
     if (!node) return nullptr;
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
     
     // if key equals node's key, we found exact ceiling
     if (node->key == key) return node;
@@ -165,6 +185,7 @@ AVLNode* AVLTree::ceilingRecursive(AVLNode* node, int key) const {
 
 void AVLTree::rangeQueryRecursive(AVLNode* node, int x, int y, std::vector<int>& result) const {
     if (!node) return;
+    TREE_STATS(stats.nodesVisited++);
     
     // if node's key is greater than x, explore left subtree
     if (x < node->key) {
@@ -182,8 +203,51 @@ void AVLTree::rangeQueryRecursive(AVLNode* node, int x, int y, std::vector<int>&
     }
 }
 
+void AVLTree::floorBatchRecursive(AVLNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                                  const AVLNode* best, std::vector<std::optional<int>>& result) const {
+    if (lo >= hi) return;
+
+    // fell off the tree, every probe still in [lo, hi) shares the same floor
+    if (!node) {
+        for (size_t i = lo; i < hi; ++i) {
+            result[i] = best ? std::optional<int>(best->key) : std::nullopt;
+        }
+        return;
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    // probes smaller than node's key continue left, the rest have node as floor candidate
+    size_t split = std::lower_bound(probes.begin() + lo, probes.begin() + hi, node->key) - probes.begin();
+    floorBatchRecursive(node->left, probes, lo, split, best, result);
+    floorBatchRecursive(node->right, probes, split, hi, node, result);
+}
+
+void AVLTree::ceilingBatchRecursive(AVLNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                                    const AVLNode* best, std::vector<std::optional<int>>& result) const {
+    if (lo >= hi) return;
+
+    // fell off the tree, every probe still in [lo, hi) shares the same ceiling
+    if (!node) {
+        for (size_t i = lo; i < hi; ++i) {
+            result[i] = best ? std::optional<int>(best->key) : std::nullopt;
+        }
+        return;
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    // probes up to node's key have node as ceiling candidate and continue left, the rest go right
+    size_t split = std::upper_bound(probes.begin() + lo, probes.begin() + hi, node->key) - probes.begin();
+    ceilingBatchRecursive(node->left, probes, lo, split, node, result);
+    ceilingBatchRecursive(node->right, probes, split, hi, best, result);
+}
+
 void AVLTree::inOrderTraversal(AVLNode* node, std::vector<AVLNode*>& nodes) const {
     if (!node) return;
+    TREE_STATS(stats.nodesVisited++);
     inOrderTraversal(node->left, nodes);
     nodes.push_back(node);
     inOrderTraversal(node->right, nodes);
@@ -209,12 +273,19 @@ AVLNode* AVLTree::buildBalancedTree(const std::vector<AVLNode*>& nodes, int star
     return node;
 }
 
+size_t AVLTree::countNodes(const AVLNode* node) const {
+    return node ? 1 + countNodes(node->left) + countNodes(node->right) : 0;
+}
+
 AVLNode* AVLTree::deleteRecursive(AVLNode *node, int key) {
     // delete
     if (!node) {
         return node; // key not found
     }
 
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
     // delete left subtree
     if (key < node->key) {
         node->left = deleteRecursive(node->left, key);
@@ -267,14 +338,34 @@ void AVLTree::destroyRecursive(AVLNode *node) {
 }
 
 // PUBLIC
-AVLTree::AVLTree() : root(nullptr) {}
+AVLTree::AVLTree() : root(nullptr), scratchPeak(0) {}
 
 AVLTree::~AVLTree() {
     destroyRecursive(root);
 }
 
+AVLTree::AVLTree(AVLTree&& other) noexcept
+    : root(std::exchange(other.root, nullptr)), scratchPeak(other.scratchPeak) {
+#ifdef HEAPURI_TREE_STATS
+    stats = other.stats;
+#endif
+}
+
+AVLTree& AVLTree::operator=(AVLTree&& other) noexcept {
+    if (this != &other) {
+        destroyRecursive(root);
+        root = std::exchange(other.root, nullptr);
+        scratchPeak = other.scratchPeak;
+#ifdef HEAPURI_TREE_STATS
+        stats = other.stats;
+#endif
+    }
+    return *this;
+}
+
 void AVLTree::insert(int key) {
     root = insertRecursive(root, key);
+    TREE_STATS(stats.maxDepth = std::max(stats.maxDepth, getHeight(root)));
 }
 
 void AVLTree::remove(int key) {
@@ -285,6 +376,53 @@ bool AVLTree::search(int key) const {
     return searchRecursive(root, key) != nullptr;
 }
 
+void AVLTree::searchBatch(const int* keys, size_t count, bool* found) const {
+    // each slot holds one in-flight lookup, a finished slot is refilled with the next key
+    const size_t width = std::min(SEARCH_BATCH_WIDTH, count);
+    const AVLNode* current[SEARCH_BATCH_WIDTH];
+    size_t index[SEARCH_BATCH_WIDTH];
+    size_t next = 0;
+    size_t active = width;
+
+    for (size_t s = 0; s < width; ++s) {
+        index[s] = next++;
+        current[s] = root;
+    }
+
+    while (active > 0) {
+        for (size_t s = 0; s < width; ++s) {
+            if (index[s] == count) continue; // slot drained
+
+            const AVLNode* node = current[s];
+            int key = keys[index[s]];
+
+            if (node) {
+                TREE_STATS(stats.nodesVisited++);
+                TREE_STATS(stats.comparisons++);
+            }
+            if (node && node->key != key) {
+                // descend one level and start loading the child while the other slots advance
+                node = key < node->key ? node->left : node->right;
+                if (node) {
+                    __builtin_prefetch(node);
+                }
+                current[s] = node;
+                continue;
+            }
+
+            // lookup finished (hit or fell off the tree)
+            found[index[s]] = node != nullptr;
+            if (next < count) {
+                index[s] = next++;
+                current[s] = root;
+            } else {
+                index[s] = count;
+                active--;
+            }
+        }
+    }
+}
+
 bool AVLTree::isEmpty() const {
     return root == nullptr;
 }
@@ -299,6 +437,7 @@ AVLTree AVLTree::join(const AVLTree& other) {
     
     inOrderTraversal(root, thisNodes);
     inOrderTraversal(other.root, otherNodes);
+    scratchPeak = std::max(scratchPeak, (thisNodes.capacity() + otherNodes.capacity() + mergedNodes.capacity()) * sizeof(AVLNode*));
     
     // merge the sorted arrays of nodes
     size_t i = 0, j = 0;
@@ -347,12 +486,107 @@ int AVLTree::ceiling(int key) const {
     return ceilingNode->key;
 }
 
+std::optional<int> AVLTree::tryFloor(int key) const {
+    AVLNode* node = root;
+    AVLNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) return node->key;
+        if (key < node->key) {
+            node = node->left;
+        } else {
+            best = node;
+            node = node->right;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> AVLTree::tryCeiling(int key) const {
+    AVLNode* node = root;
+    AVLNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) return node->key;
+        if (key > node->key) {
+            node = node->right;
+        } else {
+            best = node;
+            node = node->left;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> AVLTree::predecessor(int key) const {
+    AVLNode* node = root;
+    AVLNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key < key) {
+            best = node;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> AVLTree::successor(int key) const {
+    AVLNode* node = root;
+    AVLNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key > key) {
+            best = node;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::vector<std::optional<int>> AVLTree::floorBatch(const std::vector<int>& probes) const {
+    std::vector<std::optional<int>> result(probes.size());
+    floorBatchRecursive(root, probes, 0, probes.size(), nullptr, result);
+    return result;
+}
+
+std::vector<std::optional<int>> AVLTree::ceilingBatch(const std::vector<int>& probes) const {
+    std::vector<std::optional<int>> result(probes.size());
+    ceilingBatchRecursive(root, probes, 0, probes.size(), nullptr, result);
+    return result;
+}
+
 std::vector<int> AVLTree::rangeQuery(int x, int y) const {
     std::vector<int> result;
     rangeQueryRecursive(root, x, y, result);
     return result;
 }
 
+void AVLTree::loadSorted(const std::vector<int>& sortedKeys) {
+    destroyRecursive(root);
+    std::vector<AVLNode*> nodes;
+    nodes.reserve(sortedKeys.size());
+    for (int key : sortedKeys) {
+        nodes.push_back(new AVLNode(key));
+    }
+    root = buildBalancedTree(nodes, 0, static_cast<int>(nodes.size()) - 1);
+    scratchPeak = std::max(scratchPeak, nodes.capacity() * sizeof(AVLNode*));
+}
+
+void AVLTree::save(const std::string& path) const {
+    std::vector<int> keys;
+    rangeQueryRecursive(root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), keys);
+    TreeSnapshot::write(path, keys);
+}
+
 void AVLTree::printRange(int x, int y) const {
     std::vector<int> rangeValues = rangeQuery(x, y);
     
@@ -370,3 +604,25 @@ void AVLTree::printRange(int x, int y) const {
     }
     std::cout << std::endl;
 }
+
+size_t AVLTree::memoryUsage() const {
+    return countNodes(root) * sizeof(AVLNode);
+}
+
+size_t AVLTree::peakScratchBytes() const {
+    return scratchPeak;
+}
+
+TreeStats AVLTree::getStats() const {
+#ifdef HEAPURI_TREE_STATS
+    return stats;
+#else
+    return TreeStats();
+#endif
+}
+
+void AVLTree::resetStats() {
+#ifdef HEAPURI_TREE_STATS
+    stats = TreeStats();
+#endif
+}
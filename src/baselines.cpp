@@ -0,0 +1,190 @@
+#include "baselines.h"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+// layout of a std::set<int> node in the mainstream libraries: colour, three links, key
+struct SetNodeLayout {
+    int colour;
+    void* parent;
+    void* left;
+    void* right;
+    int key;
+};
+
+
+}
+
+// STD::SET
+StdSetTree::StdSetTree() : scratchPeak(0) {}
+
+void StdSetTree::insert(int key) {
+    keys.insert(key);
+}
+
+void StdSetTree::remove(int key) {
+    keys.erase(key);
+}
+
+bool StdSetTree::search(int key) const {
+    return keys.find(key) != keys.end();
+}
+
+bool StdSetTree::isEmpty() const {
+    return keys.empty();
+}
+
+StdSetTree StdSetTree::join(const StdSetTree& other) {
+    StdSetTree result;
+    std::vector<int> merged;
+    merged.reserve(keys.size() + other.keys.size());
+    std::set_union(keys.begin(), keys.end(), other.keys.begin(), other.keys.end(), std::back_inserter(merged));
+    scratchPeak = std::max(scratchPeak, merged.capacity() * sizeof(int));
+    result.keys.insert(merged.begin(), merged.end());
+    return result;
+}
+
+int StdSetTree::floor(int key) const {
+    std::optional<int> result = tryFloor(key);
+    if (!result) {
+        throw std::runtime_error("No floor value exists");
+    }
+    return *result;
+}
+
+int StdSetTree::ceiling(int key) const {
+    std::optional<int> result = tryCeiling(key);
+    if (!result) {
+        throw std::runtime_error("No ceiling value exists");
+    }
+    return *result;
+}
+
+std::optional<int> StdSetTree::tryFloor(int key) const {
+    auto it = keys.upper_bound(key);
+    if (it == keys.begin()) return std::nullopt;
+    return *std::prev(it);
+}
+
+std::optional<int> StdSetTree::tryCeiling(int key) const {
+    auto it = keys.lower_bound(key);
+    if (it == keys.end()) return std::nullopt;
+    return *it;
+}
+
+std::vector<int> StdSetTree::rangeQuery(int x, int y) const {
+    std::vector<int> result;
+    for (auto it = keys.lower_bound(x); it != keys.end() && *it <= y; ++it) {
+        result.push_back(*it);
+    }
+    return result;
+}
+
+void StdSetTree::loadSorted(const std::vector<int>& sortedKeys) {
+    // the end hint makes every insert amortized O(1) for ascending input
+    keys.clear();
+    for (int key : sortedKeys) {
+        keys.insert(keys.end(), key);
+    }
+}
+
+size_t StdSetTree::memoryUsage() const {
+    return keys.size() * sizeof(SetNodeLayout);
+}
+
+size_t StdSetTree::peakScratchBytes() const {
+    return scratchPeak;
+}
+
+TreeStats StdSetTree::getStats() const {
+    return TreeStats();
+}
+
+void StdSetTree::resetStats() {}
+
+// SORTED VECTOR
+SortedVectorTree::SortedVectorTree() : scratchPeak(0) {}
+
+void SortedVectorTree::insert(int key) {
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end() || *it != key) {
+        keys.insert(it, key);
+    }
+}
+
+void SortedVectorTree::remove(int key) {
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it != keys.end() && *it == key) {
+        keys.erase(it);
+    }
+}
+
+bool SortedVectorTree::search(int key) const {
+    return std::binary_search(keys.begin(), keys.end(), key);
+}
+
+bool SortedVectorTree::isEmpty() const {
+    return keys.empty();
+}
+
+SortedVectorTree SortedVectorTree::join(const SortedVectorTree& other) {
+    SortedVectorTree result;
+    result.keys.reserve(keys.size() + other.keys.size());
+    std::set_union(keys.begin(), keys.end(), other.keys.begin(), other.keys.end(), std::back_inserter(result.keys));
+    scratchPeak = std::max(scratchPeak, result.keys.capacity() * sizeof(int));
+    return result;
+}
+
+int SortedVectorTree::floor(int key) const {
+    std::optional<int> result = tryFloor(key);
+    if (!result) {
+        throw std::runtime_error("No floor value exists");
+    }
+    return *result;
+}
+
+int SortedVectorTree::ceiling(int key) const {
+    std::optional<int> result = tryCeiling(key);
+    if (!result) {
+        throw std::runtime_error("No ceiling value exists");
+    }
+    return *result;
+}
+
+std::optional<int> SortedVectorTree::tryFloor(int key) const {
+    auto it = std::upper_bound(keys.begin(), keys.end(), key);
+    if (it == keys.begin()) return std::nullopt;
+    return *std::prev(it);
+}
+
+std::optional<int> SortedVectorTree::tryCeiling(int key) const {
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end()) return std::nullopt;
+    return *it;
+}
+
+std::vector<int> SortedVectorTree::rangeQuery(int x, int y) const {
+    if (x > y) return {};
+    return std::vector<int>(std::lower_bound(keys.begin(), keys.end(), x),
+                            std::upper_bound(keys.begin(), keys.end(), y));
+}
+
+void SortedVectorTree::loadSorted(const std::vector<int>& sortedKeys) {
+    keys = sortedKeys;
+}
+
+size_t SortedVectorTree::memoryUsage() const {
+    return keys.capacity() * sizeof(int);
+}
+
+size_t SortedVectorTree::peakScratchBytes() const {
+    return scratchPeak;
+}
+
+TreeStats SortedVectorTree::getStats() const {
+    return TreeStats();
+}
+
+void SortedVectorTree::resetStats() {}
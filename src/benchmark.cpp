@@ -1,12 +1,105 @@
 #include <benchmark/benchmark.h>
 #include "avl.h"
 #include "scapegoat.h"
+#include "wavl.h"
+#include "weight_balanced.h"
+#include "treap.h"
+#include "splay.h"
+#include "histogram.h"
+#include "snapshot.h"
+#include "wal.h"
+#include "trace.h"
+#include "baselines.h"
+#include "concurrent.h"
+#include "perf_counters.h"
+#include "ordered_set.h"
 #include <random>
 #include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <vector>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <malloc.h>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
 
-std::mt19937 g_rng(std::random_device{}());
+// every generator draws from threadRng(), which seedThreadRng() reseeds at the start of each
+// benchmark from --seed, the thread index and the size argument: reruns with the same seed
+// see the same inputs, AVL and scapegoat benchmarks of the same size see identical ones,
+// and threads never share a generator
+uint64_t g_seed = std::random_device{}();
+
+std::mt19937& threadRng() {
+    thread_local std::mt19937 rng;
+    return rng;
+}
+
+// seeds of randomized engines (TreapTree), kept apart from threadRng() so that building one
+// does not shift the inputs the other engines see
+uint64_t& threadShapeSeed() {
+    thread_local uint64_t seed = 0;
+    return seed;
+}
+
+void seedThreadRng(const benchmark::State& state) {
+    uint64_t mixed = g_seed ^ (static_cast<uint64_t>(state.thread_index()) << 48) ^ static_cast<uint64_t>(state.range(0));
+    // splitmix64 finalizer, so that neighbouring sizes and threads get unrelated streams
+    mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ull;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebull;
+    mixed ^= mixed >> 31;
+    std::seed_seq seq{static_cast<uint32_t>(mixed), static_cast<uint32_t>(mixed >> 32)};
+    threadRng().seed(seq);
+    threadShapeSeed() = mixed;
+}
+
+// a fresh engine for the benchmark bodies, a treap takes the next shape seed of its thread
+template <typename Tree>
+Tree makeTree() {
+    if constexpr (std::is_same_v<Tree, TreapTree>) {
+        return Tree(threadShapeSeed()++);
+    } else {
+        return Tree();
+    }
+}
+
+// every benchmark body is a template runner written once and instantiated per engine;
+// ENGINE_BENCHMARK(Engine, Name, call) defines and registers BM_<Engine>_<Name>, which seeds
+// the thread's generator and makes the runner call given, e.g.
+//     ENGINE_BENCHMARK(AVL, RandomInsert, runRandomInsert<AVLTree>(state))->Range(8, 8<<10);
+// a new engine needs one such line per benchmark, and is checked against ordered_set.h below
+#define ENGINE_BENCHMARK(Engine, Name, ...)                      \
+    static void BM_##Engine##_##Name(benchmark::State& state) { \
+        seedThreadRng(state);                                   \
+        __VA_ARGS__;                                            \
+    }                                                           \
+    BENCHMARK(BM_##Engine##_##Name)
+
+static_assert(isOrderedSet<AVLTree>, "AVLTree is not an ordered set");
+static_assert(isOrderedSet<ScapegoatTree>, "ScapegoatTree is not an ordered set");
+static_assert(isOrderedSet<WAVLTree>, "WAVLTree is not an ordered set");
+static_assert(isOrderedSet<WeightBalancedTree>, "WeightBalancedTree is not an ordered set");
+static_assert(isOrderedSet<TreapTree>, "TreapTree is not an ordered set");
+static_assert(hasSplitMerge<TreapTree>, "TreapTree has no split/merge");
+static_assert(isOrderedSet<SplayTree>, "SplayTree is not an ordered set");
+static_assert(isOrderedSet<StdSetTree>, "StdSetTree is not an ordered set");
+static_assert(isOrderedSet<SortedVectorTree>, "SortedVectorTree is not an ordered set");
+static_assert(isOrderedSetView<TreeSnapshot>, "TreeSnapshot is not an ordered set view");
+static_assert(isMutableOrderedSet<MutexTree<AVLTree>>, "MutexTree is not a mutable ordered set");
+#ifndef HEAPURI_TREE_STATS // counted lookups race under a shared lock, see concurrent.h
+static_assert(isMutableOrderedSet<SharedMutexTree<AVLTree>>, "SharedMutexTree is not a mutable ordered set");
+static_assert(isMutableOrderedSet<ShardedTree<AVLTree>>, "ShardedTree is not a mutable ordered set");
+#endif
 
 // helper functions for benchmark setup
 std::vector<int> generateRandomKeys(size_t n, int min = 0, int max = 1000000) {
@@ -14,7 +107,7 @@ std::vector<int> generateRandomKeys(size_t n, int min = 0, int max = 1000000) {
     std::uniform_int_distribution<> distrib(min, max);
     
     for (size_t i = 0; i < n; ++i) {
-        keys[i] = distrib(g_rng);
+        keys[i] = distrib(threadRng());
     }
     
     return keys;
@@ -30,12 +123,12 @@ std::vector<int> generateRandomKeysLinear(size_t n, int min = 0, int max = 10000
         for (size_t i = 0; i < n; ++i) {
             keys[i] = min + static_cast<int>(i * ((max - min) / n));
         }
-        std::shuffle(keys.begin(), keys.end(), g_rng);
+        std::shuffle(keys.begin(), keys.end(), threadRng());
     } else {
         // fall back to standard random generation
         std::uniform_int_distribution<> distrib(min, max);
         for (size_t i = 0; i < n; ++i) {
-            keys[i] = distrib(g_rng);
+            keys[i] = distrib(threadRng());
         }
     }
     
@@ -86,244 +179,460 @@ std::vector<int> generateMixedPattern(size_t n) {
     return keys;
 }
 
-//------------------------------------------------------------------
-// 1. INSERTION BENCHMARKS
-//------------------------------------------------------------------
+// skewed generators - each returns n indices into a key space of `items` slots, the caller
+// maps slot i to its own key (the large-scale suite uses key 2 * i)
 
-// Sequential Insertion: Insert keys in ascending or descending order
-static void BM_AVL_SequentialInsertAscending(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateSequentialKeys(n, true);
-        AVLTree tree;
-        state.ResumeTiming();
-        
-        for (int key : keys) {
-            tree.insert(key);
-        }
+// Zipfian ranks in [0, items) following Gray et al. "Quickly generating billion-record
+// synthetic databases" as used by YCSB, rank 0 is the most popular; theta near 1 is heavily skewed
+class ZipfianGenerator {
+private:
+    uint64_t items;
+    double theta;
+    double zetan;
+    double alpha;
+    double eta;
+
+public:
+    ZipfianGenerator(uint64_t items, double theta = 0.99) : items(items), theta(theta) { // O(items)
+        zetan = 0;
+        for (uint64_t i = 1; i <= items; ++i) {
+            zetan += 1.0 / std::pow(static_cast<double>(i), theta);
+        }
+        double zeta2 = 1.0 + std::pow(0.5, theta);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1.0 - std::pow(2.0 / items, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+    }
+
+    template <typename Rng>
+    uint64_t operator()(Rng& rng) { // O(1)
+        double u = std::uniform_real_distribution<>(0.0, 1.0)(rng);
+        double uz = u * zetan;
+        if (uz < 1.0) return 0;
+        if (uz < 1.0 + std::pow(0.5, theta)) return 1;
+        return std::min(items - 1, static_cast<uint64_t>(items * std::pow(eta * u - eta + 1.0, alpha)));
     }
+};
+
+// spreads ranks over the key space so the popular keys are not neighbours in the tree,
+// a bijection on [0, items) because the multiplier is a prime larger than any items used here
+uint64_t scatterSlot(uint64_t rank, uint64_t items) {
+    return (rank * 2654435761ull) % items;
 }
-BENCHMARK(BM_AVL_SequentialInsertAscending)->Range(8, 8<<10)->Threads(8);
 
-static void BM_Scapegoat_SequentialInsertAscending(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateSequentialKeys(n, true);
-        ScapegoatTree tree;
-        state.ResumeTiming();
-        
-        for (int key : keys) {
-            tree.insert(key);
-        }
+std::vector<uint64_t> generateZipfianSlots(size_t n, uint64_t items, double theta = 0.99) {
+    ZipfianGenerator zipf(items, theta);
+    std::vector<uint64_t> slots(n);
+    for (size_t i = 0; i < n; ++i) {
+        slots[i] = scatterSlot(zipf(threadRng()), items);
     }
+    return slots;
 }
-BENCHMARK(BM_Scapegoat_SequentialInsertAscending)->Range(8, 8<<10)->Threads(8);
 
-static void BM_AVL_SequentialInsertDescending(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateSequentialKeys(n, false);
-        AVLTree tree;
-        state.ResumeTiming();
-        
-        for (int key : keys) {
-            tree.insert(key);
-        }
+// hotOpFraction of the draws hit a contiguous hot region of hotFraction of the key space
+std::vector<uint64_t> generateHotspotSlots(size_t n, uint64_t items, double hotFraction = 0.2,
+                                           double hotOpFraction = 0.8) {
+    uint64_t hotItems = std::max<uint64_t>(1, static_cast<uint64_t>(items * hotFraction));
+    uint64_t hotStart = std::uniform_int_distribution<uint64_t>(0, items - hotItems)(threadRng());
+    std::uniform_real_distribution<> coin(0.0, 1.0);
+    std::uniform_int_distribution<uint64_t> hot(hotStart, hotStart + hotItems - 1);
+    std::uniform_int_distribution<uint64_t> any(0, items - 1);
+    std::vector<uint64_t> slots(n);
+    for (size_t i = 0; i < n; ++i) {
+        slots[i] = coin(threadRng()) < hotOpFraction ? hot(threadRng()) : any(threadRng());
     }
+    return slots;
 }
-BENCHMARK(BM_AVL_SequentialInsertDescending)->Range(8, 8<<10)->Threads(8);
 
-static void BM_Scapegoat_SequentialInsertDescending(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateSequentialKeys(n, false);
-        ScapegoatTree tree;
-        state.ResumeTiming();
-        
-        for (int key : keys) {
-            tree.insert(key);
+// slots were filled in ascending order (timestamps, sequence numbers), draws favour the
+// newest ones with a Zipfian falloff - the YCSB "latest" distribution
+std::vector<uint64_t> generateLatestSlots(size_t n, uint64_t items, double theta = 0.99) {
+    ZipfianGenerator zipf(items, theta);
+    std::vector<uint64_t> slots(n);
+    for (size_t i = 0; i < n; ++i) {
+        slots[i] = items - 1 - zipf(threadRng());
+    }
+    return slots;
+}
+
+// uniform draws from a window of `window` slots that slides from the start to the end of
+// the key space over the n draws, as a scan of recent time-series data would
+std::vector<uint64_t> generateMovingWindowSlots(size_t n, uint64_t items, uint64_t window = 4096) {
+    window = std::min(window, items);
+    std::uniform_int_distribution<uint64_t> offset(0, window - 1);
+    std::vector<uint64_t> slots(n);
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t start = (items - window) * i / std::max<size_t>(1, n - 1);
+        slots[i] = start + offset(threadRng());
+    }
+    return slots;
+}
+
+// probes for floor/ceiling lookups where most queries have no answer
+// tree keys are expected in [1000001, 2000000], 90% of probes fall below that range
+// (floor misses) or above it (ceiling misses)
+std::vector<int> generateMissHeavyProbes(size_t n, bool below = true) {
+    size_t missCount = (n * 9) / 10;
+    std::vector<int> probes = below ? generateRandomKeysLinear(missCount, 0, 1000000)
+                                    : generateRandomKeysLinear(missCount, 2000001, 3000000);
+    std::vector<int> hits = generateRandomKeysLinear(n - missCount, 1000001, 2000000);
+    probes.insert(probes.end(), hits.begin(), hits.end());
+    std::shuffle(probes.begin(), probes.end(), threadRng());
+    return probes;
+}
+
+// report accumulated tree counters as per-iteration user counters
+// (no-op unless built with HEAPURI_TREE_STATS)
+void reportTreeStats(benchmark::State& state, const TreeStats& stats) {
+#ifdef HEAPURI_TREE_STATS
+    using benchmark::Counter;
+    state.counters["comparisons"] = Counter(stats.comparisons, Counter::kAvgIterations);
+    state.counters["nodes_visited"] = Counter(stats.nodesVisited, Counter::kAvgIterations);
+    state.counters["rot_LL"] = Counter(stats.rotationsLL, Counter::kAvgIterations);
+    state.counters["rot_LR"] = Counter(stats.rotationsLR, Counter::kAvgIterations);
+    state.counters["rot_RR"] = Counter(stats.rotationsRR, Counter::kAvgIterations);
+    state.counters["rot_RL"] = Counter(stats.rotationsRL, Counter::kAvgIterations);
+    state.counters["rebuilds"] = Counter(stats.rebuilds, Counter::kAvgIterations);
+    state.counters["nodes_rebuilt"] = Counter(stats.nodesRebuilt, Counter::kAvgIterations);
+    state.counters["max_depth"] = Counter(stats.maxDepth, Counter::kAvgThreads);
+#else
+    (void)state;
+    (void)stats;
+#endif
+}
+
+// forget the peak resident set so far, the next peakRssMB() covers only what follows; heap
+// pages freed by earlier benchmarks are handed back first, or they would stay resident and
+// count towards every later peak
+void resetPeakRss() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+}
+
+double peakRssMB() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stod(line.substr(6)) / 1024.0; // reported in kB
         }
     }
+    return 0.0;
+}
+
+// footprint of a tree holding keys: heap bytes per key by the tree's own accounting
+// (requested sizes only), the largest rebuild or join scratch buffer per key, and the process
+// peak RSS since resetPeakRss(), which adds allocator overhead and every benchmark thread
+template <typename Tree>
+void reportMemory(benchmark::State& state, const Tree& tree, size_t keys) {
+    using benchmark::Counter;
+    if (keys == 0) return;
+    state.counters["bytes_per_key"] = Counter(static_cast<double>(tree.memoryUsage()) / keys, Counter::kAvgThreads);
+    state.counters["scratch_bytes_per_key"] = Counter(static_cast<double>(tree.peakScratchBytes()) / keys,
+                                                      Counter::kAvgThreads);
+    state.counters["peak_rss_MB"] = Counter(peakRssMB(), Counter::kAvgThreads);
 }
-BENCHMARK(BM_Scapegoat_SequentialInsertDescending)->Range(8, 8<<10)->Threads(8);
 
-static void BM_AVL_RandomInsert(benchmark::State& state) {
+bool g_perfCounters = false; // set by --perf_counters
+
+// hardware counters over the timed part of a benchmark: resume() right after ResumeTiming,
+// pause() before the next PauseTiming, report() divides the counts by the operations timed;
+// does nothing unless the binary runs with --perf_counters
+class PerfScope {
+private:
+    std::unique_ptr<PerfCounters> counters;
+
+public:
+    PerfScope() : counters(g_perfCounters ? std::make_unique<PerfCounters>() : nullptr) {}
+
+    void resume() {
+        if (counters) counters->start();
+    }
+
+    void pause() {
+        if (counters) counters->stop();
+    }
+
+    void report(benchmark::State& state, uint64_t operations) {
+        if (!counters || operations == 0) return;
+        for (int i = 0; i < PERF_EVENT_COUNT; ++i) {
+            PerfEvent event = static_cast<PerfEvent>(i);
+            if (counters->available(event)) {
+                state.counters[std::string(PerfCounters::name(event)) + "_per_op"] = benchmark::Counter(
+                    static_cast<double>(counters->count(event)) / operations, benchmark::Counter::kAvgThreads);
+            }
+        }
+    }
+};
+
+//------------------------------------------------------------------
+// 1. INSERTION BENCHMARKS
+//------------------------------------------------------------------
+
+// Sequential Insertion: Insert keys in ascending or descending order
+template <typename Tree>
+void runSequentialInsertAscending(benchmark::State& state) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateSequentialKeys(n, true);
+    resetPeakRss();
     for (auto _ : state) {
         state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        AVLTree tree;
+        Tree tree = makeTree<Tree>();
+        tree.resetStats();
         state.ResumeTiming();
         
         for (int key : keys) {
             tree.insert(key);
         }
+        stats += tree.getStats();
+    }
+    // footprint of the tree the loop builds, measured on one more build outside the timing
+    Tree built = makeTree<Tree>();
+    for (int key : keys) {
+        built.insert(key);
     }
+    reportMemory(state, built, n);
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_AVL_RandomInsert)->Range(8, 8<<10)->Threads(8);
 
-static void BM_Scapegoat_RandomInsert(benchmark::State& state) {
+ENGINE_BENCHMARK(AVL, SequentialInsertAscending, runSequentialInsertAscending<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, SequentialInsertAscending, runSequentialInsertAscending<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, SequentialInsertAscending, runSequentialInsertAscending<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, SequentialInsertAscending, runSequentialInsertAscending<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, SequentialInsertAscending, runSequentialInsertAscending<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, SequentialInsertAscending, runSequentialInsertAscending<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, SequentialInsertAscending, runSequentialInsertAscending<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, SequentialInsertAscending, runSequentialInsertAscending<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
+
+template <typename Tree>
+void runSequentialInsertDescending(benchmark::State& state) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateSequentialKeys(n, false);
+    resetPeakRss();
     for (auto _ : state) {
         state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        ScapegoatTree tree;
+        Tree tree = makeTree<Tree>();
+        tree.resetStats();
         state.ResumeTiming();
         
         for (int key : keys) {
             tree.insert(key);
         }
+        stats += tree.getStats();
+    }
+    // footprint of the tree the loop builds, measured on one more build outside the timing
+    Tree built = makeTree<Tree>();
+    for (int key : keys) {
+        built.insert(key);
     }
+    reportMemory(state, built, n);
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_Scapegoat_RandomInsert)->Range(8, 8<<10)->Threads(8);
 
-static void BM_AVL_MixedPatternInsert(benchmark::State& state) {
+ENGINE_BENCHMARK(AVL, SequentialInsertDescending, runSequentialInsertDescending<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, SequentialInsertDescending, runSequentialInsertDescending<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, SequentialInsertDescending, runSequentialInsertDescending<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, SequentialInsertDescending, runSequentialInsertDescending<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, SequentialInsertDescending, runSequentialInsertDescending<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, SequentialInsertDescending, runSequentialInsertDescending<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, SequentialInsertDescending, runSequentialInsertDescending<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, SequentialInsertDescending, runSequentialInsertDescending<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
+
+template <typename Tree>
+void runRandomInsert(benchmark::State& state) {
+    TreeStats stats;
+    PerfScope perf;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n);
+    resetPeakRss();
     for (auto _ : state) {
         state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateMixedPattern(n);
-        AVLTree tree;
+        Tree tree = makeTree<Tree>();
+        tree.resetStats();
         state.ResumeTiming();
+        perf.resume();
         
         for (int key : keys) {
             tree.insert(key);
         }
+        perf.pause();
+        stats += tree.getStats();
+    }
+    perf.report(state, state.iterations() * (n));
+    // footprint of the tree the loop builds, measured on one more build outside the timing
+    Tree built = makeTree<Tree>();
+    for (int key : keys) {
+        built.insert(key);
     }
+    reportMemory(state, built, n);
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_AVL_MixedPatternInsert)->Range(8, 8<<10)->Threads(8);
 
-static void BM_Scapegoat_MixedPatternInsert(benchmark::State& state) {
+ENGINE_BENCHMARK(AVL, RandomInsert, runRandomInsert<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, RandomInsert, runRandomInsert<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, RandomInsert, runRandomInsert<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, RandomInsert, runRandomInsert<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, RandomInsert, runRandomInsert<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, RandomInsert, runRandomInsert<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, RandomInsert, runRandomInsert<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, RandomInsert, runRandomInsert<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
+
+template <typename Tree>
+void runMixedPatternInsert(benchmark::State& state) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateMixedPattern(n);
+    resetPeakRss();
     for (auto _ : state) {
         state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateMixedPattern(n);
-        ScapegoatTree tree;
+        Tree tree = makeTree<Tree>();
+        tree.resetStats();
         state.ResumeTiming();
         
         for (int key : keys) {
             tree.insert(key);
         }
+        stats += tree.getStats();
+    }
+    // footprint of the tree the loop builds, measured on one more build outside the timing
+    Tree built = makeTree<Tree>();
+    for (int key : keys) {
+        built.insert(key);
     }
+    reportMemory(state, built, n);
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_Scapegoat_MixedPatternInsert)->Range(8, 8<<10)->Threads(8);
+
+ENGINE_BENCHMARK(AVL, MixedPatternInsert, runMixedPatternInsert<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, MixedPatternInsert, runMixedPatternInsert<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, MixedPatternInsert, runMixedPatternInsert<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, MixedPatternInsert, runMixedPatternInsert<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, MixedPatternInsert, runMixedPatternInsert<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, MixedPatternInsert, runMixedPatternInsert<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, MixedPatternInsert, runMixedPatternInsert<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, MixedPatternInsert, runMixedPatternInsert<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
 
 //------------------------------------------------------------------
 // 2. DELETION BENCHMARKS
 //------------------------------------------------------------------
 
 // Random Deletion: randomly delete elements
-static void BM_AVL_RandomDeletion(benchmark::State& state) {
+template <typename Tree>
+void runRandomDeletion(benchmark::State& state) {
+    TreeStats stats;
+    PerfScope perf;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n);
+    resetPeakRss();
     for (auto _ : state) {
         state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        AVLTree tree;
+        Tree tree = makeTree<Tree>();
         // insert all keys
         for (int key : keys) {
             tree.insert(key);
         }
         // shuffle keys for random deletion order
-        std::shuffle(keys.begin(), keys.end(), g_rng);
+        std::shuffle(keys.begin(), keys.end(), threadRng());
+        tree.resetStats();
         state.ResumeTiming();
+        perf.resume();
         
         // delete all keys in random order
         for (int key : keys) {
             tree.remove(key);
         }
+        perf.pause();
+        stats += tree.getStats();
     }
-}
-BENCHMARK(BM_AVL_RandomDeletion)->Range(8, 8<<10)->Threads(8);
-
-static void BM_Scapegoat_RandomDeletion(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        ScapegoatTree tree;
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        // shuffle keys for random deletion order
-        std::shuffle(keys.begin(), keys.end(), g_rng);
-        state.ResumeTiming();
-        
-        // delete all keys in random order
-        for (int key : keys) {
-            tree.remove(key);
-        }
+    perf.report(state, state.iterations() * (n));
+    // footprint of the tree the loop deletes from, measured on one more build outside the timing
+    Tree built = makeTree<Tree>();
+    for (int key : keys) {
+        built.insert(key);
     }
+    reportMemory(state, built, n);
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_Scapegoat_RandomDeletion)->Range(8, 8<<9)->Threads(8);
+
+ENGINE_BENCHMARK(AVL, RandomDeletion, runRandomDeletion<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, RandomDeletion, runRandomDeletion<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, RandomDeletion, runRandomDeletion<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, RandomDeletion, runRandomDeletion<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, RandomDeletion, runRandomDeletion<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, RandomDeletion, runRandomDeletion<ScapegoatTree>(state))->Range(8, 8<<9)->Threads(8);
+ENGINE_BENCHMARK(StdSet, RandomDeletion, runRandomDeletion<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, RandomDeletion, runRandomDeletion<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
 
 // Sequential Deletion: delete elements in order (forward)
-static void BM_AVL_SequentialDeletion(benchmark::State& state) {
+template <typename Tree>
+void runSequentialDeletion(benchmark::State& state) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n);
+    // sorted copy for sequential deletion, the tree is still built in random order
+    std::vector<int> sortedKeys = keys;
+    std::sort(sortedKeys.begin(), sortedKeys.end());
+    resetPeakRss();
     for (auto _ : state) {
         state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        AVLTree tree;
+        Tree tree = makeTree<Tree>();
         // insert all keys
         for (int key : keys) {
             tree.insert(key);
         }
-        // sort keys for sequential deletion
-        std::sort(keys.begin(), keys.end());
+        tree.resetStats();
         state.ResumeTiming();
         
         // delete all keys in sequential order
-        for (int key : keys) {
+        for (int key : sortedKeys) {
             tree.remove(key);
         }
+        stats += tree.getStats();
     }
-}
-BENCHMARK(BM_AVL_SequentialDeletion)->Range(8, 8<<10)->Threads(8);
-
-static void BM_Scapegoat_SequentialDeletion(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        ScapegoatTree tree;
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        // sort keys for sequential deletion
-        std::sort(keys.begin(), keys.end());
-        state.ResumeTiming();
-        
-        // delete all keys in sequential order
-        for (int key : keys) {
-            tree.remove(key);
-        }
+    // footprint of the tree the loop deletes from, measured on one more build outside the timing
+    Tree built = makeTree<Tree>();
+    for (int key : keys) {
+        built.insert(key);
     }
+    reportMemory(state, built, n);
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_Scapegoat_SequentialDeletion)->Range(8, 8<<9)->Threads(8);
+
+ENGINE_BENCHMARK(AVL, SequentialDeletion, runSequentialDeletion<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, SequentialDeletion, runSequentialDeletion<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, SequentialDeletion, runSequentialDeletion<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, SequentialDeletion, runSequentialDeletion<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, SequentialDeletion, runSequentialDeletion<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, SequentialDeletion, runSequentialDeletion<ScapegoatTree>(state))->Range(8, 8<<9)->Threads(8);
+ENGINE_BENCHMARK(StdSet, SequentialDeletion, runSequentialDeletion<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, SequentialDeletion, runSequentialDeletion<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
 
 // Delete-Heavy Workload: many deletions with few insertions
-// highlight Scapegoat's rebuild cost
-static void BM_AVL_DeleteHeavyWorkload(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        AVLTree tree;
+// highlight Scapegoat's rebuild cost; setup, if given, configures each fresh tree before it is filled
+template <typename Tree>
+void runDeleteHeavyWorkload(benchmark::State& state, void (*setup)(Tree&) = nullptr) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n);
+    // select 80% of keys for deletion
+    size_t deleteCount = (n * 4) / 5;
+    std::vector<int> keysToDelete(keys.begin(), keys.begin() + deleteCount);
+    // generate some new keys to insert (20% of original size)
+    std::vector<int> newKeys = generateRandomKeysLinear(n / 5, 1000001, 2000000);
+    auto fill = [&](Tree& tree) {
+        if (setup) {
+            setup(tree);
+        }
         // insert all keys
         for (int key : keys) {
             tree.insert(key);
         }
-        // select 80% of keys for deletion
-        size_t deleteCount = (n * 4) / 5;
-        std::vector<int> keysToDelete(keys.begin(), keys.begin() + deleteCount);
-        // generate some new keys to insert (20% of original size)
-        std::vector<int> newKeys = generateRandomKeysLinear(n / 5, 1000001, 2000000);
-        state.ResumeTiming();
-        
+    };
+    auto workload = [&](Tree& tree) {
         // delete 80% of keys
         for (int key : keysToDelete) {
             tree.remove(key);
@@ -333,175 +642,155 @@ static void BM_AVL_DeleteHeavyWorkload(benchmark::State& state) {
         for (int key : newKeys) {
             tree.insert(key);
         }
-    }
-}
-BENCHMARK(BM_AVL_DeleteHeavyWorkload)->Range(8, 8<<10)->Threads(8);
-
-static void BM_Scapegoat_DeleteHeavyWorkload(benchmark::State& state) {
+    };
+    resetPeakRss();
     for (auto _ : state) {
         state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        ScapegoatTree tree;
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        // select 80% of keys for deletion
-        size_t deleteCount = (n * 4) / 5;
-        std::vector<int> keysToDelete(keys.begin(), keys.begin() + deleteCount);
-        // generate some new keys to insert (20% of original size)
-        std::vector<int> newKeys = generateRandomKeysLinear(n / 5, 1000001, 2000000);
+        Tree tree = makeTree<Tree>();
+        fill(tree);
+        tree.resetStats();
         state.ResumeTiming();
         
-        // delete 80% of keys
-        for (int key : keysToDelete) {
-            tree.remove(key);
-        }
-        
-        // insert 20% new keys
-        for (int key : newKeys) {
-            tree.insert(key);
-        }
+        workload(tree);
+        stats += tree.getStats();
     }
+    // footprint of the tree the loop leaves behind (tombstones included), measured on one more
+    // run outside the timing
+    Tree built = makeTree<Tree>();
+    fill(built);
+    workload(built);
+    reportMemory(state, built, n - deleteCount + newKeys.size());
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_Scapegoat_DeleteHeavyWorkload)->Range(8, 8<<9)->Threads(8);
+
+ENGINE_BENCHMARK(AVL, DeleteHeavyWorkload, runDeleteHeavyWorkload<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, DeleteHeavyWorkload, runDeleteHeavyWorkload<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, DeleteHeavyWorkload, runDeleteHeavyWorkload<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, DeleteHeavyWorkload, runDeleteHeavyWorkload<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, DeleteHeavyWorkload, runDeleteHeavyWorkload<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, DeleteHeavyWorkload, runDeleteHeavyWorkload<ScapegoatTree>(state))->Range(8, 8<<9)->Threads(8);
+ENGINE_BENCHMARK(StdSet, DeleteHeavyWorkload, runDeleteHeavyWorkload<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, DeleteHeavyWorkload, runDeleteHeavyWorkload<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
+
+// same workload with lazy deletion: removes leave tombstones, purged by one rebuild at a time
+ENGINE_BENCHMARK(Scapegoat, DeleteHeavyWorkloadLazy, runDeleteHeavyWorkload<ScapegoatTree>(state, [](ScapegoatTree& tree) {
+    tree.setLazyDelete(true);
+}))->Range(8, 8<<9)->Threads(8);
 
 //------------------------------------------------------------------
 // 3. SEARCH BENCHMARKS
 //------------------------------------------------------------------
 
 // Successful Search: find elements known to be in the tree
-static void BM_AVL_SuccessfulSearch(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        AVLTree tree;
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        // shuffle keys for random search order
-        std::shuffle(keys.begin(), keys.end(), g_rng);
-        
-        // take 20% of keys for search
-        size_t searchCount = n / 5;
-        std::vector<int> searchKeys(keys.begin(), keys.begin() + searchCount);
-        state.ResumeTiming();
-        
-        // search for keys (all should be found)
-        for (int key : searchKeys) {
-            benchmark::DoNotOptimize(tree.search(key));
-        }
+template <typename Tree>
+void runSuccessfulSearch(benchmark::State& state) {
+    PerfScope perf;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n);
+    resetPeakRss();
+    Tree tree = makeTree<Tree>();
+    // insert all keys
+    for (int key : keys) {
+        tree.insert(key);
     }
-}
-BENCHMARK(BM_AVL_SuccessfulSearch)->Range(8, 8<<10)->Threads(8);
-
-static void BM_Scapegoat_SuccessfulSearch(benchmark::State& state) {
+    // shuffle keys for random search order
+    std::shuffle(keys.begin(), keys.end(), threadRng());
+    
+    // take 20% of keys for search
+    size_t searchCount = n / 5;
+    std::vector<int> searchKeys(keys.begin(), keys.begin() + searchCount);
+    tree.resetStats();
+    perf.resume();
     for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        ScapegoatTree tree;
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        // shuffle keys for random search order
-        std::shuffle(keys.begin(), keys.end(), g_rng);
-        
-        // take 20% of keys for search
-        size_t searchCount = n / 5;
-        std::vector<int> searchKeys(keys.begin(), keys.begin() + searchCount);
-        state.ResumeTiming();
-        
         // search for keys (all should be found)
         for (int key : searchKeys) {
             benchmark::DoNotOptimize(tree.search(key));
         }
     }
+    perf.pause();
+    perf.report(state, state.iterations() * (n / 5));
+    reportMemory(state, tree, n);
+    reportTreeStats(state, tree.getStats());
 }
-BENCHMARK(BM_Scapegoat_SuccessfulSearch)->Range(8, 8<<10)->Threads(8);
+
+ENGINE_BENCHMARK(AVL, SuccessfulSearch, runSuccessfulSearch<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, SuccessfulSearch, runSuccessfulSearch<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, SuccessfulSearch, runSuccessfulSearch<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, SuccessfulSearch, runSuccessfulSearch<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, SuccessfulSearch, runSuccessfulSearch<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, SuccessfulSearch, runSuccessfulSearch<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, SuccessfulSearch, runSuccessfulSearch<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, SuccessfulSearch, runSuccessfulSearch<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
 
 // Unsuccessful Search: Search for elements not in the tree
-static void BM_AVL_UnsuccessfulSearch(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
-        AVLTree tree;
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        
-        // generate keys that are not in the tree
-        std::vector<int> nonExistingKeys = generateRandomKeysLinear(n / 5, 1000001, 2000000);
-        state.ResumeTiming();
-        
-        // search for non-existing keys
-        for (int key : nonExistingKeys) {
-            benchmark::DoNotOptimize(tree.search(key));
-        }
+template <typename Tree>
+void runUnsuccessfulSearch(benchmark::State& state) {
+    PerfScope perf;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
+    resetPeakRss();
+    Tree tree = makeTree<Tree>();
+    // insert all keys
+    for (int key : keys) {
+        tree.insert(key);
     }
-}
-BENCHMARK(BM_AVL_UnsuccessfulSearch)->Range(8, 8<<10)->Threads(8);
-
-static void BM_Scapegoat_UnsuccessfulSearch(benchmark::State& state) {
+    
+    // generate keys that are not in the tree
+    std::vector<int> nonExistingKeys = generateRandomKeysLinear(n / 5, 1000001, 2000000);
+    tree.resetStats();
+    perf.resume();
     for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
-        ScapegoatTree tree;
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        
-        // generate keys that are not in the tree
-        std::vector<int> nonExistingKeys = generateRandomKeysLinear(n / 5, 1000001, 2000000);
-        state.ResumeTiming();
-        
         // search for non-existing keys
         for (int key : nonExistingKeys) {
             benchmark::DoNotOptimize(tree.search(key));
         }
     }
+    perf.pause();
+    perf.report(state, state.iterations() * (n / 5));
+    reportMemory(state, tree, n);
+    reportTreeStats(state, tree.getStats());
 }
-BENCHMARK(BM_Scapegoat_UnsuccessfulSearch)->Range(8, 8<<10)->Threads(8);
+
+ENGINE_BENCHMARK(AVL, UnsuccessfulSearch, runUnsuccessfulSearch<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, UnsuccessfulSearch, runUnsuccessfulSearch<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, UnsuccessfulSearch, runUnsuccessfulSearch<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, UnsuccessfulSearch, runUnsuccessfulSearch<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, UnsuccessfulSearch, runUnsuccessfulSearch<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, UnsuccessfulSearch, runUnsuccessfulSearch<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, UnsuccessfulSearch, runUnsuccessfulSearch<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, UnsuccessfulSearch, runUnsuccessfulSearch<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
 
 // Search Distribution: test search performance based on key distribution
 // test depth-based search in balanced vs slightly imbalanced trees
-static void BM_AVL_SearchDistribution(benchmark::State& state) {
+template <typename Tree>
+void runSearchDistribution(benchmark::State& state) {
+    size_t n = state.range(0);
+    // create skewed data where 80% of keys are in a narrow range
+    // and 20% are spread wider
+    std::vector<int> keys;
+    keys.reserve(n);
+    
+    // 80% of keys in narrow range [0, 1000]
+    size_t narrowCount = (n * 4) / 5;
+    std::vector<int> narrowKeys = generateRandomKeysLinear(narrowCount, 0, 1000);
+    keys.insert(keys.end(), narrowKeys.begin(), narrowKeys.end());
+    
+    // 20% of keys in wider range [1001, 1000000]
+    std::vector<int> wideKeys = generateRandomKeysLinear(n - narrowCount, 1001, 1000000);
+    keys.insert(keys.end(), wideKeys.begin(), wideKeys.end());
+    
+    resetPeakRss();
+    Tree tree = makeTree<Tree>();
+    // insert all keys
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    
+    // create search keys with same distribution
+    std::vector<int> searchKeysNarrow = generateRandomKeysLinear(100, 0, 1000);
+    std::vector<int> searchKeysWide = generateRandomKeysLinear(100, 1001, 1000000);
+    tree.resetStats();
     for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        // create skewed data where 80% of keys are in a narrow range
-        // and 20% are spread wider
-        std::vector<int> keys;
-        keys.reserve(n);
-        
-        // 80% of keys in narrow range [0, 1000]
-        size_t narrowCount = (n * 4) / 5;
-        std::vector<int> narrowKeys = generateRandomKeysLinear(narrowCount, 0, 1000);
-        keys.insert(keys.end(), narrowKeys.begin(), narrowKeys.end());
-        
-        // 20% of keys in wider range [1001, 1000000]
-        std::vector<int> wideKeys = generateRandomKeysLinear(n - narrowCount, 1001, 1000000);
-        keys.insert(keys.end(), wideKeys.begin(), wideKeys.end());
-        
-        AVLTree tree;
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        
-        // create search keys with same distribution
-        std::vector<int> searchKeysNarrow = generateRandomKeysLinear(100, 0, 1000);
-        std::vector<int> searchKeysWide = generateRandomKeysLinear(100, 1001, 1000000);
-        state.ResumeTiming();
-        
         // search in narrow range (higher probability of success)
         for (int key : searchKeysNarrow) {
             benchmark::DoNotOptimize(tree.search(key));
@@ -512,314 +801,491 @@ static void BM_AVL_SearchDistribution(benchmark::State& state) {
             benchmark::DoNotOptimize(tree.search(key));
         }
     }
+    // the narrow range holds far fewer distinct keys than were inserted
+    std::sort(keys.begin(), keys.end());
+    reportMemory(state, tree, std::unique(keys.begin(), keys.end()) - keys.begin());
+    reportTreeStats(state, tree.getStats());
 }
-BENCHMARK(BM_AVL_SearchDistribution)->Range(8, 8<<10)->Threads(8);
 
-static void BM_Scapegoat_SearchDistribution(benchmark::State& state) {
+ENGINE_BENCHMARK(AVL, SearchDistribution, runSearchDistribution<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, SearchDistribution, runSearchDistribution<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, SearchDistribution, runSearchDistribution<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, SearchDistribution, runSearchDistribution<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, SearchDistribution, runSearchDistribution<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, SearchDistribution, runSearchDistribution<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, SearchDistribution, runSearchDistribution<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, SearchDistribution, runSearchDistribution<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
+
+// Sequential Search: every key looked up once in ascending order per iteration, as a scan over
+// the index would; a splay tree does the whole pass in O(n) (sequential access theorem)
+template <typename Tree>
+void runSequentialSearch(benchmark::State& state) {
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 0, 1 << 30);
+    Tree tree = makeTree<Tree>();
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    tree.resetStats();
     for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        // create skewed data where 80% of keys are in a narrow range
-        // and 20% are spread wider
-        std::vector<int> keys;
-        keys.reserve(n);
-        
-        // 80% of keys in narrow range [0, 1000]
-        size_t narrowCount = (n * 4) / 5;
-        std::vector<int> narrowKeys = generateRandomKeysLinear(narrowCount, 0, 1000);
-        keys.insert(keys.end(), narrowKeys.begin(), narrowKeys.end());
-        
-        // 20% of keys in wider range [1001, 1000000]
-        std::vector<int> wideKeys = generateRandomKeysLinear(n - narrowCount, 1001, 1000000);
-        keys.insert(keys.end(), wideKeys.begin(), wideKeys.end());
-        
-        ScapegoatTree tree;
-        // insert all keys
         for (int key : keys) {
-            tree.insert(key);
-        }
-        
-        // create search keys with same distribution
-        std::vector<int> searchKeysNarrow = generateRandomKeysLinear(100, 0, 1000);
-        std::vector<int> searchKeysWide = generateRandomKeysLinear(100, 1001, 1000000);
-        state.ResumeTiming();
-        
-        // search in narrow range (higher probability of success)
-        for (int key : searchKeysNarrow) {
             benchmark::DoNotOptimize(tree.search(key));
         }
-        
-        // search in wide range (lower probability of success)
-        for (int key : searchKeysWide) {
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    reportTreeStats(state, tree.getStats());
+}
+
+ENGINE_BENCHMARK(AVL, SequentialSearch, runSequentialSearch<AVLTree>(state))->Range(1<<10, 1<<20);
+ENGINE_BENCHMARK(WAVL, SequentialSearch, runSequentialSearch<WAVLTree>(state))->Range(1<<10, 1<<20);
+ENGINE_BENCHMARK(Scapegoat, SequentialSearch, runSequentialSearch<ScapegoatTree>(state))->Range(1<<10, 1<<20);
+ENGINE_BENCHMARK(Splay, SequentialSearch, runSequentialSearch<SplayTree>(state))->Range(1<<10, 1<<20);
+
+// Large Search: serial vs interleaved (prefetching) lookups on trees larger than the last-level cache
+// the tree is built once per run, only the lookups are timed
+template <typename Tree>
+void runLargeSearch(benchmark::State& state) {
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 0, 1 << 30);
+    // loaded in O(n), so that inserting a million keys does not dominate setup for any engine
+    std::vector<int> sortedKeys(keys);
+    std::sort(sortedKeys.begin(), sortedKeys.end());
+    Tree tree = makeTree<Tree>();
+    tree.loadSorted(sortedKeys);
+    // half hits, half misses, in random order
+    std::shuffle(keys.begin(), keys.end(), threadRng());
+    std::vector<int> searchKeys(keys.begin(), keys.begin() + std::min<size_t>(n, 1 << 13));
+    std::vector<int> missKeys = generateRandomKeysLinear(searchKeys.size(), (1 << 30) + 1, std::numeric_limits<int>::max());
+    searchKeys.insert(searchKeys.end(), missKeys.begin(), missKeys.end());
+    std::shuffle(searchKeys.begin(), searchKeys.end(), threadRng());
+    
+    tree.resetStats();
+    for (auto _ : state) {
+        for (int key : searchKeys) {
             benchmark::DoNotOptimize(tree.search(key));
         }
     }
+    state.SetItemsProcessed(state.iterations() * searchKeys.size());
+    reportTreeStats(state, tree.getStats());
+}
+
+template <typename Tree>
+void runLargeSearchBatch(benchmark::State& state) {
+    static_assert(hasSearchBatch<Tree>, "runLargeSearchBatch needs searchBatch");
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 0, 1 << 30);
+    // loaded in O(n), so that inserting a million keys does not dominate setup for any engine
+    std::vector<int> sortedKeys(keys);
+    std::sort(sortedKeys.begin(), sortedKeys.end());
+    Tree tree = makeTree<Tree>();
+    tree.loadSorted(sortedKeys);
+    // half hits, half misses, in random order
+    std::shuffle(keys.begin(), keys.end(), threadRng());
+    std::vector<int> searchKeys(keys.begin(), keys.begin() + std::min<size_t>(n, 1 << 13));
+    std::vector<int> missKeys = generateRandomKeysLinear(searchKeys.size(), (1 << 30) + 1, std::numeric_limits<int>::max());
+    searchKeys.insert(searchKeys.end(), missKeys.begin(), missKeys.end());
+    std::shuffle(searchKeys.begin(), searchKeys.end(), threadRng());
+    std::unique_ptr<bool[]> found(new bool[searchKeys.size()]);
+    
+    tree.resetStats();
+    for (auto _ : state) {
+        tree.searchBatch(searchKeys.data(), searchKeys.size(), found.get());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * searchKeys.size());
+    reportTreeStats(state, tree.getStats());
 }
-BENCHMARK(BM_Scapegoat_SearchDistribution)->Range(8, 8<<10)->Threads(8);
+
+ENGINE_BENCHMARK(AVL, LargeSearch, runLargeSearch<AVLTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(WAVL, LargeSearch, runLargeSearch<WAVLTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, LargeSearch, runLargeSearch<WeightBalancedTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(Treap, LargeSearch, runLargeSearch<TreapTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(Splay, LargeSearch, runLargeSearch<SplayTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(AVL, LargeSearchBatch, runLargeSearchBatch<AVLTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(WAVL, LargeSearchBatch, runLargeSearchBatch<WAVLTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, LargeSearchBatch, runLargeSearchBatch<WeightBalancedTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(Treap, LargeSearchBatch, runLargeSearchBatch<TreapTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, LargeSearch, runLargeSearch<ScapegoatTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, LargeSearchBatch, runLargeSearchBatch<ScapegoatTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(StdSet, LargeSearch, runLargeSearch<StdSetTree>(state))->Range(1<<12, 1<<20)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, LargeSearch, runLargeSearch<SortedVectorTree>(state))->Range(1<<12, 1<<20)->Threads(8);
 
 //------------------------------------------------------------------
 // 4. RANGE QUERY BENCHMARKS
 //------------------------------------------------------------------
 
 // Small Range: query a small subset of the tree (5% of keys)
-static void BM_AVL_SmallRangeQuery(benchmark::State& state) {
+template <typename Tree>
+void runSmallRangeQuery(benchmark::State& state) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
+    resetPeakRss();
+    Tree tree = makeTree<Tree>();
+    
+    // the query does not change the tree, build it once
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    
+    // sort keys to know the range
+    std::sort(keys.begin(), keys.end());
+    
+    // select a small range (approximately 5% of keys)
+    size_t rangeSize = n / 20;
+    size_t startIdx = n / 2 - rangeSize / 2; // Center the range
+    int rangeStart = keys[startIdx];
+    int rangeEnd = keys[startIdx + rangeSize - 1];
+    
     for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
-        AVLTree tree;
-        
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        
-        // sort keys to know the range
-        std::sort(keys.begin(), keys.end());
-        
-        // select a small range (approximately 5% of keys)
-        size_t rangeSize = n / 20;
-        size_t startIdx = n / 2 - rangeSize / 2; // Center the range
-        int rangeStart = keys[startIdx];
-        int rangeEnd = keys[startIdx + rangeSize - 1];
-        
-        state.ResumeTiming();
+        tree.resetStats();
         
         // perform range query
         std::vector<int> result = tree.rangeQuery(rangeStart, rangeEnd);
         benchmark::DoNotOptimize(result);
+        stats += tree.getStats();
     }
+    reportMemory(state, tree, n);
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_AVL_SmallRangeQuery)->Range(8, 8<<10)->Threads(8);
 
-static void BM_Scapegoat_SmallRangeQuery(benchmark::State& state) {
+ENGINE_BENCHMARK(AVL, SmallRangeQuery, runSmallRangeQuery<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, SmallRangeQuery, runSmallRangeQuery<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, SmallRangeQuery, runSmallRangeQuery<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, SmallRangeQuery, runSmallRangeQuery<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, SmallRangeQuery, runSmallRangeQuery<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, SmallRangeQuery, runSmallRangeQuery<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, SmallRangeQuery, runSmallRangeQuery<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, SmallRangeQuery, runSmallRangeQuery<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
+
+// Large Range: query a large portion of the tree (50% of keys)
+template <typename Tree>
+void runLargeRangeQuery(benchmark::State& state) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
+    resetPeakRss();
+    Tree tree = makeTree<Tree>();
+    
+    // the query does not change the tree, build it once
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    
+    // sort keys to know the range
+    std::sort(keys.begin(), keys.end());
+    
+    // select a large range (approximately 50% of keys)
+    size_t rangeSize = n / 2;
+    size_t startIdx = n / 4; // start at 25% mark
+    int rangeStart = keys[startIdx];
+    int rangeEnd = keys[startIdx + rangeSize - 1];
+    
     for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
-        ScapegoatTree tree;
-        
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        
-        // sort keys to know the range
-        std::sort(keys.begin(), keys.end());
-        
-        // select a small range (approximately 5% of keys)
-        size_t rangeSize = n / 20;
-        size_t startIdx = n / 2 - rangeSize / 2; // Center the range
-        int rangeStart = keys[startIdx];
-        int rangeEnd = keys[startIdx + rangeSize - 1];
-        
-        state.ResumeTiming();
+        tree.resetStats();
         
         // perform range query
         std::vector<int> result = tree.rangeQuery(rangeStart, rangeEnd);
         benchmark::DoNotOptimize(result);
+        stats += tree.getStats();
     }
+    reportMemory(state, tree, n);
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_Scapegoat_SmallRangeQuery)->Range(8, 8<<10)->Threads(8);
 
-// Large Range: query a large portion of the tree (50% of keys)
-static void BM_AVL_LargeRangeQuery(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
-        AVLTree tree;
-        
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
+ENGINE_BENCHMARK(AVL, LargeRangeQuery, runLargeRangeQuery<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, LargeRangeQuery, runLargeRangeQuery<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, LargeRangeQuery, runLargeRangeQuery<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, LargeRangeQuery, runLargeRangeQuery<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, LargeRangeQuery, runLargeRangeQuery<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, LargeRangeQuery, runLargeRangeQuery<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, LargeRangeQuery, runLargeRangeQuery<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, LargeRangeQuery, runLargeRangeQuery<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
+
+// Empty Range: query a range with no elements
+template <typename Tree>
+void runEmptyRangeQuery(benchmark::State& state) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
+    resetPeakRss();
+    Tree tree = makeTree<Tree>();
+    
+    // the query does not change the tree, build it once
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    
+    // sort keys to find gaps
+    std::sort(keys.begin(), keys.end());
+    
+    // find a gap between keys
+    int rangeStart = -1, rangeEnd = -1;
+    for (size_t i = 1; i < keys.size(); ++i) {
+        if (keys[i] > keys[i-1] + 1) {
+            rangeStart = keys[i-1] + 1;
+            rangeEnd = keys[i] - 1;
+            break;
         }
+    }
+    
+    // if no gap found, use range outside the keys
+    if (rangeStart == -1) {
+        rangeStart = 2000000;
+        rangeEnd = 2001000;
+    }
+    
+    for (auto _ : state) {
+        tree.resetStats();
         
-        // sort keys to know the range
-        std::sort(keys.begin(), keys.end());
-        
-        // select a large range (approximately 50% of keys)
-        size_t rangeSize = n / 2;
-        size_t startIdx = n / 4; // start at 25% mark
-        int rangeStart = keys[startIdx];
-        int rangeEnd = keys[startIdx + rangeSize - 1];
-        
-        state.ResumeTiming();
-        
-        // perform range query
+        // perform range query (should be empty)
         std::vector<int> result = tree.rangeQuery(rangeStart, rangeEnd);
         benchmark::DoNotOptimize(result);
+        stats += tree.getStats();
     }
+    reportMemory(state, tree, n);
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_AVL_LargeRangeQuery)->Range(8, 8<<10)->Threads(8);
 
-static void BM_Scapegoat_LargeRangeQuery(benchmark::State& state) {
+ENGINE_BENCHMARK(AVL, EmptyRangeQuery, runEmptyRangeQuery<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, EmptyRangeQuery, runEmptyRangeQuery<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, EmptyRangeQuery, runEmptyRangeQuery<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, EmptyRangeQuery, runEmptyRangeQuery<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, EmptyRangeQuery, runEmptyRangeQuery<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, EmptyRangeQuery, runEmptyRangeQuery<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, EmptyRangeQuery, runEmptyRangeQuery<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, EmptyRangeQuery, runEmptyRangeQuery<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
+
+//------------------------------------------------------------------
+// 5. FLOOR / CEILING BENCHMARKS
+//------------------------------------------------------------------
+
+// Floor Miss-Heavy: 90% of floor lookups have no answer, reported through an exception
+template <typename Tree>
+void runFloorMissHeavyThrowing(benchmark::State& state) {
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 1000001, 2000000);
+    Tree tree = makeTree<Tree>();
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    std::vector<int> probes = generateMissHeavyProbes(n);
+    tree.resetStats();
     for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
-        ScapegoatTree tree;
-        
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
+        for (int key : probes) {
+            try {
+                benchmark::DoNotOptimize(tree.floor(key));
+            } catch (const std::runtime_error&) {
+                // miss
+            }
         }
-        
-        // sort keys to know the range
-        std::sort(keys.begin(), keys.end());
-        
-        // select a large range (approximately 50% of keys)
-        size_t rangeSize = n / 2;
-        size_t startIdx = n / 4; // start at 25% mark
-        int rangeStart = keys[startIdx];
-        int rangeEnd = keys[startIdx + rangeSize - 1];
-        
-        state.ResumeTiming();
-        
-        // perform range query
-        std::vector<int> result = tree.rangeQuery(rangeStart, rangeEnd);
-        benchmark::DoNotOptimize(result);
     }
+    reportTreeStats(state, tree.getStats());
 }
-BENCHMARK(BM_Scapegoat_LargeRangeQuery)->Range(8, 8<<10)->Threads(8);
 
-// Empty Range: query a range with no elements
-static void BM_AVL_EmptyRangeQuery(benchmark::State& state) {
+// same workload through the std::optional variant
+template <typename Tree>
+void runFloorMissHeavy(benchmark::State& state) {
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 1000001, 2000000);
+    Tree tree = makeTree<Tree>();
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    std::vector<int> probes = generateMissHeavyProbes(n);
+    tree.resetStats();
     for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
-        AVLTree tree;
-        
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        
-        // sort keys to find gaps
-        std::sort(keys.begin(), keys.end());
-        
-        // find a gap between keys
-        int rangeStart = -1, rangeEnd = -1;
-        for (size_t i = 1; i < keys.size(); ++i) {
-            if (keys[i] > keys[i-1] + 1) {
-                rangeStart = keys[i-1] + 1;
-                rangeEnd = keys[i] - 1;
-                break;
-            }
+        for (int key : probes) {
+            benchmark::DoNotOptimize(tree.tryFloor(key));
         }
-        
-        // if no gap found, use range outside the keys
-        if (rangeStart == -1) {
-            rangeStart = 2000000;
-            rangeEnd = 2001000;
-        }
-        
+    }
+    reportTreeStats(state, tree.getStats());
+}
+
+// same workload answered in one merged traversal (sorting the probes is part of the cost)
+template <typename Tree>
+void runFloorMissHeavyBatch(benchmark::State& state) {
+    static_assert(hasFloorBatch<Tree>, "runFloorMissHeavyBatch needs floorBatch and ceilingBatch");
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 1000001, 2000000);
+    Tree tree = makeTree<Tree>();
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    std::vector<int> probes = generateMissHeavyProbes(n);
+    tree.resetStats();
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<int> batch = probes;
         state.ResumeTiming();
         
-        // perform range query (should be empty)
-        std::vector<int> result = tree.rangeQuery(rangeStart, rangeEnd);
+        std::sort(batch.begin(), batch.end());
+        std::vector<std::optional<int>> result = tree.floorBatch(batch);
         benchmark::DoNotOptimize(result);
     }
+    reportTreeStats(state, tree.getStats());
 }
-BENCHMARK(BM_AVL_EmptyRangeQuery)->Range(8, 8<<10)->Threads(8);
 
-static void BM_Scapegoat_EmptyRangeQuery(benchmark::State& state) {
+ENGINE_BENCHMARK(AVL, FloorMissHeavy_Throwing, runFloorMissHeavyThrowing<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, FloorMissHeavy_Throwing, runFloorMissHeavyThrowing<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, FloorMissHeavy_Throwing, runFloorMissHeavyThrowing<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, FloorMissHeavy_Throwing, runFloorMissHeavyThrowing<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, FloorMissHeavy_Throwing, runFloorMissHeavyThrowing<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(AVL, FloorMissHeavy, runFloorMissHeavy<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, FloorMissHeavy, runFloorMissHeavy<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, FloorMissHeavy, runFloorMissHeavy<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, FloorMissHeavy, runFloorMissHeavy<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, FloorMissHeavy, runFloorMissHeavy<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(AVL, FloorMissHeavyBatch, runFloorMissHeavyBatch<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, FloorMissHeavyBatch, runFloorMissHeavyBatch<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, FloorMissHeavyBatch, runFloorMissHeavyBatch<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, FloorMissHeavyBatch, runFloorMissHeavyBatch<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, FloorMissHeavy_Throwing, runFloorMissHeavyThrowing<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, FloorMissHeavy, runFloorMissHeavy<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, FloorMissHeavyBatch, runFloorMissHeavyBatch<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, FloorMissHeavy_Throwing, runFloorMissHeavyThrowing<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, FloorMissHeavy, runFloorMissHeavy<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, FloorMissHeavy_Throwing, runFloorMissHeavyThrowing<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, FloorMissHeavy, runFloorMissHeavy<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
+
+// Ceiling Miss-Heavy: 90% of ceiling lookups have no answer, reported through an exception
+template <typename Tree>
+void runCeilingMissHeavyThrowing(benchmark::State& state) {
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 1000001, 2000000);
+    Tree tree = makeTree<Tree>();
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    std::vector<int> probes = generateMissHeavyProbes(n, false);
+    tree.resetStats();
     for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n, 0, 1000000);
-        ScapegoatTree tree;
-        
-        // insert all keys
-        for (int key : keys) {
-            tree.insert(key);
-        }
-        
-        // sort keys to find gaps
-        std::sort(keys.begin(), keys.end());
-        
-        // find a gap between keys
-        int rangeStart = -1, rangeEnd = -1;
-        for (size_t i = 1; i < keys.size(); ++i) {
-            if (keys[i] > keys[i-1] + 1) {
-                rangeStart = keys[i-1] + 1;
-                rangeEnd = keys[i] - 1;
-                break;
+        for (int key : probes) {
+            try {
+                benchmark::DoNotOptimize(tree.ceiling(key));
+            } catch (const std::runtime_error&) {
+                // miss
             }
         }
-        
-        // if no gap found, use range outside the keys
-        if (rangeStart == -1) {
-            rangeStart = 2000000;
-            rangeEnd = 2001000;
+    }
+    reportTreeStats(state, tree.getStats());
+}
+
+// same workload through the std::optional variant
+template <typename Tree>
+void runCeilingMissHeavy(benchmark::State& state) {
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 1000001, 2000000);
+    Tree tree = makeTree<Tree>();
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    std::vector<int> probes = generateMissHeavyProbes(n, false);
+    tree.resetStats();
+    for (auto _ : state) {
+        for (int key : probes) {
+            benchmark::DoNotOptimize(tree.tryCeiling(key));
         }
-        
+    }
+    reportTreeStats(state, tree.getStats());
+}
+
+// same workload answered in one merged traversal (sorting the probes is part of the cost)
+template <typename Tree>
+void runCeilingMissHeavyBatch(benchmark::State& state) {
+    static_assert(hasFloorBatch<Tree>, "runCeilingMissHeavyBatch needs floorBatch and ceilingBatch");
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n, 1000001, 2000000);
+    Tree tree = makeTree<Tree>();
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    std::vector<int> probes = generateMissHeavyProbes(n, false);
+    tree.resetStats();
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<int> batch = probes;
         state.ResumeTiming();
         
-        // perform range query (should be empty)
-        std::vector<int> result = tree.rangeQuery(rangeStart, rangeEnd);
+        std::sort(batch.begin(), batch.end());
+        std::vector<std::optional<int>> result = tree.ceilingBatch(batch);
         benchmark::DoNotOptimize(result);
     }
+    reportTreeStats(state, tree.getStats());
 }
-BENCHMARK(BM_Scapegoat_EmptyRangeQuery)->Range(8, 8<<10)->Threads(8);
+
+ENGINE_BENCHMARK(AVL, CeilingMissHeavy_Throwing, runCeilingMissHeavyThrowing<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, CeilingMissHeavy_Throwing, runCeilingMissHeavyThrowing<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, CeilingMissHeavy_Throwing, runCeilingMissHeavyThrowing<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, CeilingMissHeavy_Throwing, runCeilingMissHeavyThrowing<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, CeilingMissHeavy_Throwing, runCeilingMissHeavyThrowing<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(AVL, CeilingMissHeavy, runCeilingMissHeavy<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, CeilingMissHeavy, runCeilingMissHeavy<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, CeilingMissHeavy, runCeilingMissHeavy<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, CeilingMissHeavy, runCeilingMissHeavy<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, CeilingMissHeavy, runCeilingMissHeavy<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(AVL, CeilingMissHeavyBatch, runCeilingMissHeavyBatch<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, CeilingMissHeavyBatch, runCeilingMissHeavyBatch<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, CeilingMissHeavyBatch, runCeilingMissHeavyBatch<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, CeilingMissHeavyBatch, runCeilingMissHeavyBatch<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, CeilingMissHeavy_Throwing, runCeilingMissHeavyThrowing<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, CeilingMissHeavy, runCeilingMissHeavy<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, CeilingMissHeavyBatch, runCeilingMissHeavyBatch<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, CeilingMissHeavy_Throwing, runCeilingMissHeavyThrowing<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, CeilingMissHeavy, runCeilingMissHeavy<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, CeilingMissHeavy_Throwing, runCeilingMissHeavyThrowing<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, CeilingMissHeavy, runCeilingMissHeavy<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
 
 //------------------------------------------------------------------
 // 7. REAL-WORLD SCENARIO
 //------------------------------------------------------------------
 
 // Dictionary Operations: mixed operations simulating a dictionary (insert/search/delete)
-static void BM_AVL_DictionaryOperations(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        
-        // initial set of keys (50% of n)
-        std::vector<int> initialKeys = generateRandomKeysLinear(n/2);
-        
-        // operations to perform (insert, search, delete) in mixed order
-        std::vector<std::pair<int, int>> operations; // (operation, key): 0=insert, 1=search, 2=delete
-        
-        // generate keys for operations
-        std::vector<int> insertKeys = generateRandomKeysLinear(n/4, 1000001, 2000000);
-        
-        // create all operations
-        // 25% inserts
-        for (int key : insertKeys) {
-            operations.push_back({0, key});
-        }
-        
-        // 50% searches (half existing, half non-existing)
-        std::vector<int> existingKeys(initialKeys.begin(), initialKeys.begin() + n/4);
-        std::vector<int> nonExistingKeys = generateRandomKeysLinear(n/4, 2000001, 3000000);
-        
-        for (int key : existingKeys) {
-            operations.push_back({1, key});
-        }
-        
-        for (int key : nonExistingKeys) {
-            operations.push_back({1, key});
-        }
-        
-        // 25% deletes
-        std::vector<int> deleteKeys(initialKeys.begin() + n/4, initialKeys.begin() + n/2);
-        for (int key : deleteKeys) {
-            operations.push_back({2, key});
-        }
-        
-        // shuffle operations
-        std::shuffle(operations.begin(), operations.end(), g_rng);
-        
-        AVLTree tree;
-        
-        // insert initial keys
-        for (int key : initialKeys) {
-            tree.insert(key);
-        }
-        
-        state.ResumeTiming();
-        
-        // perform mixed operations
+template <typename Tree>
+void runDictionaryOperations(benchmark::State& state) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    
+    // initial set of keys (50% of n)
+    std::vector<int> initialKeys = generateRandomKeysLinear(n/2);
+    
+    // operations to perform (insert, search, delete) in mixed order
+    std::vector<std::pair<int, int>> operations; // (operation, key): 0=insert, 1=search, 2=delete
+    
+    // generate keys for operations
+    std::vector<int> insertKeys = generateRandomKeysLinear(n/4, 1000001, 2000000);
+    
+    // create all operations
+    // 25% inserts
+    for (int key : insertKeys) {
+        operations.push_back({0, key});
+    }
+    
+    // 50% searches (half existing, half non-existing)
+    std::vector<int> existingKeys(initialKeys.begin(), initialKeys.begin() + n/4);
+    std::vector<int> nonExistingKeys = generateRandomKeysLinear(n/4, 2000001, 3000000);
+    
+    for (int key : existingKeys) {
+        operations.push_back({1, key});
+    }
+    
+    for (int key : nonExistingKeys) {
+        operations.push_back({1, key});
+    }
+    
+    // 25% deletes
+    std::vector<int> deleteKeys(initialKeys.begin() + n/4, initialKeys.begin() + n/2);
+    for (int key : deleteKeys) {
+        operations.push_back({2, key});
+    }
+    
+    // shuffle operations
+    std::shuffle(operations.begin(), operations.end(), threadRng());
+    
+    // perform mixed operations
+    auto workload = [&operations](Tree& tree) {
         for (const auto& op : operations) {
             int operation = op.first;
             int key = op.second;
@@ -836,139 +1302,93 @@ static void BM_AVL_DictionaryOperations(benchmark::State& state) {
                     break;
             }
         }
-    }
-}
-BENCHMARK(BM_AVL_DictionaryOperations)->Range(8, 8<<10)->Threads(8);
-
-static void BM_Scapegoat_DictionaryOperations(benchmark::State& state) {
+    };
+    
+    resetPeakRss();
     for (auto _ : state) {
         state.PauseTiming();
-        size_t n = state.range(0);
-        
-        // initial set of keys (50% of n)
-        std::vector<int> initialKeys = generateRandomKeysLinear(n/2);
-        
-        // operations to perform (insert, search, delete) in mixed order
-        std::vector<std::pair<int, int>> operations; // (operation, key): 0=insert, 1=search, 2=delete
-        
-        // generate keys for operations
-        std::vector<int> insertKeys = generateRandomKeysLinear(n/4, 1000001, 2000000);
-        
-        // create all operations
-        // 25% inserts
-        for (int key : insertKeys) {
-            operations.push_back({0, key});
-        }
-        
-        // 50% searches (half existing, half non-existing)
-        std::vector<int> existingKeys(initialKeys.begin(), initialKeys.begin() + n/4);
-        std::vector<int> nonExistingKeys = generateRandomKeysLinear(n/4, 2000001, 3000000);
-        
-        for (int key : existingKeys) {
-            operations.push_back({1, key});
-        }
-        
-        for (int key : nonExistingKeys) {
-            operations.push_back({1, key});
-        }
-        
-        // 25% deletes
-        std::vector<int> deleteKeys(initialKeys.begin() + n/4, initialKeys.begin() + n/2);
-        for (int key : deleteKeys) {
-            operations.push_back({2, key});
-        }
-        
-        // shuffle operations
-        std::shuffle(operations.begin(), operations.end(), g_rng);
-        
-        ScapegoatTree tree;
+        Tree tree = makeTree<Tree>();
         
         // insert initial keys
         for (int key : initialKeys) {
             tree.insert(key);
         }
         
+        tree.resetStats();
         state.ResumeTiming();
         
-        // perform mixed operations
-        for (const auto& op : operations) {
-            int operation = op.first;
-            int key = op.second;
-            
-            switch (operation) {
-                case 0: // insert
-                    tree.insert(key);
-                    break;
-                case 1: // search
-                    benchmark::DoNotOptimize(tree.search(key));
-                    break;
-                case 2: // delete
-                    tree.remove(key);
-                    break;
-            }
-        }
+        workload(tree);
+        stats += tree.getStats();
     }
+    // footprint of the tree the loop leaves behind, measured on one more run outside the timing
+    Tree built = makeTree<Tree>();
+    for (int key : initialKeys) {
+        built.insert(key);
+    }
+    workload(built);
+    reportMemory(state, built, initialKeys.size() + insertKeys.size() - deleteKeys.size());
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_Scapegoat_DictionaryOperations)->Range(8, 8<<10)->Threads(8);
+
+ENGINE_BENCHMARK(AVL, DictionaryOperations, runDictionaryOperations<AVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WAVL, DictionaryOperations, runDictionaryOperations<WAVLTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, DictionaryOperations, runDictionaryOperations<WeightBalancedTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Treap, DictionaryOperations, runDictionaryOperations<TreapTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Splay, DictionaryOperations, runDictionaryOperations<SplayTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, DictionaryOperations, runDictionaryOperations<ScapegoatTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(StdSet, DictionaryOperations, runDictionaryOperations<StdSetTree>(state))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, DictionaryOperations, runDictionaryOperations<SortedVectorTree>(state))->Range(8, 8<<10)->Threads(8);
 
 // Database Index: simulate database index operations (range queries, inserts, specific lookups)
-static void BM_AVL_DatabaseIndex(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        
-        // initial set of keys (80% of n)
-        std::vector<int> initialKeys = generateRandomKeysLinear(n * 4 / 5, 0, 1000000);
-        
-        // operations to perform: range queries, inserts, lookups
-        std::vector<std::tuple<int, int, int>> operations; // (operation, param1, param2): 0=insert, 1=lookup, 2=range
-        
-        // generate keys for operations
-        std::vector<int> insertKeys = generateRandomKeysLinear(n/10, 1000001, 2000000);
-        
-        // create all operations
-        // 10% inserts
-        for (int key : insertKeys) {
-            operations.push_back({0, key, 0});
-        }
-        
-        // 60% lookups (existing and non-existing)
-        std::vector<int> lookupKeys = generateRandomKeysLinear(n * 6 / 10, 0, 2000000);
-        for (int key : lookupKeys) {
-            operations.push_back({1, key, 0});
-        }
-        
-        // 30% range queries - use uniform distribution for start and offset
-        std::uniform_int_distribution<> start_dist(0, 1000000);
-        std::uniform_int_distribution<> range_dist(1, 50000);
-        std::vector<std::pair<int, int>> rangeQueries;
-        rangeQueries.reserve(n * 3 / 10);
-        
-        // pre-generate all range queries at once
-        for (size_t i = 0; i < n * 3 / 10; ++i) {
-            int start = start_dist(g_rng);
-            int end = start + range_dist(g_rng);
-            rangeQueries.push_back({start, end});
-        }
-        
-        // add the range queries to operations
-        for (const auto& query : rangeQueries) {
-            operations.push_back({2, query.first, query.second});
-        }
-        
-        // shuffle operations
-        std::shuffle(operations.begin(), operations.end(), g_rng);
-        
-        AVLTree tree;
-        
-        // insert initial keys
-        for (int key : initialKeys) {
-            tree.insert(key);
-        }
-        
-        state.ResumeTiming();
-        
-        // perform mixed operations
+template <typename Tree>
+void runDatabaseIndex(benchmark::State& state) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    
+    // initial set of keys (80% of n)
+    std::vector<int> initialKeys = generateRandomKeysLinear(n * 4 / 5, 0, 1000000);
+    
+    // operations to perform: range queries, inserts, lookups
+    std::vector<std::tuple<int, int, int>> operations; // (operation, param1, param2): 0=insert, 1=lookup, 2=range
+    
+    // generate keys for operations
+    std::vector<int> insertKeys = generateRandomKeysLinear(n/10, 1000001, 2000000);
+    
+    // create all operations
+    // 10% inserts
+    for (int key : insertKeys) {
+        operations.push_back({0, key, 0});
+    }
+    
+    // 60% lookups (existing and non-existing)
+    std::vector<int> lookupKeys = generateRandomKeysLinear(n * 6 / 10, 0, 2000000);
+    for (int key : lookupKeys) {
+        operations.push_back({1, key, 0});
+    }
+    
+    // 30% range queries - use uniform distribution for start and offset
+    std::uniform_int_distribution<> start_dist(0, 1000000);
+    std::uniform_int_distribution<> range_dist(1, 50000);
+    std::vector<std::pair<int, int>> rangeQueries;
+    rangeQueries.reserve(n * 3 / 10);
+    
+    // pre-generate all range queries at once
+    for (size_t i = 0; i < n * 3 / 10; ++i) {
+        int start = start_dist(threadRng());
+        int end = start + range_dist(threadRng());
+        rangeQueries.push_back({start, end});
+    }
+    
+    // add the range queries to operations
+    for (const auto& query : rangeQueries) {
+        operations.push_back({2, query.first, query.second});
+    }
+    
+    // shuffle operations
+    std::shuffle(operations.begin(), operations.end(), threadRng());
+    
+    // perform mixed operations
+    auto workload = [&operations](Tree& tree) {
         for (const auto& op : operations) {
             int operation = std::get<0>(op);
             int param1 = std::get<1>(op);
@@ -986,152 +1406,161 @@ static void BM_AVL_DatabaseIndex(benchmark::State& state) {
                     break;
             }
         }
-    }
-}
-BENCHMARK(BM_AVL_DatabaseIndex)->Range(8, 8<<9)->Threads(8);
-
-static void BM_Scapegoat_DatabaseIndex(benchmark::State& state) {
+    };
+    
+    resetPeakRss();
     for (auto _ : state) {
         state.PauseTiming();
-        size_t n = state.range(0);
-        
-        // initial set of keys (80% of n)
-        std::vector<int> initialKeys = generateRandomKeysLinear(n * 4 / 5, 0, 1000000);
-        
-        // operations to perform: range queries, inserts, lookups
-        std::vector<std::tuple<int, int, int>> operations; // (operation, param1, param2): 0=insert, 1=lookup, 2=range
-        
-        // generate keys for operations
-        std::vector<int> insertKeys = generateRandomKeysLinear(n/10, 1000001, 2000000);
-        
-        // create all operations
-        // 10% inserts
-        for (int key : insertKeys) {
-            operations.push_back({0, key, 0});
-        }
-        
-        // 60% lookups (existing and non-existing)
-        std::vector<int> lookupKeys = generateRandomKeysLinear(n * 6 / 10, 0, 2000000);
-        for (int key : lookupKeys) {
-            operations.push_back({1, key, 0});
-        }
-        
-        // 30% range queries - use uniform distribution for start and offset
-        std::uniform_int_distribution<> start_dist(0, 1000000);
-        std::uniform_int_distribution<> range_dist(1, 50000);
-        std::vector<std::pair<int, int>> rangeQueries;
-        rangeQueries.reserve(n * 3 / 10);
-        
-        // pre-generate all range queries at once
-        for (size_t i = 0; i < n * 3 / 10; ++i) {
-            int start = start_dist(g_rng);
-            int end = start + range_dist(g_rng);
-            rangeQueries.push_back({start, end});
-        }
-        
-        // add the range queries to operations
-        for (const auto& query : rangeQueries) {
-            operations.push_back({2, query.first, query.second});
-        }
-        
-        // shuffle operations
-        std::shuffle(operations.begin(), operations.end(), g_rng);
-        
-        ScapegoatTree tree;
+        Tree tree = makeTree<Tree>();
         
         // insert initial keys
         for (int key : initialKeys) {
             tree.insert(key);
         }
         
+        tree.resetStats();
         state.ResumeTiming();
         
-        // perform mixed operations
-        for (const auto& op : operations) {
-            int operation = std::get<0>(op);
-            int param1 = std::get<1>(op);
-            int param2 = std::get<2>(op);
-            
-            switch (operation) {
-                case 0: // insert
-                    tree.insert(param1);
-                    break;
-                case 1: // lookup
-                    benchmark::DoNotOptimize(tree.search(param1));
-                    break;
-                case 2: // range query
-                    benchmark::DoNotOptimize(tree.rangeQuery(param1, param2));
-                    break;
-            }
-        }
+        workload(tree);
+        stats += tree.getStats();
+    }
+    // footprint of the tree the loop leaves behind, measured on one more run outside the timing
+    Tree built = makeTree<Tree>();
+    for (int key : initialKeys) {
+        built.insert(key);
     }
+    workload(built);
+    reportMemory(state, built, initialKeys.size() + insertKeys.size());
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_Scapegoat_DatabaseIndex)->Range(8, 8<<9)->Threads(8);
+
+ENGINE_BENCHMARK(AVL, DatabaseIndex, runDatabaseIndex<AVLTree>(state))->Range(8, 8<<9)->Threads(8);
+ENGINE_BENCHMARK(WAVL, DatabaseIndex, runDatabaseIndex<WAVLTree>(state))->Range(8, 8<<9)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, DatabaseIndex, runDatabaseIndex<WeightBalancedTree>(state))->Range(8, 8<<9)->Threads(8);
+ENGINE_BENCHMARK(Treap, DatabaseIndex, runDatabaseIndex<TreapTree>(state))->Range(8, 8<<9)->Threads(8);
+ENGINE_BENCHMARK(Splay, DatabaseIndex, runDatabaseIndex<SplayTree>(state))->Range(8, 8<<9)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, DatabaseIndex, runDatabaseIndex<ScapegoatTree>(state))->Range(8, 8<<9)->Threads(8);
+ENGINE_BENCHMARK(StdSet, DatabaseIndex, runDatabaseIndex<StdSetTree>(state))->Range(8, 8<<9)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, DatabaseIndex, runDatabaseIndex<SortedVectorTree>(state))->Range(8, 8<<9)->Threads(8);
 
 //------------------------------------------------------------------
 // 9. TREE-SPECIFIC TESTS
 //------------------------------------------------------------------
 
-// alpha tuning: test different alpha values to find optimal settings for scapegoat tree
-static void BM_Scapegoat_AlphaTuning_60(benchmark::State& state) {
+// alpha tuning: test different alpha values to find optimal settings for the scapegoat and
+// weight-balanced trees, which read alpha the same way
+// the tree is constructed from treeArgs, the alpha for engines that take one at run time
+template <typename Tree, typename... TreeArgs>
+void runAlphaTuning(benchmark::State& state, TreeArgs... treeArgs) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n);
     for (auto _ : state) {
         state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        ScapegoatTree tree(0.6); // alpha = 0.6
+        Tree tree(treeArgs...);
+        tree.resetStats();
         state.ResumeTiming();
         
         for (int key : keys) {
             tree.insert(key);
         }
+        stats += tree.getStats();
     }
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_Scapegoat_AlphaTuning_60)->Range(8, 8<<10)->Threads(8);
 
-static void BM_Scapegoat_AlphaTuning_70(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        ScapegoatTree tree(0.7); // alpha = 0.7 (default)
-        state.ResumeTiming();
-        
-        for (int key : keys) {
-            tree.insert(key);
+ENGINE_BENCHMARK(Scapegoat, AlphaTuning_60, runAlphaTuning<ScapegoatTree>(state, 0.6))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, AlphaTuning_70, runAlphaTuning<ScapegoatTree>(state, 0.7))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, AlphaTuning_80, runAlphaTuning<ScapegoatTree>(state, 0.8))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, AlphaTuning_90, runAlphaTuning<ScapegoatTree>(state, 0.9))->Range(8, 8<<10)->Threads(8);
+
+// compile-time alpha: same workload, depth bound table computed by the compiler
+ENGINE_BENCHMARK(Scapegoat, AlphaTuningStatic_60, runAlphaTuning<StaticScapegoatTree<std::ratio<6, 10>>>(state))
+    ->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, AlphaTuningStatic_70, runAlphaTuning<StaticScapegoatTree<std::ratio<7, 10>>>(state))
+    ->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, AlphaTuningStatic_80, runAlphaTuning<StaticScapegoatTree<std::ratio<8, 10>>>(state))
+    ->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, AlphaTuningStatic_90, runAlphaTuning<StaticScapegoatTree<std::ratio<9, 10>>>(state))
+    ->Range(8, 8<<10)->Threads(8);
+
+// same alphas kept by rotations, no rebuilds at 0.7 and above
+ENGINE_BENCHMARK(WeightBalanced, AlphaTuning_60, runAlphaTuning<WeightBalancedTree>(state, 0.6))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, AlphaTuning_70, runAlphaTuning<WeightBalancedTree>(state, 0.7))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, AlphaTuning_80, runAlphaTuning<WeightBalancedTree>(state, 0.8))->Range(8, 8<<10)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, AlphaTuning_90, runAlphaTuning<WeightBalancedTree>(state, 0.9))->Range(8, 8<<10)->Threads(8);
+
+// phase-changing workload: four write bursts of n/4 inserts, each followed by a read phase of
+// n operations of which one in 64 is an insert; keys arrive in runs of 64 consecutive values
+// (clustered bulk loads), so tight alphas pay for rebuilds and loose ones for depth
+std::vector<std::pair<int, int>> generatePhaseChangeWorkload(size_t n) {
+    const size_t runLength = 64;
+    const size_t phases = 4;
+    
+    // twice as many keys as the bursts need, the read phases insert the rest
+    size_t runCount = (2 * n + runLength - 1) / runLength;
+    std::vector<int> runs(runCount);
+    for (size_t i = 0; i < runCount; ++i) {
+        runs[i] = static_cast<int>(i);
+    }
+    std::shuffle(runs.begin(), runs.end(), threadRng());
+    std::vector<int> keys;
+    keys.reserve(runCount * runLength);
+    for (int run : runs) {
+        for (size_t j = 0; j < runLength; ++j) {
+            keys.push_back(static_cast<int>(run * runLength + j));
         }
     }
-}
-BENCHMARK(BM_Scapegoat_AlphaTuning_70)->Range(8, 8<<10)->Threads(8);
-
-static void BM_Scapegoat_AlphaTuning_80(benchmark::State& state) {
-    for (auto _ : state) {
-        state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        ScapegoatTree tree(0.8); // alpha = 0.8
-        state.ResumeTiming();
-        
-        for (int key : keys) {
-            tree.insert(key);
+    
+    std::vector<std::pair<int, int>> operations;
+    size_t inserted = 0;
+    for (size_t phase = 0; phase < phases; ++phase) {
+        for (size_t i = 0; i < n / phases; ++i) {
+            operations.push_back({0, keys[inserted++]});
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (i % 64 == 0) {
+                operations.push_back({0, keys[inserted++]});
+            } else {
+                std::uniform_int_distribution<size_t> distrib(0, inserted - 1);
+                operations.push_back({1, keys[distrib(threadRng())]});
+            }
         }
     }
+    
+    return operations;
 }
-BENCHMARK(BM_Scapegoat_AlphaTuning_80)->Range(8, 8<<10)->Threads(8);
 
-static void BM_Scapegoat_AlphaTuning_90(benchmark::State& state) {
+void runPhaseChange(benchmark::State& state, double alpha, bool adaptive) {
+    TreeStats stats;
+    std::vector<std::pair<int, int>> operations = generatePhaseChangeWorkload(state.range(0));
     for (auto _ : state) {
         state.PauseTiming();
-        size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        ScapegoatTree tree(0.9); // alpha = 0.9
+        ScapegoatTree tree(alpha);
+        tree.setAdaptiveAlpha(adaptive);
+        tree.resetStats();
         state.ResumeTiming();
         
-        for (int key : keys) {
-            tree.insert(key);
+        for (const auto& op : operations) {
+            if (op.first == 0) {
+                tree.insert(op.second);
+            } else {
+                benchmark::DoNotOptimize(tree.search(op.second));
+            }
         }
+        stats += tree.getStats();
     }
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_Scapegoat_AlphaTuning_90)->Range(8, 8<<10)->Threads(8);
+
+ENGINE_BENCHMARK(Scapegoat, PhaseChange_55, runPhaseChange(state, 0.55, false))->Range(1<<12, 64<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, PhaseChange_60, runPhaseChange(state, 0.6, false))->Range(1<<12, 64<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, PhaseChange_70, runPhaseChange(state, 0.7, false))->Range(1<<12, 64<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, PhaseChange_80, runPhaseChange(state, 0.8, false))->Range(1<<12, 64<<10)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, PhaseChange_90, runPhaseChange(state, 0.9, false))->Range(1<<12, 64<<10)->Threads(8);
+
+// adaptive alpha, starting from the default 0.7
+ENGINE_BENCHMARK(Scapegoat, PhaseChange_Adaptive, runPhaseChange(state, 0.7, true))->Range(1<<12, 64<<10)->Threads(8);
 
 //------------------------------------------------------------------
 // 10. STRESS TESTS
@@ -1140,22 +1569,29 @@ BENCHMARK(BM_Scapegoat_AlphaTuning_90)->Range(8, 8<<10)->Threads(8);
 // create worst-case scenarios for each tree type
 // worst case for avl: continuous insertions in sorted order
 static void BM_AVL_WorstCase(benchmark::State& state) {
+    seedThreadRng(state);
+    TreeStats stats;
     for (auto _ : state) {
         state.PauseTiming();
         size_t n = state.range(0);
         AVLTree tree;
+        tree.resetStats();
         state.ResumeTiming();
         
         // insert in sorted order (would create a right-skewed tree without balancing)
         for (size_t i = 0; i < n; ++i) {
             tree.insert(static_cast<int>(i));
         }
+        stats += tree.getStats();
     }
+    reportTreeStats(state, stats);
 }
 BENCHMARK(BM_AVL_WorstCase)->Range(8, 8<<10)->Threads(8);
 
 // worst case for scapegoat: insertion pattern that maximizes rebuilding
 static void BM_Scapegoat_WorstCase(benchmark::State& state) {
+    seedThreadRng(state);
+    TreeStats stats;
     for (auto _ : state) {
         state.PauseTiming();
         size_t n = state.range(0);
@@ -1177,44 +1613,954 @@ static void BM_Scapegoat_WorstCase(benchmark::State& state) {
             }
         }
         
+        tree.resetStats();
         state.ResumeTiming();
         
         for (int key : keys) {
             tree.insert(key);
         }
+        stats += tree.getStats();
     }
+    reportTreeStats(state, stats);
 }
 BENCHMARK(BM_Scapegoat_WorstCase)->Range(8, 8<<10)->Threads(8);
 
-// large dataset test: test with larger entries for stability and performance
-static void BM_AVL_LargeDataset(benchmark::State& state) {
+// worst case for std::set: sorted insertion, every insert lands on the right spine and recolours it
+static void BM_StdSet_WorstCase(benchmark::State& state) {
+    seedThreadRng(state);
+    TreeStats stats;
     for (auto _ : state) {
         state.PauseTiming();
         size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        AVLTree tree;
+        StdSetTree tree;
         state.ResumeTiming();
         
-        for (int key : keys) {
-            tree.insert(key);
+        for (size_t i = 0; i < n; ++i) {
+            tree.insert(static_cast<int>(i));
         }
+        stats += tree.getStats();
     }
+    reportTreeStats(state, stats);
 }
-BENCHMARK(BM_AVL_LargeDataset)->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond)->Threads(8);
+BENCHMARK(BM_StdSet_WorstCase)->Range(8, 8<<10)->Threads(8);
 
-static void BM_Scapegoat_LargeDataset(benchmark::State& state) {
+// worst case for the sorted vector: descending insertion, every insert shifts all keys
+static void BM_SortedVector_WorstCase(benchmark::State& state) {
+    seedThreadRng(state);
+    TreeStats stats;
     for (auto _ : state) {
         state.PauseTiming();
         size_t n = state.range(0);
-        std::vector<int> keys = generateRandomKeysLinear(n);
-        ScapegoatTree tree;
+        SortedVectorTree tree;
+        state.ResumeTiming();
+        
+        for (size_t i = n; i > 0; --i) {
+            tree.insert(static_cast<int>(i));
+        }
+        stats += tree.getStats();
+    }
+    reportTreeStats(state, stats);
+}
+BENCHMARK(BM_SortedVector_WorstCase)->Range(8, 8<<10)->Threads(8);
+
+// large dataset test: test with larger entries for stability and performance
+template <typename Tree>
+void runLargeDataset(benchmark::State& state) {
+    TreeStats stats;
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n);
+    resetPeakRss();
+    for (auto _ : state) {
+        state.PauseTiming();
+        Tree tree = makeTree<Tree>();
+        tree.resetStats();
         state.ResumeTiming();
         
         for (int key : keys) {
             tree.insert(key);
         }
+        stats += tree.getStats();
+    }
+    // footprint of the tree the loop builds, measured on one more build outside the timing
+    Tree built = makeTree<Tree>();
+    for (int key : keys) {
+        built.insert(key);
+    }
+    reportMemory(state, built, n);
+    reportTreeStats(state, stats);
+}
+
+ENGINE_BENCHMARK(AVL, LargeDataset, runLargeDataset<AVLTree>(state))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond)->Threads(8);
+ENGINE_BENCHMARK(WAVL, LargeDataset, runLargeDataset<WAVLTree>(state))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond)->Threads(8);
+ENGINE_BENCHMARK(WeightBalanced, LargeDataset, runLargeDataset<WeightBalancedTree>(state))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond)->Threads(8);
+ENGINE_BENCHMARK(Treap, LargeDataset, runLargeDataset<TreapTree>(state))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond)->Threads(8);
+ENGINE_BENCHMARK(Splay, LargeDataset, runLargeDataset<SplayTree>(state))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond)->Threads(8);
+ENGINE_BENCHMARK(Scapegoat, LargeDataset, runLargeDataset<ScapegoatTree>(state))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond)->Threads(8);
+ENGINE_BENCHMARK(StdSet, LargeDataset, runLargeDataset<StdSetTree>(state))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond)->Threads(8);
+ENGINE_BENCHMARK(SortedVector, LargeDataset, runLargeDataset<SortedVectorTree>(state))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond)->Threads(8);
+
+//------------------------------------------------------------------
+// 11. TAIL LATENCY
+//------------------------------------------------------------------
+
+// every operation is timed on its own and recorded into a latency histogram,
+// operations that rebuilt part of the tree are recorded a second time so that
+// stalls can be attributed to rebuilds
+// runs single-threaded, percentiles from different threads cannot be combined
+
+enum TailWorkload { TAIL_RANDOM_INSERT, TAIL_DELETE_HEAVY, TAIL_DICTIONARY };
+
+// scapegoat tree that spreads its rebuilds over later updates
+struct IncrementalScapegoatTree : ScapegoatTree {
+    IncrementalScapegoatTree() : ScapegoatTree(0.7, true) {}
+};
+
+// rebuilds performed so far, AVL, WAVL, the treap and the splay tree never rebuild, the
+// weight-balanced tree only below alpha 2/3
+long long rebuildCount(const AVLTree&) { return 0; }
+long long rebuildCount(const WAVLTree&) { return 0; }
+long long rebuildCount(const TreapTree&) { return 0; }
+long long rebuildCount(const SplayTree&) { return 0; }
+long long rebuildCount(const ScapegoatTree& tree) { return tree.getRebuildCount(); }
+long long rebuildCount(const WeightBalancedTree& tree) { return tree.getRebuildCount(); }
+
+// (operation, key): 0=insert, 1=search, 2=delete
+std::vector<std::pair<int, int>> generateTailWorkload(TailWorkload workload, size_t n, std::vector<int>& initialKeys) {
+    std::vector<std::pair<int, int>> operations;
+    
+    switch (workload) {
+        case TAIL_RANDOM_INSERT: {
+            // insert n random keys into an empty tree
+            initialKeys.clear();
+            for (int key : generateRandomKeysLinear(n)) {
+                operations.push_back({0, key});
+            }
+            break;
+        }
+        case TAIL_DELETE_HEAVY: {
+            // delete 80% of n keys, then insert 20% new keys
+            initialKeys = generateRandomKeysLinear(n);
+            for (size_t i = 0; i < (n * 4) / 5; ++i) {
+                operations.push_back({2, initialKeys[i]});
+            }
+            for (int key : generateRandomKeysLinear(n / 5, 1000001, 2000000)) {
+                operations.push_back({0, key});
+            }
+            break;
+        }
+        case TAIL_DICTIONARY: {
+            // 25% inserts, 50% searches, 25% deletes on n/2 initial keys
+            initialKeys = generateRandomKeysLinear(n / 2);
+            for (int key : generateRandomKeysLinear(n / 4, 1000001, 2000000)) {
+                operations.push_back({0, key});
+            }
+            for (size_t i = 0; i < n / 4; ++i) {
+                operations.push_back({1, initialKeys[i]});
+            }
+            for (int key : generateRandomKeysLinear(n / 4, 2000001, 3000000)) {
+                operations.push_back({1, key});
+            }
+            for (size_t i = n / 4; i < n / 2; ++i) {
+                operations.push_back({2, initialKeys[i]});
+            }
+            std::shuffle(operations.begin(), operations.end(), threadRng());
+            break;
+        }
+    }
+    
+    return operations;
+}
+
+void reportLatency(benchmark::State& state, const LatencyHistogram& all, const LatencyHistogram& withRebuild) {
+    uint64_t p99 = all.percentile(99.0);
+    uint64_t stalls = all.countAbove(p99);
+    
+    state.counters["p50_ns"] = all.percentile(50.0);
+    state.counters["p99_ns"] = p99;
+    state.counters["p999_ns"] = all.percentile(99.9);
+    state.counters["max_ns"] = all.max();
+    // share of operations that rebuilt, and share of the slowest 1% that rebuilt
+    state.counters["rebuild_ops"] = all.count() ? static_cast<double>(withRebuild.count()) / all.count() : 0.0;
+    state.counters["stalls_rebuilt"] = stalls ? static_cast<double>(withRebuild.countAbove(p99)) / stalls : 0.0;
+}
+
+template <typename Tree>
+void runTailLatency(benchmark::State& state, TailWorkload workload) {
+    LatencyHistogram all;
+    LatencyHistogram withRebuild;
+    size_t n = state.range(0);
+    std::vector<int> initialKeys;
+    std::vector<std::pair<int, int>> operations = generateTailWorkload(workload, n, initialKeys);
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        Tree tree = makeTree<Tree>();
+        for (int key : initialKeys) {
+            tree.insert(key);
+        }
+        state.ResumeTiming();
+        
+        for (const auto& op : operations) {
+            long long rebuildsBefore = rebuildCount(tree);
+            auto start = std::chrono::steady_clock::now();
+            
+            switch (op.first) {
+                case 0: // insert
+                    tree.insert(op.second);
+                    break;
+                case 1: // search
+                    benchmark::DoNotOptimize(tree.search(op.second));
+                    break;
+                case 2: // delete
+                    tree.remove(op.second);
+                    break;
+            }
+            
+            uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            all.record(elapsed);
+            if (rebuildCount(tree) != rebuildsBefore) {
+                withRebuild.record(elapsed);
+            }
+        }
+    }
+    
+    reportLatency(state, all, withRebuild);
+}
+
+ENGINE_BENCHMARK(AVL, TailLatency_RandomInsert, runTailLatency<AVLTree>(state, TAIL_RANDOM_INSERT))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(WAVL, TailLatency_RandomInsert, runTailLatency<WAVLTree>(state, TAIL_RANDOM_INSERT))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(WeightBalanced, TailLatency_RandomInsert, runTailLatency<WeightBalancedTree>(state, TAIL_RANDOM_INSERT))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Treap, TailLatency_RandomInsert, runTailLatency<TreapTree>(state, TAIL_RANDOM_INSERT))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Splay, TailLatency_RandomInsert, runTailLatency<SplayTree>(state, TAIL_RANDOM_INSERT))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, TailLatency_RandomInsert, runTailLatency<ScapegoatTree>(state, TAIL_RANDOM_INSERT))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(AVL, TailLatency_DeleteHeavy, runTailLatency<AVLTree>(state, TAIL_DELETE_HEAVY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(WAVL, TailLatency_DeleteHeavy, runTailLatency<WAVLTree>(state, TAIL_DELETE_HEAVY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(WeightBalanced, TailLatency_DeleteHeavy, runTailLatency<WeightBalancedTree>(state, TAIL_DELETE_HEAVY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Treap, TailLatency_DeleteHeavy, runTailLatency<TreapTree>(state, TAIL_DELETE_HEAVY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Splay, TailLatency_DeleteHeavy, runTailLatency<SplayTree>(state, TAIL_DELETE_HEAVY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, TailLatency_DeleteHeavy, runTailLatency<ScapegoatTree>(state, TAIL_DELETE_HEAVY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(AVL, TailLatency_Dictionary, runTailLatency<AVLTree>(state, TAIL_DICTIONARY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(WAVL, TailLatency_Dictionary, runTailLatency<WAVLTree>(state, TAIL_DICTIONARY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(WeightBalanced, TailLatency_Dictionary, runTailLatency<WeightBalancedTree>(state, TAIL_DICTIONARY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Treap, TailLatency_Dictionary, runTailLatency<TreapTree>(state, TAIL_DICTIONARY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Splay, TailLatency_Dictionary, runTailLatency<SplayTree>(state, TAIL_DICTIONARY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, TailLatency_Dictionary, runTailLatency<ScapegoatTree>(state, TAIL_DICTIONARY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, TailLatencyIncremental_RandomInsert, runTailLatency<IncrementalScapegoatTree>(state, TAIL_RANDOM_INSERT))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, TailLatencyIncremental_DeleteHeavy, runTailLatency<IncrementalScapegoatTree>(state, TAIL_DELETE_HEAVY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, TailLatencyIncremental_Dictionary, runTailLatency<IncrementalScapegoatTree>(state, TAIL_DICTIONARY))->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond);
+
+#ifdef HEAPURI_TREE_STATS
+// insert orders that grow one path by a level per insert (ascending, descending, alternating
+// ends) leave an in-flight rebuild the least room; the deepest insert so far is checked every
+// 1024 inserts against log_{1/alpha}(size) plus the levels an in-flight rebuild may add, and the
+// benchmark fails once it is exceeded. max_depth is only counted with HEAPURI_TREE_STATS
+enum DepthOrder { DEPTH_ASCENDING, DEPTH_DESCENDING, DEPTH_ALTERNATING, DEPTH_RANDOM };
+
+void runIncrementalDepthBound(benchmark::State& state, DepthOrder order) {
+    size_t n = state.range(0);
+    std::vector<int> keys = generateSequentialKeys(n, order != DEPTH_DESCENDING);
+    if (order == DEPTH_ALTERNATING) {
+        // n/2 - 1, n/2, n/2 - 2, n/2 + 1, ... both ends of the tree grow
+        int middle = static_cast<int>(n / 2);
+        for (size_t i = 0; i < n; ++i) {
+            int offset = static_cast<int>(i / 2);
+            keys[i] = (i % 2) ? middle + offset : middle - offset - 1;
+        }
+    } else if (order == DEPTH_RANDOM) {
+        keys = generateRandomKeysLinear(n, 0, 1 << 30);
+    }
+    // root at depth 1, and the insert that started a rebuild may already be one level too deep
+    const double alpha = 0.7;
+    const int allowance = 2 + ScapegoatTree::REBUILD_DEPTH_SLACK;
+    
+    int maxDepth = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        IncrementalScapegoatTree tree;
+        state.ResumeTiming();
+        
+        for (size_t i = 0; i < n; ++i) {
+            tree.insert(keys[i]);
+            if ((i + 1) % 1024 != 0 && i + 1 != n) continue;
+            int depth = tree.getStats().maxDepth;
+            double bound = std::log(static_cast<double>(i + 1)) / std::log(1 / alpha) + allowance;
+            maxDepth = std::max(maxDepth, depth);
+            if (depth > bound) {
+                state.SkipWithError(("depth " + std::to_string(depth) + " exceeds " + std::to_string(bound) +
+                                     " after " + std::to_string(i + 1) + " inserts").c_str());
+                break;
+            }
+        }
     }
+    state.counters["max_depth"] = maxDepth;
+    state.counters["depth_bound"] = std::log(static_cast<double>(n)) / std::log(1 / alpha) + allowance;
 }
-BENCHMARK(BM_Scapegoat_LargeDataset)->Range(1<<10, 1<<14)->Unit(benchmark::kMillisecond)->Threads(8);
 
-BENCHMARK_MAIN(); 
\ No newline at end of file
+ENGINE_BENCHMARK(Scapegoat, IncrementalDepthBound_Ascending, runIncrementalDepthBound(state, DEPTH_ASCENDING))->RangeMultiplier(8)->Range(1<<12, 1<<20)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, IncrementalDepthBound_Descending, runIncrementalDepthBound(state, DEPTH_DESCENDING))->RangeMultiplier(8)->Range(1<<12, 1<<20)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, IncrementalDepthBound_Alternating, runIncrementalDepthBound(state, DEPTH_ALTERNATING))->RangeMultiplier(8)->Range(1<<12, 1<<20)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, IncrementalDepthBound_Random, runIncrementalDepthBound(state, DEPTH_RANDOM))->RangeMultiplier(8)->Range(1<<12, 1<<20)->Unit(benchmark::kMillisecond);
+#endif
+
+//------------------------------------------------------------------
+// 12. SNAPSHOT STARTUP
+//------------------------------------------------------------------
+
+// restart cost of an index of n keys followed by n/5 lookups: re-inserting every key into a
+// fresh tree versus mapping the snapshot the previous process saved
+// the snapshot file was just written and sits in the page cache, so this is a warm restart
+
+std::string snapshotPath(size_t n, int thread) {
+    std::string name = "heapuri_snapshot_" + std::to_string(n) + "_" + std::to_string(thread) + ".bin";
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+template <typename Tree>
+void runStartupReinsert(benchmark::State& state) {
+    size_t n = state.range(0);
+    std::vector<int> keys = generateRandomKeysLinear(n);
+    std::vector<int> searchKeys(keys.begin(), keys.begin() + n / 5);
+    for (auto _ : state) {
+        auto tree = std::make_unique<Tree>(makeTree<Tree>());
+        for (int key : keys) {
+            tree->insert(key);
+        }
+        for (int key : searchKeys) {
+            benchmark::DoNotOptimize(tree->search(key));
+        }
+
+        // teardown is not part of startup
+        state.PauseTiming();
+        tree.reset();
+        state.ResumeTiming();
+    }
+}
+
+ENGINE_BENCHMARK(AVL, StartupReinsert, runStartupReinsert<AVLTree>(state))->Range(1<<10, 1<<18)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, StartupReinsert, runStartupReinsert<ScapegoatTree>(state))->Range(1<<10, 1<<18)->Unit(benchmark::kMillisecond);
+
+static void BM_Snapshot_StartupOpen(benchmark::State& state) {
+    seedThreadRng(state);
+    size_t n = state.range(0);
+    std::string path = snapshotPath(n, state.thread_index());
+    std::vector<int> keys = generateRandomKeysLinear(n);
+    std::vector<int> searchKeys(keys.begin(), keys.begin() + n / 5);
+    {
+        AVLTree previous;
+        for (int key : keys) {
+            previous.insert(key);
+        }
+        previous.save(path);
+    }
+    for (auto _ : state) {
+        auto snapshot = std::make_unique<TreeSnapshot>(TreeSnapshot::open(path));
+        for (int key : searchKeys) {
+            benchmark::DoNotOptimize(snapshot->search(key));
+        }
+
+        state.PauseTiming();
+        snapshot.reset();
+        state.ResumeTiming();
+    }
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_Snapshot_StartupOpen)->Range(1<<10, 1<<18)->Unit(benchmark::kMillisecond);
+
+// steady-state lookups against the mapped file, compare with BM_AVL_SuccessfulSearch
+static void BM_Snapshot_SuccessfulSearch(benchmark::State& state) {
+    seedThreadRng(state);
+    size_t n = state.range(0);
+    std::string path = snapshotPath(n, state.thread_index());
+    std::vector<int> keys = generateRandomKeysLinear(n);
+    {
+        AVLTree previous;
+        for (int key : keys) {
+            previous.insert(key);
+        }
+        previous.save(path);
+    }
+    TreeSnapshot snapshot = TreeSnapshot::open(path);
+    std::shuffle(keys.begin(), keys.end(), threadRng());
+
+    // take 20% of keys for search
+    size_t searchCount = n / 5;
+    std::vector<int> searchKeys(keys.begin(), keys.begin() + searchCount);
+    for (auto _ : state) {
+        // search for keys (all should be found)
+        for (int key : searchKeys) {
+            benchmark::DoNotOptimize(snapshot.search(key));
+        }
+    }
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_Snapshot_SuccessfulSearch)->Range(8, 8<<10)->Threads(8);
+
+// streaming bulk build of an unsorted key file of n keys with a fixed 4 MB budget, so that
+// the larger sizes spill sorted runs and merge them; reports throughput of the key file and
+// the peak resident set of the build (Linux only, 0 elsewhere)
+
+static void BM_Snapshot_BulkBuild(benchmark::State& state) {
+    seedThreadRng(state);
+    size_t n = state.range(0);
+    const size_t memoryBytes = 4 << 20;
+    std::string keyPath = snapshotPath(n, state.thread_index()) + ".keys";
+    std::string outputPath = snapshotPath(n, state.thread_index());
+    {
+        // written in slices so the generator itself stays small
+        std::ofstream keyFile(keyPath, std::ios::binary | std::ios::trunc);
+        std::uniform_int_distribution<int> distrib(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+        std::vector<int> slice(1 << 16);
+        for (size_t written = 0; written < n; written += slice.size()) {
+            size_t count = std::min(slice.size(), n - written);
+            for (size_t i = 0; i < count; ++i) {
+                slice[i] = distrib(threadRng());
+            }
+            keyFile.write(reinterpret_cast<const char*>(slice.data()), count * sizeof(int));
+        }
+    }
+
+    double peakMB = 0;
+    BulkBuildStats stats;
+    for (auto _ : state) {
+        state.PauseTiming();
+        resetPeakRss();
+        state.ResumeTiming();
+
+        stats = TreeSnapshot::buildFromKeyFile(keyPath, outputPath, memoryBytes);
+
+        state.PauseTiming();
+        peakMB = std::max(peakMB, peakRssMB());
+        state.ResumeTiming();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * n * sizeof(int));
+    state.counters["peak_rss_MB"] = peakMB;
+    state.counters["runs"] = stats.runs;
+    state.counters["merge_passes"] = stats.mergePasses;
+    std::remove(keyPath.c_str());
+    std::remove(outputPath.c_str());
+}
+BENCHMARK(BM_Snapshot_BulkBuild)->RangeMultiplier(4)->Range(1<<16, 1<<24)->Unit(benchmark::kMillisecond);
+
+//------------------------------------------------------------------
+// 13. DURABILITY
+//------------------------------------------------------------------
+
+// sustained random inserts through a DurableTree, group = records per fsync,
+// group 0 is the bare tree without a log
+template <typename Tree>
+void runLoggedInsert(benchmark::State& state) {
+    size_t n = state.range(0);
+    size_t group = state.range(1);
+    std::string base = snapshotPath(n, state.thread_index()) + ".durable";
+    WalOptions options;
+    options.groupCommitOps = group;
+    options.groupCommitDelay = std::chrono::microseconds::max();
+    long long commits = 0;
+    std::vector<int> keys = generateRandomKeysLinear(n);
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::remove((base + ".wal").c_str());
+        std::remove((base + ".checkpoint").c_str());
+        auto tree = std::make_unique<Tree>(makeTree<Tree>());
+        auto durable = group > 0 ? std::make_unique<DurableTree<Tree>>(base, options) : nullptr;
+        state.ResumeTiming();
+
+        if (durable) {
+            for (int key : keys) {
+                durable->insert(key);
+            }
+            durable->commit();
+            commits += durable->commitCount();
+        } else {
+            for (int key : keys) {
+                tree->insert(key);
+            }
+        }
+
+        state.PauseTiming();
+        tree.reset();
+        durable.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * n);
+    state.counters["fsyncs"] = benchmark::Counter(static_cast<double>(commits), benchmark::Counter::kAvgIterations);
+    std::remove((base + ".wal").c_str());
+}
+
+ENGINE_BENCHMARK(AVL, LoggedInsert, runLoggedInsert<AVLTree>(state))->Args({1<<14, 0})->Args({1<<14, 1})->Args({1<<14, 64})->Args({1<<14, 1024})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+ENGINE_BENCHMARK(Scapegoat, LoggedInsert, runLoggedInsert<ScapegoatTree>(state))->Args({1<<14, 0})->Args({1<<14, 1})->Args({1<<14, 64})->Args({1<<14, 1024})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// restart of a DurableTree holding n keys: load the checkpoint, then replay a log tail of
+// n/100 updates written since it
+template <typename Tree>
+void runRecovery(benchmark::State& state) {
+    size_t n = state.range(0);
+    std::string base = snapshotPath(n, state.thread_index()) + ".durable";
+    {
+        std::vector<int> keys(n);
+        for (size_t i = 0; i < n; ++i) {
+            keys[i] = static_cast<int>(2 * i); // sorted, odd keys are left for the tail
+        }
+        TreeSnapshot::write(base + ".checkpoint", keys);
+        std::remove((base + ".wal").c_str());
+        WalOptions options;
+        options.sync = false;
+        WriteAheadLog log(base + ".wal", options);
+        std::uniform_int_distribution<int> distrib(0, static_cast<int>(2 * n));
+        for (size_t i = 0; i < n / 100; ++i) {
+            log.append(i % 4 == 0 ? LOG_REMOVE : LOG_INSERT, distrib(threadRng()));
+        }
+    }
+
+    WalOptions options;
+    for (auto _ : state) {
+        auto durable = std::make_unique<DurableTree<Tree>>(base, options);
+        benchmark::DoNotOptimize(durable->recoveredLogRecords());
+
+        // teardown is not part of recovery
+        state.PauseTiming();
+        durable.reset();
+        state.ResumeTiming();
+    }
+    std::remove((base + ".wal").c_str());
+    std::remove((base + ".checkpoint").c_str());
+}
+
+ENGINE_BENCHMARK(AVL, Recovery, runRecovery<AVLTree>(state))->Arg(1<<20)->Arg(10000000)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, Recovery, runRecovery<ScapegoatTree>(state))->Arg(1<<20)->Arg(10000000)->Unit(benchmark::kMillisecond);
+
+//------------------------------------------------------------------
+// 14. TRACE REPLAY
+//------------------------------------------------------------------
+
+// replays the recorded trace named by HEAPURI_TRACE (see trace.h for the format), every size
+// then replays the same trace; without it a synthetic trace of n/2 inserts followed by n
+// mixed operations is written once per size: 30% search, 15% insert, 15% remove,
+// 15% floor, 15% ceiling and 10% range queries over 100 keys
+
+std::string syntheticTracePath(size_t n) {
+    std::string path = snapshotPath(n, 0) + ".trace";
+    std::vector<TraceRecord> records;
+    std::vector<int> keys = generateRandomKeysLinear(n / 2);
+    for (int key : keys) {
+        records.push_back({TRACE_INSERT, key, 0});
+    }
+    std::uniform_int_distribution<int> keyDistrib(0, 1000000);
+    std::uniform_int_distribution<int> opDistrib(0, 99);
+    for (size_t i = 0; i < n; ++i) {
+        int roll = opDistrib(threadRng());
+        int key = keyDistrib(threadRng());
+        if (roll < 30) {
+            records.push_back({TRACE_SEARCH, keys[i % keys.size()], 0});
+        } else if (roll < 45) {
+            records.push_back({TRACE_INSERT, key, 0});
+        } else if (roll < 60) {
+            records.push_back({TRACE_REMOVE, keys[(i * 7) % keys.size()], 0});
+        } else if (roll < 75) {
+            records.push_back({TRACE_FLOOR, key, 0});
+        } else if (roll < 90) {
+            records.push_back({TRACE_CEILING, key, 0});
+        } else {
+            records.push_back({TRACE_RANGE, key, key + 100});
+        }
+    }
+    OperationTrace::write(path, records);
+    return path;
+}
+
+template <typename Tree>
+void runTraceReplay(benchmark::State& state, bool recordLatency) {
+    const char* recorded = std::getenv("HEAPURI_TRACE");
+    std::string path = recorded ? recorded : syntheticTracePath(state.range(0));
+    OperationTrace trace = OperationTrace::open(path);
+
+    LatencyHistogram latency;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto tree = std::make_unique<Tree>(makeTree<Tree>());
+        state.ResumeTiming();
+
+        ReplayResult result = replayTrace(*tree, trace, recordLatency);
+        benchmark::DoNotOptimize(result.digest);
+
+        state.PauseTiming();
+        latency.merge(result.latency);
+        tree.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * trace.size());
+    if (recordLatency) {
+        state.counters["p50_ns"] = latency.percentile(50.0);
+        state.counters["p99_ns"] = latency.percentile(99.0);
+        state.counters["p999_ns"] = latency.percentile(99.9);
+        state.counters["max_ns"] = latency.max();
+    }
+    if (!recorded) {
+        std::remove(path.c_str());
+    }
+}
+
+ENGINE_BENCHMARK(AVL, TraceReplay, runTraceReplay<AVLTree>(state, false))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(WAVL, TraceReplay, runTraceReplay<WAVLTree>(state, false))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(WeightBalanced, TraceReplay, runTraceReplay<WeightBalancedTree>(state, false))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Treap, TraceReplay, runTraceReplay<TreapTree>(state, false))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Splay, TraceReplay, runTraceReplay<SplayTree>(state, false))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, TraceReplay, runTraceReplay<ScapegoatTree>(state, false))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+
+// same replay with every operation timed into a latency histogram
+ENGINE_BENCHMARK(AVL, TraceReplayLatency, runTraceReplay<AVLTree>(state, true))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(WAVL, TraceReplayLatency, runTraceReplay<WAVLTree>(state, true))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(WeightBalanced, TraceReplayLatency, runTraceReplay<WeightBalancedTree>(state, true))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Treap, TraceReplayLatency, runTraceReplay<TreapTree>(state, true))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Splay, TraceReplayLatency, runTraceReplay<SplayTree>(state, true))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+ENGINE_BENCHMARK(Scapegoat, TraceReplayLatency, runTraceReplay<ScapegoatTree>(state, true))->Range(1<<12, 1<<18)->Unit(benchmark::kMillisecond);
+
+//------------------------------------------------------------------
+// 15. LARGE SCALE
+//------------------------------------------------------------------
+
+// trees of 1K up to 100M keys, far past the last-level cache from a few million keys on
+// (a node costs about 48 bytes with allocator overhead, so 100M keys need about 5 GB),
+// so lookups pay for the DRAM misses the small benchmarks never see
+// each size builds its tree once with loadSorted (inserting 100M keys would dominate the
+// run) holding keys 0, 2, 4, ..., then times LARGE_SCALE_LOOKUPS lookups per iteration
+
+constexpr size_t LARGE_SCALE_LOOKUPS = 1 << 20;
+
+enum KeyDistribution { DIST_UNIFORM, DIST_ZIPFIAN, DIST_HOTSPOT, DIST_LATEST, DIST_MOVING_WINDOW };
+
+std::vector<int> generateLookupKeys(KeyDistribution distribution, size_t n, uint64_t items) {
+    std::vector<uint64_t> slots;
+    switch (distribution) {
+        case DIST_UNIFORM: {
+            std::uniform_int_distribution<uint64_t> any(0, items - 1);
+            slots.resize(n);
+            for (uint64_t& slot : slots) {
+                slot = any(threadRng());
+            }
+            break;
+        }
+        case DIST_ZIPFIAN:
+            slots = generateZipfianSlots(n, items);
+            break;
+        case DIST_HOTSPOT:
+            slots = generateHotspotSlots(n, items);
+            break;
+        case DIST_LATEST:
+            slots = generateLatestSlots(n, items);
+            break;
+        case DIST_MOVING_WINDOW:
+            slots = generateMovingWindowSlots(n, items);
+            break;
+    }
+    std::vector<int> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = static_cast<int>(2 * slots[i]);
+    }
+    return keys;
+}
+
+template <typename Tree>
+std::unique_ptr<Tree> buildLargeTree(size_t n) {
+    std::vector<int> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = static_cast<int>(2 * i);
+    }
+    auto tree = std::make_unique<Tree>(makeTree<Tree>());
+    tree->loadSorted(keys);
+    return tree;
+}
+
+template <typename Tree>
+void runLargeScaleLookup(benchmark::State& state, KeyDistribution distribution) {
+    size_t n = state.range(0);
+    resetPeakRss();
+    auto tree = buildLargeTree<Tree>(n);
+    std::vector<int> lookups = generateLookupKeys(distribution, LARGE_SCALE_LOOKUPS, n);
+    PerfScope perf;
+    perf.resume();
+    for (auto _ : state) {
+        for (int key : lookups) {
+            benchmark::DoNotOptimize(tree->search(key));
+        }
+    }
+    perf.pause();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * lookups.size());
+    perf.report(state, state.iterations() * lookups.size());
+    reportMemory(state, *tree, n);
+}
+
+// sliding window of n live keys: every step inserts the next key above the window and
+// removes the oldest one, so updates always land on the two edges of the tree
+template <typename Tree>
+void runLargeScaleSlidingWindow(benchmark::State& state) {
+    size_t n = state.range(0);
+    resetPeakRss();
+    auto tree = buildLargeTree<Tree>(n);
+    long long oldest = 0;
+    long long next = 2 * static_cast<long long>(n);
+    for (auto _ : state) {
+        for (size_t i = 0; i < LARGE_SCALE_LOOKUPS; ++i) {
+            tree->insert(static_cast<int>(next));
+            tree->remove(static_cast<int>(oldest));
+            next += 2;
+            oldest += 2;
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * LARGE_SCALE_LOOKUPS * 2);
+    reportMemory(state, *tree, n);
+}
+
+#define LARGE_SCALE_SIZES RangeMultiplier(8)->Range(1<<10, 1<<26)->Arg(100000000)->Unit(benchmark::kMillisecond)
+
+ENGINE_BENCHMARK(AVL, LargeScale_Uniform, runLargeScaleLookup<AVLTree>(state, DIST_UNIFORM))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Scapegoat, LargeScale_Uniform, runLargeScaleLookup<ScapegoatTree>(state, DIST_UNIFORM))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Splay, LargeScale_Uniform, runLargeScaleLookup<SplayTree>(state, DIST_UNIFORM))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(AVL, LargeScale_Zipfian, runLargeScaleLookup<AVLTree>(state, DIST_ZIPFIAN))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Scapegoat, LargeScale_Zipfian, runLargeScaleLookup<ScapegoatTree>(state, DIST_ZIPFIAN))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Splay, LargeScale_Zipfian, runLargeScaleLookup<SplayTree>(state, DIST_ZIPFIAN))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(AVL, LargeScale_Hotspot, runLargeScaleLookup<AVLTree>(state, DIST_HOTSPOT))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Scapegoat, LargeScale_Hotspot, runLargeScaleLookup<ScapegoatTree>(state, DIST_HOTSPOT))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Splay, LargeScale_Hotspot, runLargeScaleLookup<SplayTree>(state, DIST_HOTSPOT))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(AVL, LargeScale_Latest, runLargeScaleLookup<AVLTree>(state, DIST_LATEST))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Scapegoat, LargeScale_Latest, runLargeScaleLookup<ScapegoatTree>(state, DIST_LATEST))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Splay, LargeScale_Latest, runLargeScaleLookup<SplayTree>(state, DIST_LATEST))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(AVL, LargeScale_MovingWindow, runLargeScaleLookup<AVLTree>(state, DIST_MOVING_WINDOW))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Scapegoat, LargeScale_MovingWindow, runLargeScaleLookup<ScapegoatTree>(state, DIST_MOVING_WINDOW))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Splay, LargeScale_MovingWindow, runLargeScaleLookup<SplayTree>(state, DIST_MOVING_WINDOW))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(AVL, LargeScale_SlidingWindowUpdates, runLargeScaleSlidingWindow<AVLTree>(state))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Scapegoat, LargeScale_SlidingWindowUpdates, runLargeScaleSlidingWindow<ScapegoatTree>(state))->LARGE_SCALE_SIZES;
+ENGINE_BENCHMARK(Splay, LargeScale_SlidingWindowUpdates, runLargeScaleSlidingWindow<SplayTree>(state))->LARGE_SCALE_SIZES;
+
+//------------------------------------------------------------------
+// 16. CONTENTION
+//------------------------------------------------------------------
+
+// range(0) threads share one tree for CONTENTION_WINDOW per iteration, each replaying its
+// own pre-generated operation stream until told to stop; range(1) percent of the operations
+// are lookups, the rest alternate between inserts and removes over twice the initial key
+// range, so the tree stays near CONTENTION_KEYS keys. reported: aggregate ops/s, Jain's
+// fairness index over the per-thread operation counts (1 = every thread got the same share)
+// and the slowest thread's share relative to the mean
+
+constexpr size_t CONTENTION_KEYS = 1 << 16;
+constexpr size_t CONTENTION_STREAM = 1 << 14; // per thread, replayed cyclically
+constexpr auto CONTENTION_WINDOW = std::chrono::milliseconds(20);
+
+struct ContentionOp {
+    int type; // 0 = search, 1 = insert, 2 = remove
+    int key;
+};
+
+template <typename Shared>
+void runContention(benchmark::State& state) {
+    size_t threads = state.range(0);
+    int readPercent = static_cast<int>(state.range(1));
+    Shared shared;
+    for (int key : generateRandomKeysLinear(CONTENTION_KEYS, 0, 2 * CONTENTION_KEYS)) {
+        shared.insert(key);
+    }
+    std::vector<std::vector<ContentionOp>> streams(threads);
+    std::uniform_int_distribution<int> anyKey(0, 2 * CONTENTION_KEYS);
+    std::uniform_int_distribution<int> percent(0, 99);
+    for (std::vector<ContentionOp>& stream : streams) {
+        stream.resize(CONTENTION_STREAM);
+        bool insertNext = true;
+        for (ContentionOp& op : stream) {
+            if (percent(threadRng()) < readPercent) {
+                op.type = 0;
+            } else {
+                op.type = insertNext ? 1 : 2;
+                insertNext = !insertNext;
+            }
+            op.key = anyKey(threadRng());
+        }
+    }
+
+    std::vector<uint64_t> totals(threads, 0);
+    for (auto _ : state) {
+        std::atomic<bool> stop(false);
+        std::vector<uint64_t> counts(threads, 0);
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                const std::vector<ContentionOp>& stream = streams[t];
+                uint64_t done = 0;
+                size_t next = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const ContentionOp& op = stream[next];
+                    next = (next + 1) & (CONTENTION_STREAM - 1);
+                    if (op.type == 0) {
+                        benchmark::DoNotOptimize(shared.search(op.key));
+                    } else if (op.type == 1) {
+                        shared.insert(op.key);
+                    } else {
+                        shared.remove(op.key);
+                    }
+                    done++;
+                }
+                counts[t] = done; // written once, so the counters never share a line while running
+            });
+        }
+        std::this_thread::sleep_for(CONTENTION_WINDOW);
+        stop.store(true, std::memory_order_relaxed);
+        auto end = std::chrono::steady_clock::now();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+        for (size_t t = 0; t < threads; ++t) {
+            totals[t] += counts[t];
+        }
+    }
+
+    double sum = 0;
+    double sumSquares = 0;
+    double slowest = static_cast<double>(totals[0]);
+    for (uint64_t total : totals) {
+        sum += total;
+        sumSquares += static_cast<double>(total) * total;
+        slowest = std::min(slowest, static_cast<double>(total));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(sum));
+    state.counters["fairness"] = sumSquares > 0 ? sum * sum / (threads * sumSquares) : 1.0;
+    state.counters["slowest_share"] = sum > 0 ? slowest * threads / sum : 1.0;
+}
+
+#define CONTENTION_ARGS ArgsProduct({{1, 2, 4, 8}, {50, 90, 99}})->UseManualTime()->Unit(benchmark::kMillisecond)
+
+ENGINE_BENCHMARK(AVL, Contention_Mutex, runContention<MutexTree<AVLTree>>(state))->CONTENTION_ARGS;
+ENGINE_BENCHMARK(Scapegoat, Contention_Mutex, runContention<MutexTree<ScapegoatTree>>(state))->CONTENTION_ARGS;
+ENGINE_BENCHMARK(Splay, Contention_Mutex, runContention<MutexTree<SplayTree>>(state))->CONTENTION_ARGS;
+#ifndef HEAPURI_TREE_STATS // counted lookups race under a shared lock, see concurrent.h
+ENGINE_BENCHMARK(AVL, Contention_SharedMutex, runContention<SharedMutexTree<AVLTree>>(state))->CONTENTION_ARGS;
+ENGINE_BENCHMARK(Scapegoat, Contention_SharedMutex, runContention<SharedMutexTree<ScapegoatTree>>(state))->CONTENTION_ARGS;
+ENGINE_BENCHMARK(AVL, Contention_Sharded, runContention<ShardedTree<AVLTree>>(state))->CONTENTION_ARGS;
+ENGINE_BENCHMARK(Scapegoat, Contention_Sharded, runContention<ShardedTree<ScapegoatTree>>(state))->CONTENTION_ARGS;
+#endif
+
+//------------------------------------------------------------------
+// 17. RANGE PARTITIONING
+//------------------------------------------------------------------
+
+// n keys 0, 2, 4, ..., a tree over each half; timed is combining them into one tree - join copies
+// both into a new tree, merge relinks the second into the first and is split apart again untimed
+template <typename Tree>
+void runRangeMerge(benchmark::State& state) {
+    size_t n = state.range(0);
+    std::vector<int> lowerKeys;
+    std::vector<int> upperKeys;
+    for (size_t i = 0; i < n; ++i) {
+        (i < n / 2 ? lowerKeys : upperKeys).push_back(static_cast<int>(2 * i));
+    }
+    Tree lower = makeTree<Tree>();
+    Tree upper = makeTree<Tree>();
+    lower.loadSorted(lowerKeys);
+    upper.loadSorted(upperKeys);
+
+    for (auto _ : state) {
+        if constexpr (hasSplitMerge<Tree>) {
+            lower.merge(upper);
+            benchmark::DoNotOptimize(lower.isEmpty());
+            state.PauseTiming();
+            upper = lower.split(upperKeys.front());
+            state.ResumeTiming();
+        } else {
+            Tree merged = lower.join(upper);
+            benchmark::DoNotOptimize(merged.isEmpty());
+            state.PauseTiming();
+            merged = Tree();
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// n keys 0, 2, 4, ...; each iteration carves a band of n/4 keys at a random offset off the tree
+// and merges it back. without split the band is copied out key by key and join copies the whole
+// tree back together, which replaces the old one
+template <typename Tree>
+void runRangePartition(benchmark::State& state) {
+    size_t n = state.range(0);
+    std::vector<int> keys;
+    for (size_t i = 0; i < n; ++i) {
+        keys.push_back(static_cast<int>(2 * i));
+    }
+    Tree tree = makeTree<Tree>();
+    tree.loadSorted(keys);
+
+    int width = static_cast<int>(n / 2);
+    std::uniform_int_distribution<int> offset(0, static_cast<int>(2 * n) - width);
+    for (auto _ : state) {
+        int lo = offset(threadRng());
+        int hi = lo + width;
+
+        if constexpr (hasSplitMerge<Tree>) {
+            Tree band = tree.split(lo);
+            Tree rest = band.split(hi);
+            tree.merge(rest);
+            benchmark::DoNotOptimize(band.isEmpty());
+            tree.merge(band);
+        } else {
+            std::vector<int> bandKeys = tree.rangeQuery(lo, hi - 1);
+            Tree band = makeTree<Tree>();
+            for (int key : bandKeys) {
+                band.insert(key);
+                tree.remove(key);
+            }
+            benchmark::DoNotOptimize(band.isEmpty());
+            tree = tree.join(band);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+#define RANGE_PARTITION_SIZES Range(1<<10, 1<<18)->Unit(benchmark::kMicrosecond)
+
+ENGINE_BENCHMARK(AVL, RangeMerge, runRangeMerge<AVLTree>(state))->RANGE_PARTITION_SIZES;
+ENGINE_BENCHMARK(WAVL, RangeMerge, runRangeMerge<WAVLTree>(state))->RANGE_PARTITION_SIZES;
+ENGINE_BENCHMARK(Scapegoat, RangeMerge, runRangeMerge<ScapegoatTree>(state))->RANGE_PARTITION_SIZES;
+ENGINE_BENCHMARK(Treap, RangeMerge, runRangeMerge<TreapTree>(state))->RANGE_PARTITION_SIZES;
+ENGINE_BENCHMARK(AVL, RangePartition, runRangePartition<AVLTree>(state))->RANGE_PARTITION_SIZES;
+ENGINE_BENCHMARK(WAVL, RangePartition, runRangePartition<WAVLTree>(state))->RANGE_PARTITION_SIZES;
+ENGINE_BENCHMARK(Scapegoat, RangePartition, runRangePartition<ScapegoatTree>(state))->RANGE_PARTITION_SIZES;
+ENGINE_BENCHMARK(Treap, RangePartition, runRangePartition<TreapTree>(state))->RANGE_PARTITION_SIZES;
+
+// same as BENCHMARK_MAIN, plus --seed=N to replay the inputs of an earlier run (the seed in
+// use is printed with the context so that any run can be repeated) and --perf_counters to
+// add hardware counters per operation to the benchmarks that use PerfScope
+int main(int argc, char** argv) {
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--seed=", 0) == 0) {
+            // digits only, stoull would wrap a sign and throw on anything else
+            std::string digits = arg.substr(7);
+            const char* end = digits.data() + digits.size();
+            auto parsed = std::from_chars(digits.data(), end, g_seed);
+            if (digits.empty() || parsed.ec != std::errc() || parsed.ptr != end) {
+                std::fprintf(stderr, "usage: %s [--seed=N] [--perf_counters] [benchmark flags], N is an unsigned 64-bit integer\n", argv[0]);
+                return 2;
+            }
+        } else if (arg == "--perf_counters") {
+            g_perfCounters = true;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    if (g_perfCounters && !PerfCounters().anyAvailable()) {
+        std::fprintf(stderr, "perf_event_open offers no hardware counters here, --perf_counters ignored\n");
+        g_perfCounters = false;
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::AddCustomContext("seed", std::to_string(g_seed));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
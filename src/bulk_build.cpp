@@ -0,0 +1,209 @@
+#include "snapshot.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+// smallest read buffer per merge input, below this the merge degenerates into seeks
+constexpr size_t MIN_MERGE_BUFFER = 64 * 1024;
+
+// sequential reader of native int32 keys through a fixed buffer
+class KeyReader {
+private:
+    std::ifstream in;
+    std::vector<int> buffer;
+    size_t position;
+    size_t filled;
+
+public:
+    KeyReader(const std::string& path, size_t bufferKeys)
+        : in(path, std::ios::binary), buffer(bufferKeys), position(0), filled(0) {
+        if (!in) {
+            throw std::runtime_error("Cannot open key file " + path);
+        }
+    }
+
+    bool next(int& key) {
+        if (position == filled) {
+            in.read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(int));
+            filled = in.gcount() / sizeof(int);
+            position = 0;
+            if (filled == 0) return false;
+        }
+        key = buffer[position++];
+        return true;
+    }
+};
+
+using Checksum = uint64_t (*)(const int* keys, size_t count, uint64_t hash);
+
+// sequential writer of native int32 keys through a fixed buffer, drops repeats of the
+// previous key and keeps a running checksum of what it wrote
+class KeyWriter {
+private:
+    std::ofstream out;
+    std::string path;
+    std::vector<int> buffer;
+    size_t filled;
+    uint64_t written;
+    uint64_t hash;
+    Checksum checksum; // null for intermediate runs
+    int last;
+
+public:
+    KeyWriter(const std::string& path, size_t bufferKeys, Checksum checksum, uint64_t seed)
+        : out(path, std::ios::binary | std::ios::trunc), path(path), buffer(bufferKeys), filled(0), written(0),
+          hash(seed), checksum(checksum), last(0) {
+        if (!out) {
+            throw std::runtime_error("Cannot create file " + path);
+        }
+    }
+
+    std::ofstream& stream() { return out; }
+    uint64_t count() const { return written; }
+    uint64_t digest() const { return hash; }
+
+    void put(int key) {
+        if (written > 0 && (filled > 0 ? buffer[filled - 1] : last) == key) return;
+        if (filled == buffer.size()) flush();
+        buffer[filled++] = key;
+        written++;
+    }
+
+    void flush() {
+        if (filled == 0) return;
+        if (checksum) hash = checksum(buffer.data(), filled, hash);
+        out.write(reinterpret_cast<const char*>(buffer.data()), filled * sizeof(int));
+        last = buffer[filled - 1];
+        filled = 0;
+        if (!out) {
+            throw std::runtime_error("Cannot write file " + path);
+        }
+    }
+};
+
+// removes spilled runs on every exit path
+struct RunFiles {
+    std::vector<std::string> paths;
+    ~RunFiles() {
+        for (const std::string& path : paths) std::remove(path.c_str());
+    }
+};
+
+// k-way merge of sorted runs into writer, duplicates collapse in the writer
+void mergeRuns(const std::vector<std::string>& runs, size_t bufferKeys, KeyWriter& writer) {
+    std::vector<KeyReader> readers;
+    readers.reserve(runs.size());
+    using Head = std::pair<int, size_t>; // (key, run)
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        readers.emplace_back(runs[i], bufferKeys);
+        int key;
+        if (readers[i].next(key)) heads.push({key, i});
+    }
+    while (!heads.empty()) {
+        auto [key, run] = heads.top();
+        heads.pop();
+        writer.put(key);
+        if (readers[run].next(key)) heads.push({key, run});
+    }
+    writer.flush();
+}
+
+}
+
+BulkBuildStats TreeSnapshot::buildFromKeyFile(const std::string& keyPath, const std::string& outputPath,
+                                              size_t memoryBytes) {
+    memoryBytes = std::max(memoryBytes, 2 * MIN_MERGE_BUFFER);
+    BulkBuildStats stats;
+    RunFiles runs;
+
+    // pass 1: fill the whole budget, sort and spill it as one run
+    std::vector<int> chunk(memoryBytes / sizeof(int));
+    std::ifstream in(keyPath, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open key file " + keyPath);
+    }
+    bool inputFitsInMemory = false;
+    while (true) {
+        in.read(reinterpret_cast<char*>(chunk.data()), chunk.size() * sizeof(int));
+        size_t keysRead = in.gcount() / sizeof(int);
+        if (keysRead == 0) break;
+        stats.keysRead += keysRead;
+        std::sort(chunk.begin(), chunk.begin() + keysRead);
+        size_t unique = std::unique(chunk.begin(), chunk.begin() + keysRead) - chunk.begin();
+
+        if (runs.paths.empty() && in.peek() == std::ifstream::traits_type::eof()) {
+            // everything fit, skip the spill and merge
+            chunk.resize(unique);
+            inputFitsInMemory = true;
+            break;
+        }
+        runs.paths.push_back(outputPath + ".run" + std::to_string(runs.paths.size()));
+        std::ofstream run(runs.paths.back(), std::ios::binary | std::ios::trunc);
+        run.write(reinterpret_cast<const char*>(chunk.data()), unique * sizeof(int));
+        run.close(); // a short write or ENOSPC may only surface at the flush
+        if (!run) {
+            throw std::runtime_error("Cannot write run file " + runs.paths.back());
+        }
+    }
+    in.close();
+    stats.runs = runs.paths.size();
+    if (runs.paths.empty() && !inputFitsInMemory) {
+        chunk.clear(); // empty key file
+        inputFitsInMemory = true;
+    }
+    if (!inputFitsInMemory) {
+        std::vector<int>().swap(chunk); // hand the budget over to the merge buffers
+    }
+
+    // merge passes: at most fanIn runs at a time, each with a share of the budget
+    size_t fanIn = std::max<size_t>(2, memoryBytes / MIN_MERGE_BUFFER - 1);
+    size_t bufferKeys = memoryBytes / (fanIn + 1) / sizeof(int);
+    size_t nextRun = runs.paths.size();
+    size_t firstLive = 0;
+    while (runs.paths.size() - firstLive > fanIn) {
+        std::vector<std::string> merged;
+        for (size_t group = firstLive; group < runs.paths.size(); group += fanIn) {
+            size_t end = std::min(runs.paths.size(), group + fanIn);
+            std::vector<std::string> inputs(runs.paths.begin() + group, runs.paths.begin() + end);
+            merged.push_back(outputPath + ".run" + std::to_string(nextRun++));
+            KeyWriter writer(merged.back(), bufferKeys, nullptr, 0);
+            mergeRuns(inputs, bufferKeys, writer);
+            for (const std::string& input : inputs) std::remove(input.c_str());
+        }
+        firstLive = runs.paths.size();
+        runs.paths.insert(runs.paths.end(), merged.begin(), merged.end());
+        stats.mergePasses++;
+    }
+
+    // final pass: header placeholder, slot 0 pad, keys, then the real header
+    SnapshotHeader header = makeHeader(SNAPSHOT_SORTED, 0, 0);
+    KeyWriter writer(outputPath, inputFitsInMemory ? 1 : bufferKeys, checksumOf, FNV_OFFSET);
+    const char padding[KEYS_ALIGNMENT + sizeof(int)] = {};
+    writer.stream().write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writer.stream().write(padding, header.keysOffset - sizeof(header) + sizeof(int));
+    if (inputFitsInMemory) {
+        uint64_t hash = checksumOf(chunk.data(), chunk.size(), FNV_OFFSET);
+        writer.stream().write(reinterpret_cast<const char*>(chunk.data()), chunk.size() * sizeof(int));
+        header = makeHeader(SNAPSHOT_SORTED, chunk.size(), hash);
+    } else {
+        std::vector<std::string> inputs(runs.paths.begin() + firstLive, runs.paths.end());
+        mergeRuns(inputs, bufferKeys, writer);
+        stats.mergePasses++;
+        header = makeHeader(SNAPSHOT_SORTED, writer.count(), writer.digest());
+    }
+    stats.keysWritten = header.keyCount;
+    writer.stream().seekp(0);
+    writer.stream().write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writer.stream().close();
+    if (!writer.stream()) {
+        throw std::runtime_error("Cannot write snapshot file " + outputPath);
+    }
+    return stats;
+}
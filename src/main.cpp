@@ -1,6 +1,20 @@
 #include "avl.h"
 #include "scapegoat.h"
+#include "wavl.h"
+#include "weight_balanced.h"
+#include "treap.h"
+#include "splay.h"
+#include "snapshot.h"
+#include "trace.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <iostream>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 void testAVLTree() {
     std::cout << "\n=== AVL Tree ===\n" << std::endl;
@@ -161,7 +175,105 @@ void testScapegoatTree() {
     joinedTree.printRange(0, 100);
 }
 
-int main() {
+// heapuri build <key file> <snapshot file> [memory MB]
+// streams a file of native int32 keys into a sorted snapshot in bounded memory
+int runBulkBuild(int argc, char** argv) {
+    auto usage = [argv]() {
+        std::cerr << "usage: " << argv[0] << " build <key file> <snapshot file> [memory MB]" << std::endl;
+        return 2;
+    };
+    if (argc < 4 || argc > 5) {
+        return usage();
+    }
+    size_t memoryMB = 256;
+    if (argc == 5) {
+        // digits only, stoull would take a sign or leading blanks; the MB must fit in bytes
+        std::string text = argv[4];
+        if (text.empty() || !std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            return usage();
+        }
+        try {
+            unsigned long long value = std::stoull(text);
+            if (value > std::numeric_limits<size_t>::max() >> 20) {
+                return usage();
+            }
+            memoryMB = static_cast<size_t>(value);
+        } catch (const std::out_of_range&) {
+            return usage();
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    BulkBuildStats stats;
+    try {
+        stats = TreeSnapshot::buildFromKeyFile(argv[2], argv[3], memoryMB << 20);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Build error: " << e.what() << std::endl;
+        return 1;
+    } catch (const std::bad_alloc&) {
+        std::cerr << "Build error: cannot allocate " << memoryMB << " MB of buffers" << std::endl;
+        return 1;
+    } catch (const std::length_error&) {
+        std::cerr << "Build error: cannot allocate " << memoryMB << " MB of buffers" << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double megabytes = stats.keysRead * sizeof(int) / double(1 << 20);
+
+    std::cout << "Keys read: " << stats.keysRead << ", unique keys written: " << stats.keysWritten << std::endl;
+    std::cout << "Sorted runs: " << stats.runs << ", merge passes: " << stats.mergePasses << std::endl;
+    std::cout << "Time: " << seconds << " s, " << megabytes / seconds << " MB/s" << std::endl;
+    return 0;
+}
+
+// heapuri replay <trace file> [avl|scapegoat|wavl|weight-balanced|treap|splay]
+// drives a tree through a recorded operation trace and reports throughput and latency
+template <typename Tree>
+void printReplay(const std::string& name, const OperationTrace& trace) {
+    // one untimed-per-operation pass for throughput, one timed pass for percentiles
+    Tree throughputTree;
+    ReplayResult throughput = replayTrace(throughputTree, trace, false);
+    Tree latencyTree;
+    ReplayResult timed = replayTrace(latencyTree, trace, true);
+
+    std::cout << name << ": " << throughput.operations << " operations in " << throughput.seconds << " s, "
+              << throughput.operations / throughput.seconds << " ops/s" << std::endl;
+    std::cout << "  latency p50 " << timed.latency.percentile(50.0) << " ns, p99 " << timed.latency.percentile(99.0)
+              << " ns, p99.9 " << timed.latency.percentile(99.9) << " ns, max " << timed.latency.max() << " ns"
+              << std::endl;
+    std::cout << "  result digest " << std::hex << throughput.digest << std::dec << std::endl;
+}
+
+int runReplay(int argc, char** argv) {
+    const std::vector<std::string> engines = {"avl", "scapegoat", "wavl", "weight-balanced", "treap", "splay"};
+    std::string engine = argc == 4 ? argv[3] : "";
+    if (argc < 3 || argc > 4 || (!engine.empty() && std::find(engines.begin(), engines.end(), engine) == engines.end())) {
+        std::cerr << "usage: " << argv[0] << " replay <trace file> [avl|scapegoat|wavl|weight-balanced|treap|splay]" << std::endl;
+        return 2;
+    }
+    try {
+        OperationTrace trace = OperationTrace::open(argv[2]);
+        if (engine.empty() || engine == "avl") printReplay<AVLTree>("AVL", trace);
+        if (engine.empty() || engine == "scapegoat") printReplay<ScapegoatTree>("Scapegoat", trace);
+        if (engine.empty() || engine == "wavl") printReplay<WAVLTree>("WAVL", trace);
+        if (engine.empty() || engine == "weight-balanced") printReplay<WeightBalancedTree>("WeightBalanced", trace);
+        if (engine.empty() || engine == "treap") printReplay<TreapTree>("Treap", trace);
+        if (engine.empty() || engine == "splay") printReplay<SplayTree>("Splay", trace);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Replay error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "build") {
+        return runBulkBuild(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "replay") {
+        return runReplay(argc, argv);
+    }
+
     testAVLTree();
     testScapegoatTree();
     
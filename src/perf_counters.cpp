@@ -0,0 +1,84 @@
+#include "perf_counters.h"
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+struct EventConfig {
+    uint32_t type;
+    uint64_t config;
+    const char* name;
+};
+
+const EventConfig EVENTS[PERF_EVENT_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "cache_misses"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch_misses"},
+    {PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+     "dtlb_misses"},
+};
+
+int openEvent(const EventConfig& event) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // this thread only, on any CPU, no group leader
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+}
+
+// PUBLIC METHODS
+PerfCounters::PerfCounters() {
+    for (int i = 0; i < PERF_EVENT_COUNT; ++i) {
+        fds[i] = openEvent(EVENTS[i]);
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+bool PerfCounters::anyAvailable() const {
+    for (int fd : fds) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
+
+void PerfCounters::start() {
+    for (int fd : fds) {
+        if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void PerfCounters::stop() {
+    for (int fd : fds) {
+        if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+}
+
+uint64_t PerfCounters::count(PerfEvent event) const {
+    uint64_t values[3]; // value, time enabled, time running
+    if (fds[event] < 0 || read(fds[event], values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+        return 0;
+    }
+    if (values[2] == values[1]) return values[0];
+    return static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+}
+
+const char* PerfCounters::name(PerfEvent event) {
+    return EVENTS[event].name;
+}
@@ -1,10 +1,25 @@
 #include "scapegoat.h"
+#include "snapshot.h"
+#include <limits>
 #include <stdexcept>
+#include <utility>
 
 // PRIVATE METHODS
 int ScapegoatTree::sizeOf(SGNode *node) {
-    if (!node) return 0;
-    return 1 + sizeOf(node->left) + sizeOf(node->right);
+    return node ? node->size : 0;
+}
+
+int ScapegoatTree::liveOf(SGNode *node) const {
+    return node ? node->live : 0;
+}
+
+bool ScapegoatTree::exceedsDepthBound(int depth) const {
+    return depth >= depthThresholdsSize || size < depthThresholds[depth];
+}
+
+void ScapegoatTree::updateSize(SGNode *node) {
+    node->size = 1 + sizeOf(node->left) + sizeOf(node->right);
+    node->live = (node->dead ? 0 : 1) + liveOf(node->left) + liveOf(node->right);
 }
 
 bool ScapegoatTree::isAlphaWeightBalanced(SGNode *node, double alpha) {
@@ -39,6 +54,7 @@ SGNode* ScapegoatTree::findScapegoat(SGNode *node, int key) {
 
 void ScapegoatTree::flattenToVector(SGNode *node, std::vector<SGNode*> &nodes) {
     if (!node) return;
+    TREE_STATS(stats.nodesVisited++);
     
     flattenToVector(node->left, nodes);
     nodes.push_back(node);
@@ -53,6 +69,7 @@ SGNode* ScapegoatTree::rebuildTree(const std::vector<SGNode*> &nodes, int start,
     
     node->left = rebuildTree(nodes, start, mid - 1);
     node->right = rebuildTree(nodes, mid + 1, end);
+    updateSize(node);
     
     return node;
 }
@@ -62,11 +79,33 @@ SGNode* ScapegoatTree::rebuildSubtree(SGNode *scapegoat) {
     
     std::vector<SGNode*> nodes;
     flattenToVector(scapegoat, nodes);
+    scratchPeak = std::max(scratchPeak, nodes.capacity() * sizeof(SGNode*));
+    
+    // rebuilding the whole tree drops tombstones, a subtree rebuild keeps them so that the
+    // counts of the ancestors above it stay valid
+    if (deadCount > 0 && scapegoat == root) {
+        size_t kept = 0;
+        for (SGNode *node : nodes) {
+            if (node->dead) {
+                delete node;
+                deadCount--;
+            } else {
+                nodes[kept++] = node;
+            }
+        }
+        nodes.resize(kept);
+    }
     
     // check if nodes vector is empty
     if (nodes.empty()) {
         return nullptr;
     }
+
+    rebuilds++;
+    windowNodesRebuilt += nodes.size();
+    rebuildFinished = true;
+    TREE_STATS(stats.rebuilds++);
+    TREE_STATS(stats.nodesRebuilt += nodes.size());
     
     for (auto node : nodes) {
         node->left = nullptr;
@@ -83,27 +122,33 @@ SGNode* ScapegoatTree::insertRecursive(SGNode *node, int key) {
         return new SGNode(key);
     }
     
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
     if (key < node->key) {
         node->left = insertRecursive(node->left, key);
     } else if (key > node->key) {
         node->right = insertRecursive(node->right, key);
     } else {
-        // duplicate keys not allowed
-        return node;
-    }
-    
-    // check if rebalancing is needed
-    if (size > std::log(maxSize) / std::log(1/alpha)) {
-        node = rebuildSubtree(node);
-        maxSize = size;
+        // duplicate keys not allowed, a tombstone is brought back to life
+        if (!node->dead) return node;
+        node->dead = false;
+        deadCount--;
+        size++;
+        maxSize = std::max(maxSize, size);
     }
+    updateSize(node);
     
     return node;
 }
 
 SGNode* ScapegoatTree::searchRecursive(SGNode *node, int key) const {
-    if (!node || node->key == key) {
-        return node;
+    if (!node) return nullptr;
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    if (node->key == key) {
+        return node->dead ? nullptr : node;
     }
     
     if (key < node->key) {
@@ -113,64 +158,84 @@ SGNode* ScapegoatTree::searchRecursive(SGNode *node, int key) const {
     }
 }
 
+// every node of the subtree, dead ones included
+size_t ScapegoatTree::countNodes(const SGNode *node) {
+    return node ? 1 + countNodes(node->left) + countNodes(node->right) : 0;
+}
+
+// smallest live key in the subtree, live counts steer around dead subtrees
 SGNode* ScapegoatTree::findMin(SGNode* node) const {
-    if (!node) return nullptr;
-    
-    SGNode* current = node;
-    while (current->left) {
-        current = current->left;
+    while (node && node->live > 0) {
+        TREE_STATS(stats.nodesVisited++);
+        if (liveOf(node->left) > 0) {
+            node = node->left;
+        } else if (!node->dead) {
+            return node;
+        } else {
+            node = node->right;
+        }
     }
-    return current;
+    return nullptr;
 }
 
+// largest live key in the subtree
 SGNode* ScapegoatTree::findMax(SGNode* node) const {
-    if (!node) return nullptr;
-    
-    SGNode* current = node;
-    while (current->right) {
-        current = current->right;
+    while (node && node->live > 0) {
+        TREE_STATS(stats.nodesVisited++);
+        if (liveOf(node->right) > 0) {
+            node = node->right;
+        } else if (!node->dead) {
+            return node;
+        } else {
+            node = node->left;
+        }
     }
-    return current;
+    return nullptr;
 }
 
 SGNode* ScapegoatTree::floorRecursive(SGNode* node, int key) const {
-    if (!node) return nullptr;
+    if (!node || node->live == 0) return nullptr;
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
     
     // if key equals node's key, we found exact floor
-    if (node->key == key) return node;
+    if (node->key == key && !node->dead) return node;
     
-    // if key is smaller than node's key, look in left subtree
-    if (key < node->key) return floorRecursive(node->left, key);
+    // if key is smaller than node's key (or node is a dead match), look in left subtree
+    if (key <= node->key) return floorRecursive(node->left, key);
     
     // if key is greater than node's key, look in right subtree
     // the current node could be the floor, but we might find a closer one in right subtree
     SGNode* rightFloor = floorRecursive(node->right, key);
     if (rightFloor) return rightFloor;
     
-    // if nothing found in right subtree, this node is the floor
-    return node;
+    // if nothing found in right subtree, this node is the floor (or the largest live key below a dead one)
+    return node->dead ? findMax(node->left) : node;
 }
 
 SGNode* ScapegoatTree::ceilingRecursive(SGNode* node, int key) const {
-    if (!node) return nullptr;
+    if (!node || node->live == 0) return nullptr;
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
     
     // if key equals node's key, we found exact ceiling
-    if (node->key == key) return node;
+    if (node->key == key && !node->dead) return node;
     
-    // if key is greater than node's key, look in right subtree
-    if (key > node->key) return ceilingRecursive(node->right, key);
+    // if key is greater than node's key (or node is a dead match), look in right subtree
+    if (key >= node->key) return ceilingRecursive(node->right, key);
     
     // if key is smaller than node's key, look in left subtree
     // the current node could be the ceiling, but we might find a closer one in left subtree
     SGNode* leftCeiling = ceilingRecursive(node->left, key);
     if (leftCeiling) return leftCeiling;
     
-    // if nothing found in left subtree, this node is the ceiling
-    return node;
+    // if nothing found in left subtree, this node is the ceiling (or the smallest live key above a dead one)
+    return node->dead ? findMin(node->right) : node;
 }
 
 void ScapegoatTree::rangeQueryRecursive(SGNode* node, int x, int y, std::vector<int>& result) const {
-    if (!node) return;
+    if (!node || node->live == 0) return;
+    TREE_STATS(stats.nodesVisited++);
     
     // if node's key is greater than x, explore left subtree
     if (x < node->key) {
@@ -178,7 +243,7 @@ void ScapegoatTree::rangeQueryRecursive(SGNode* node, int x, int y, std::vector<
     }
     
     // add current node's key if it's within range [x, y]
-    if (x <= node->key && node->key <= y) {
+    if (x <= node->key && node->key <= y && !node->dead) {
         result.push_back(node->key);
     }
     
@@ -188,8 +253,64 @@ void ScapegoatTree::rangeQueryRecursive(SGNode* node, int x, int y, std::vector<
     }
 }
 
+void ScapegoatTree::floorBatchRecursive(SGNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                                  const SGNode* best, std::vector<std::optional<int>>& result) const {
+    if (lo >= hi) return;
+
+    // fell off the tree (or into a dead subtree), every probe still in [lo, hi) shares the same floor
+    if (!node || node->live == 0) {
+        for (size_t i = lo; i < hi; ++i) {
+            result[i] = best ? std::optional<int>(best->key) : std::nullopt;
+        }
+        return;
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    // probes smaller than node's key continue left, the rest have node as floor candidate
+    // (a dead node hands over to the largest live key below it)
+    size_t split = std::lower_bound(probes.begin() + lo, probes.begin() + hi, node->key) - probes.begin();
+    floorBatchRecursive(node->left, probes, lo, split, best, result);
+    const SGNode* candidate = node;
+    if (node->dead && split < hi) {
+        candidate = findMax(node->left);
+        if (!candidate) candidate = best;
+    }
+    floorBatchRecursive(node->right, probes, split, hi, candidate, result);
+}
+
+void ScapegoatTree::ceilingBatchRecursive(SGNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                                    const SGNode* best, std::vector<std::optional<int>>& result) const {
+    if (lo >= hi) return;
+
+    // fell off the tree (or into a dead subtree), every probe still in [lo, hi) shares the same ceiling
+    if (!node || node->live == 0) {
+        for (size_t i = lo; i < hi; ++i) {
+            result[i] = best ? std::optional<int>(best->key) : std::nullopt;
+        }
+        return;
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    // probes up to node's key have node as ceiling candidate and continue left, the rest go right
+    // (a dead node hands over to the smallest live key above it)
+    size_t split = std::upper_bound(probes.begin() + lo, probes.begin() + hi, node->key) - probes.begin();
+    const SGNode* candidate = node;
+    if (node->dead && lo < split) {
+        candidate = findMin(node->right);
+        if (!candidate) candidate = best;
+    }
+    ceilingBatchRecursive(node->left, probes, lo, split, candidate, result);
+    ceilingBatchRecursive(node->right, probes, split, hi, best, result);
+}
+
 SGNode* ScapegoatTree::deleteRecursive(SGNode *node, int key) {
     if (!node) return nullptr;
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
     
     if (key < node->key) {
         node->left = deleteRecursive(node->left, key);
@@ -224,6 +345,7 @@ SGNode* ScapegoatTree::deleteRecursive(SGNode *node, int key) {
         // delete the successor
         node->right = deleteRecursive(node->right, current->key);
     }
+    updateSize(node);
     
     return node;
 }
@@ -236,15 +358,563 @@ void ScapegoatTree::destroyRecursive(SGNode *node) {
     }
 }
 
+// the live tree, an in-flight shadow and retired nodes not yet freed
+void ScapegoatTree::releaseNodes() {
+    destroyRecursive(root);
+    destroyRecursive(shadowRoot);
+    for (SGNode *node : reclaimStack) {
+        destroyRecursive(node);
+    }
+}
+
+// INCREMENTAL REBUILD
+int ScapegoatTree::syncRebuildLimit() const {
+    int bits = 1;
+    for (int s = size; s > 1; s >>= 1) {
+        bits++;
+    }
+    return SYNC_REBUILD_FACTOR * bits;
+}
+
+SGNode** ScapegoatTree::findScapegoatLink(SGNode *&subtreeRoot, int key, long long &low, long long &high) {
+    // walk from subtreeRoot down to the node holding key, the last alpha-weight-unbalanced node
+    // passed is the lowest one on the path; subtree sizes make this O(depth)
+    SGNode **scapegoat = nullptr;
+    SGNode **link = &subtreeRoot;
+    long long lo = NO_LOWER_BOUND;
+    long long hi = NO_UPPER_BOUND;
+    while (*link) {
+        TREE_STATS(stats.nodesVisited++);
+        if (!isAlphaWeightBalanced(*link, alpha)) {
+            scapegoat = link;
+            low = lo;
+            high = hi;
+        }
+        int nodeKey = (*link)->key;
+        if (key == nodeKey) break;
+        if (key < nodeKey) {
+            hi = nodeKey;
+            link = &(*link)->left;
+        } else {
+            lo = nodeKey;
+            link = &(*link)->right;
+        }
+    }
+    return scapegoat;
+}
+
+SGNode** ScapegoatTree::findDeleteScapegoatLink(int key, long long &low, long long &high) {
+    // walk the path a delete shortened, equal keys go right (a successor copied up into the
+    // removed key's node was unlinked from the leftmost end of its right subtree)
+    SGNode **link = &root;
+    long long lo = NO_LOWER_BOUND;
+    long long hi = NO_UPPER_BOUND;
+    while (*link) {
+        TREE_STATS(stats.nodesVisited++);
+        // the first unbalanced node from the top is the highest one
+        if (!isAlphaWeightBalanced(*link, alpha)) {
+            low = lo;
+            high = hi;
+            return link;
+        }
+        int nodeKey = (*link)->key;
+        if (key < nodeKey) {
+            hi = nodeKey;
+            link = &(*link)->left;
+        } else {
+            lo = nodeKey;
+            link = &(*link)->right;
+        }
+    }
+    return nullptr;
+}
+
+void ScapegoatTree::startIncrementalRebuild(long long low, long long high, int nodes) {
+    if (phase != REBUILD_IDLE || !root) return;
+    
+    rebuilds++;
+    TREE_STATS(stats.rebuilds++);
+    phase = REBUILD_COLLECT;
+    rebuildLow = low;
+    rebuildHigh = high;
+    shadowKeys.clear();
+    collectCursor = low;
+    // every node is collected once and built once
+    rebuildWorkLeft = 2LL * nodes;
+    deepInsertsLeft = REBUILD_DEPTH_SLACK;
+}
+
+void ScapegoatTree::abortIncrementalRebuild() {
+    if (shadowRoot) {
+        reclaimStack.push_back(shadowRoot);
+    }
+    shadowRoot = nullptr;
+    buildStack.clear();
+    std::vector<int>().swap(shadowKeys);
+    pendingOps.clear();
+    pendingIndex = 0;
+    rebuildWorkLeft = 0;
+    phase = REBUILD_IDLE;
+}
+
+void ScapegoatTree::recordUpdate(int key, bool inserted) {
+    if (phase == REBUILD_IDLE || key <= rebuildLow || key >= rebuildHigh) return;
+    
+    // while collecting, the cursor still sees keys above the last collected one in the live tree
+    if (phase == REBUILD_COLLECT && key > collectCursor) return;
+    
+    pendingOps.push_back({key, inserted});
+    rebuildWorkLeft++;
+}
+
+void ScapegoatTree::shadowInsert(int key) {
+    std::vector<SGNode*> path;
+    SGNode **link = &shadowRoot;
+    while (*link) {
+        if ((*link)->key == key) return;
+        path.push_back(*link);
+        link = (key < (*link)->key) ? &(*link)->left : &(*link)->right;
+    }
+    *link = new SGNode(key);
+    for (SGNode *node : path) {
+        node->size++;
+        node->live++;
+    }
+    
+    // keep replayed inserts from growing a long path in the shadow, small scapegoats only
+    if (exceedsDepthBound(static_cast<int>(path.size()))) {
+        long long low, high;
+        SGNode **scapegoat = findScapegoatLink(shadowRoot, key, low, high);
+        if (scapegoat && (*scapegoat)->size <= syncRebuildLimit()) {
+            *scapegoat = rebuildSubtree(*scapegoat);
+        }
+    }
+}
+
+void ScapegoatTree::shadowRemove(int key) {
+    std::vector<SGNode*> path;
+    SGNode **link = &shadowRoot;
+    while (*link && (*link)->key != key) {
+        path.push_back(*link);
+        link = (key < (*link)->key) ? &(*link)->left : &(*link)->right;
+    }
+    SGNode *node = *link;
+    if (!node) return;
+    for (SGNode *ancestor : path) {
+        ancestor->size--;
+        ancestor->live--;
+    }
+    
+    if (!node->left) {
+        *link = node->right;
+    } else if (!node->right) {
+        *link = node->left;
+    } else {
+        // splice the inorder successor into node's place
+        SGNode **successorLink = &node->right;
+        while ((*successorLink)->left) {
+            (*successorLink)->size--;
+            (*successorLink)->live--;
+            successorLink = &(*successorLink)->left;
+        }
+        SGNode *successor = *successorLink;
+        *successorLink = successor->right;
+        successor->left = node->left;
+        successor->right = node->right;
+        successor->size = node->size - 1;
+        successor->live = node->live - 1;
+        *link = successor;
+    }
+    delete node;
+}
+
+void ScapegoatTree::collectStep(int &budget) {
+    // re-seek the in-order cursor every update, the live tree may have changed since the last one
+    long long cursor = collectCursor;
+    std::vector<SGNode*> stack;
+    SGNode *node = root;
+    while (node) {
+        if (node->key > cursor) {
+            stack.push_back(node);
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+    
+    for (; budget > 0; --budget, --rebuildWorkLeft) {
+        if (stack.empty() || stack.back()->key >= rebuildHigh) {
+            // every key of the range collected, build the shadow
+            TREE_STATS(stats.nodesRebuilt += shadowKeys.size());
+            shadowRoot = nullptr;
+            if (!shadowKeys.empty()) {
+                buildStack.push_back({0, static_cast<int>(shadowKeys.size()) - 1, &shadowRoot});
+            }
+            phase = REBUILD_BUILD;
+            return;
+        }
+        
+        node = stack.back();
+        stack.pop_back();
+        collectCursor = node->key;
+        if (!node->dead) {
+            shadowKeys.push_back(node->key);
+        }
+        for (node = node->right; node; node = node->left) {
+            stack.push_back(node);
+        }
+    }
+}
+
+void ScapegoatTree::buildStep(int &budget) {
+    for (; budget > 0; --budget, --rebuildWorkLeft) {
+        if (buildStack.empty()) {
+            pendingIndex = 0;
+            phase = REBUILD_REPLAY;
+            return;
+        }
+        
+        // one shadow node per unit, the middle key of a pending range
+        BuildRange range = buildStack.back();
+        buildStack.pop_back();
+        int mid = (range.start + range.end) / 2;
+        SGNode *node = new SGNode(shadowKeys[mid]);
+        node->size = range.end - range.start + 1;
+        node->live = node->size;
+        *range.link = node;
+        
+        if (mid + 1 <= range.end) {
+            buildStack.push_back({mid + 1, range.end, &node->right});
+        }
+        if (range.start <= mid - 1) {
+            buildStack.push_back({range.start, mid - 1, &node->left});
+        }
+    }
+}
+
+void ScapegoatTree::replayStep(int &budget) {
+    // logged updates keep arriving, at most one per update, so the budget outpaces them
+    for (; budget > 0 && pendingIndex < pendingOps.size(); --budget, --rebuildWorkLeft) {
+        const std::pair<int, bool> &op = pendingOps[pendingIndex++];
+        if (op.second) {
+            shadowInsert(op.first);
+        } else {
+            shadowRemove(op.first);
+        }
+    }
+    if (pendingIndex < pendingOps.size()) return;
+    
+    // find the live subtree covering exactly (rebuildLow, rebuildHigh)
+    SGNode **link = &root;
+    long long lo = NO_LOWER_BOUND;
+    long long hi = NO_UPPER_BOUND;
+    while (*link) {
+        int nodeKey = (*link)->key;
+        if (nodeKey <= rebuildLow) {
+            lo = nodeKey;
+            link = &(*link)->right;
+        } else if (nodeKey >= rebuildHigh) {
+            hi = nodeKey;
+            link = &(*link)->left;
+        } else {
+            break;
+        }
+    }
+    
+    // an ancestor bounding the range was deleted or restructured, the shadow no longer fits
+    if (lo != rebuildLow || hi != rebuildHigh) {
+        abortIncrementalRebuild();
+        return;
+    }
+    
+    // the shadow holds exactly the live keys of the range, swap it in and retire the old nodes;
+    // tombstones among them leave the tree, so the ancestors above shrink by that many
+    if (*link) {
+        int dropped = (*link)->size - (*link)->live;
+        deadCount -= dropped;
+        for (SGNode *node = root; dropped > 0 && node != *link;) {
+            node->size -= dropped;
+            node = (node->key <= rebuildLow) ? node->right : node->left;
+        }
+        reclaimStack.push_back(*link);
+    }
+    *link = shadowRoot;
+    shadowRoot = nullptr;
+    windowNodesRebuilt += shadowKeys.size();
+    rebuildFinished = true;
+    if (rebuildLow == NO_LOWER_BOUND && rebuildHigh == NO_UPPER_BOUND) {
+        maxSize = size;
+        // each replayed update deepened the balanced shadow by at most one level
+        deepestInsert = balancedHeight(static_cast<int>(shadowKeys.size())) + static_cast<int>(pendingOps.size());
+    }
+    std::vector<int>().swap(shadowKeys);
+    pendingOps.clear();
+    pendingIndex = 0;
+    phase = REBUILD_IDLE;
+}
+
+// deepInsert: the update was an insert past the height bound, which the tree only grows by
+// while a rebuild is in flight; REBUILD_DEPTH_SLACK of them share the rest of the rebuild
+// evenly and the last one finishes it
+void ScapegoatTree::advanceRebuild(bool deepInsert) {
+    int budget = syncRebuildLimit();
+    bool finish = false;
+    if (deepInsert && phase != REBUILD_IDLE) {
+        long long share = (rebuildWorkLeft + deepInsertsLeft - 1) / deepInsertsLeft;
+        budget = static_cast<int>(std::min<long long>(std::max<long long>(budget, share), std::numeric_limits<int>::max()));
+        finish = --deepInsertsLeft == 0;
+    }
+    
+    // a step that finishes a phase moves on to the next one within the same budget
+    int steps = finish ? std::numeric_limits<int>::max() : budget;
+    while (phase != REBUILD_IDLE && steps > 0) {
+        switch (phase) {
+            case REBUILD_IDLE:
+                break;
+            case REBUILD_COLLECT:
+                collectStep(steps);
+                break;
+            case REBUILD_BUILD:
+                buildStep(steps);
+                break;
+            case REBUILD_REPLAY:
+                replayStep(steps);
+                break;
+        }
+    }
+    
+    // free a few nodes of a retired tree
+    for (int i = 0; i < budget && !reclaimStack.empty(); ++i) {
+        SGNode *node = reclaimStack.back();
+        reclaimStack.pop_back();
+        if (node->left) reclaimStack.push_back(node->left);
+        if (node->right) reclaimStack.push_back(node->right);
+        delete node;
+    }
+}
+
+// LAZY DELETE
+bool ScapegoatTree::markDead(int key) {
+    SGNode *node = root;
+    while (node && node->key != key) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        node = (key < node->key) ? node->left : node->right;
+    }
+    if (!node || node->dead) return false;
+    
+    // second pass drops the live count of every node on the path
+    node->dead = true;
+    for (SGNode *current = root; current != node; current = (key < current->key) ? current->left : current->right) {
+        current->live--;
+    }
+    node->live--;
+    size--;
+    deadCount++;
+    return true;
+}
+
+void ScapegoatTree::purgeTombstones() {
+    root = rebuildSubtree(root);
+    maxSize = size;
+    deepestInsert = balancedHeight(size);
+}
+
+// ADAPTIVE ALPHA
+void ScapegoatTree::setAlpha(double a) {
+    alpha = a;
+    
+    // same table as buildDepthThresholds, with alpha known only now
+    ownedDepthThresholds.clear();
+    long double power = 1.0L;
+    while (power <= std::numeric_limits<int>::max()) {
+        int floorPower = static_cast<int>(power);
+        ownedDepthThresholds.push_back((floorPower == power) ? floorPower : floorPower + 1);
+        power = power / alpha;
+    }
+    depthThresholds = ownedDepthThresholds.data();
+    depthThresholdsSize = static_cast<int>(ownedDepthThresholds.size());
+}
+
+void ScapegoatTree::noteReads(long long count) const {
+    if (adaptive) {
+        windowReads += count;
+    }
+}
+
+// once the window since the last decision holds enough operations to judge the mix by, alpha is
+// retuned by the update that finished a rebuild; a window of mostly lookups is judged by the next
+// update whether or not it rebuilt, since such a window may never see a rebuild of its own
+void ScapegoatTree::noteWrite() {
+    if (!adaptive) return;
+    
+    windowWrites++;
+    if (windowReads + windowWrites >= TUNING_WINDOW &&
+        (rebuildFinished || windowReads >= READ_HEAVY_RATIO * windowWrites)) {
+        tuneAlpha();
+    }
+    rebuildFinished = false;
+}
+
+int ScapegoatTree::balancedHeight(int nodes) {
+    // depth of the deepest node in a perfectly balanced tree of this many nodes
+    int height = 0;
+    for (int n = nodes; n > 1; n >>= 1) {
+        height++;
+    }
+    return height;
+}
+
+double ScapegoatTree::balancedLookupDepth(int nodes) {
+    // nodes a lookup of a random key visits on average in a perfectly balanced tree, every
+    // level full but the last
+    if (nodes <= 0) return 0;
+    double visits = 0;
+    long long level = 1;
+    int depth = 1;
+    for (long long left = nodes; left > 0; left -= level, level <<= 1, depth++) {
+        visits += static_cast<double>(std::min(left, level)) * depth;
+    }
+    return visits / nodes;
+}
+
+void ScapegoatTree::tuneAlpha() {
+    // nodes visited per update, estimated from the insert descents, against nodes relinked by
+    // rebuilds; lookups are left out, a full rebuild serves them better than a tighter alpha
+    double descent = windowInsertDepth > 0 ? static_cast<double>(windowInsertDepth) / windowInserts
+                                           : balancedHeight(size) + 1;
+    double descentWork = descent * windowWrites;
+    double rebuildWork = static_cast<double>(windowNodesRebuilt);
+    double lookupDepth = windowLookups > 0 ? static_cast<double>(windowLookupDepth) / windowLookups : descent;
+    bool readHeavy = windowReads >= READ_HEAVY_RATIO * windowWrites;
+    
+    readsSinceFullRebuild += windowReads;
+    windowReads = 0;
+    windowWrites = 0;
+    windowInserts = 0;
+    windowInsertDepth = 0;
+    windowLookups = 0;
+    windowLookupDepth = 0;
+    windowNodesRebuilt = 0;
+    
+    if (readHeavy) {
+        // too few updates to judge alpha by; instead the whole tree is rebuilt perfectly balanced
+        // once the lookups since the last full rebuild, each visiting more nodes than it would
+        // there, add up to more node visits than the rebuild relinks. alpha is left for the
+        // next write burst, which a tighter one would only make rebuild more
+        double excessDepth = lookupDepth - balancedLookupDepth(size);
+        if (!root || readsSinceFullRebuild * excessDepth < size || (incremental && phase != REBUILD_IDLE)) {
+            return;
+        }
+        if (incremental) {
+            startIncrementalRebuild(NO_LOWER_BOUND, NO_UPPER_BOUND, root->size);
+        } else {
+            root = rebuildSubtree(root);
+            maxSize = size;
+            deepestInsert = balancedHeight(size);
+        }
+        windowNodesRebuilt = 0; // paid for by the lookups, not charged to the next window's updates
+        readsSinceFullRebuild = 0;
+        return;
+    }
+    
+    // rebuilds costing more than half the descents -> loosen one step, rebuilds costing under a
+    // quarter -> tighten, one more step for every further doubling of the imbalance; in between
+    // alpha stays put. a looser bound holds for the current shape, a tighter one the tree may
+    // already be deeper than is enforced by the inserts that reach the deep paths
+    int maxSteps = static_cast<int>(std::lround((ADAPTIVE_ALPHA_MAX - ADAPTIVE_ALPHA_MIN) / ADAPTIVE_ALPHA_STEP));
+    int steps = static_cast<int>(std::lround((alpha - ADAPTIVE_ALPHA_MIN) / ADAPTIVE_ALPHA_STEP));
+    int nextSteps = steps;
+    if (2 * rebuildWork > descentWork) {
+        nextSteps++;
+    }
+    for (double work = 4 * rebuildWork; work < descentWork && nextSteps > 0; work *= 2) {
+        nextSteps--;
+    }
+    nextSteps = std::min(std::max(nextSteps, 0), maxSteps);
+    double next = ADAPTIVE_ALPHA_MIN + nextSteps * ADAPTIVE_ALPHA_STEP;
+    if (nextSteps != steps || std::abs(next - alpha) >= ADAPTIVE_ALPHA_STEP / 2) {
+        setAlpha(next);
+    }
+}
+
 // PUBLIC METHODS
-ScapegoatTree::ScapegoatTree(double a) : root(nullptr), size(0), maxSize(0), alpha(a) {
+ScapegoatTree::ScapegoatTree(double a, bool incremental)
+    : ScapegoatTree(a, incremental, nullptr, 0) {
+    setAlpha(alpha);
+}
+
+ScapegoatTree::ScapegoatTree(double a, bool incremental, const int *thresholds, int thresholdCount)
+    : root(nullptr), size(0), maxSize(0), alpha(a), rebuilds(0), scratchPeak(0), depthThresholds(thresholds),
+      depthThresholdsSize(thresholdCount), incremental(incremental), phase(REBUILD_IDLE),
+      rebuildLow(NO_LOWER_BOUND), rebuildHigh(NO_UPPER_BOUND), collectCursor(NO_LOWER_BOUND),
+      shadowRoot(nullptr), pendingIndex(0), rebuildWorkLeft(0), deepInsertsLeft(0), lazyDelete(false), deadCount(0), adaptive(false), windowReads(0), windowWrites(0),
+      windowNodesRebuilt(0), deepestInsert(0), windowInserts(0), windowInsertDepth(0), windowLookups(0),
+      windowLookupDepth(0), readsSinceFullRebuild(0),
+      rebuildFinished(false) {
     if (alpha <= 0.5 || alpha >= 1.0) {
         alpha = 0.7; // default to 0.7 if given an invalid alpha
     }
 }
 
 ScapegoatTree::~ScapegoatTree() {
-    destroyRecursive(root);
+    releaseNodes();
+}
+
+ScapegoatTree::ScapegoatTree(ScapegoatTree&& other)
+    : ScapegoatTree(other.alpha, other.incremental, other.depthThresholds, other.depthThresholdsSize) {
+    *this = std::move(other);
+}
+
+ScapegoatTree& ScapegoatTree::operator=(ScapegoatTree&& other) {
+    if (this == &other) return *this;
+    releaseNodes();
+    root = std::exchange(other.root, nullptr);
+    size = std::exchange(other.size, 0);
+    maxSize = std::exchange(other.maxSize, 0);
+    alpha = other.alpha;
+    rebuilds = other.rebuilds;
+    scratchPeak = other.scratchPeak;
+    // a static table (StaticScapegoatTree) is shared, a runtime one is copied
+    ownedDepthThresholds = other.ownedDepthThresholds;
+    depthThresholds = ownedDepthThresholds.empty() ? other.depthThresholds : ownedDepthThresholds.data();
+    depthThresholdsSize = other.depthThresholdsSize;
+
+    incremental = other.incremental;
+    phase = std::exchange(other.phase, REBUILD_IDLE);
+    rebuildLow = std::exchange(other.rebuildLow, NO_LOWER_BOUND);
+    rebuildHigh = std::exchange(other.rebuildHigh, NO_UPPER_BOUND);
+    shadowKeys = std::exchange(other.shadowKeys, {});
+    collectCursor = std::exchange(other.collectCursor, NO_LOWER_BOUND);
+    buildStack = std::exchange(other.buildStack, {});
+    for (BuildRange &range : buildStack) {
+        if (range.link == &other.shadowRoot) range.link = &shadowRoot; // the only link outside the nodes
+    }
+    shadowRoot = std::exchange(other.shadowRoot, nullptr);
+    pendingOps = std::exchange(other.pendingOps, {});
+    pendingIndex = std::exchange(other.pendingIndex, 0);
+    reclaimStack = std::exchange(other.reclaimStack, {});
+    rebuildWorkLeft = std::exchange(other.rebuildWorkLeft, 0);
+    deepInsertsLeft = std::exchange(other.deepInsertsLeft, 0);
+
+    lazyDelete = other.lazyDelete;
+    deadCount = std::exchange(other.deadCount, 0);
+
+    adaptive = other.adaptive;
+    windowReads = other.windowReads;
+    windowWrites = other.windowWrites;
+    windowNodesRebuilt = other.windowNodesRebuilt;
+    deepestInsert = std::exchange(other.deepestInsert, 0);
+    windowInserts = other.windowInserts;
+    windowInsertDepth = other.windowInsertDepth;
+    windowLookups = other.windowLookups;
+    windowLookupDepth = other.windowLookupDepth;
+    readsSinceFullRebuild = other.readsSinceFullRebuild;
+    rebuildFinished = false;
+#ifdef HEAPURI_TREE_STATS
+    stats = other.stats;
+#endif
+    return *this;
 }
 
 void ScapegoatTree::insert(int key) {
@@ -254,17 +924,44 @@ void ScapegoatTree::insert(int key) {
     int height = 0;
     SGNode* node = root;
     while (node && node->key != key) {
+        TREE_STATS(stats.comparisons++);
         height++;
         node = (key < node->key) ? node->left : node->right;
     }
+    TREE_STATS(stats.maxDepth = std::max(stats.maxDepth, height + 1));
+    deepestInsert = std::max(deepestInsert, height);
+    if (adaptive) {
+        windowInserts++;
+        windowInsertDepth += height + 1;
+    }
+    
+    if (incremental) {
+        recordUpdate(key, true);
+        // small scapegoats are rebuilt right away, bigger ones are rebuilt in steps; while one
+        // is in flight, too-deep inserts speed it up instead of searching for another
+        bool deep = exceedsDepthBound(height);
+        if (deep && phase == REBUILD_IDLE) {
+            long long low, high;
+            SGNode **scapegoat = findScapegoatLink(root, key, low, high);
+            if (scapegoat && (*scapegoat)->size <= syncRebuildLimit()) {
+                *scapegoat = rebuildSubtree(*scapegoat);
+            } else if (scapegoat) {
+                startIncrementalRebuild(low, high, (*scapegoat)->size);
+            }
+        }
+        advanceRebuild(deep);
+        noteWrite();
+        return;
+    }
     
     // if height exceeds log_alpha(size), find a scapegoat
-    if (height > std::log(size) / std::log(1/alpha)) {
+    if (exceedsDepthBound(height)) {
         SGNode* scapegoat = findScapegoat(root, key);
         if (scapegoat) {
             // replace scapegoat with a rebuilt tree
             if (scapegoat == root) {
                 root = rebuildSubtree(root);
+                deepestInsert = balancedHeight(size);
             } else {
                 // find parent of scapegoat
                 node = root;
@@ -284,30 +981,159 @@ void ScapegoatTree::insert(int key) {
             }
         }
     }
+    noteWrite();
 }
 
 void ScapegoatTree::remove(int key) {
     if (!root) return;
     
+    if (lazyDelete) {
+        // tombstone the key, purge once more than (1 - alpha) of the nodes are dead
+        bool removed = markDead(key);
+        if (incremental) {
+            if (removed) recordUpdate(key, false);
+            if (size < alpha * (size + deadCount)) {
+                startIncrementalRebuild(NO_LOWER_BOUND, NO_UPPER_BOUND, root->size);
+            }
+            advanceRebuild(false);
+        } else if (size < alpha * (size + deadCount)) {
+            purgeTombstones();
+        }
+        noteWrite();
+        return;
+    }
+    
+    // a delete that pushes size below alpha * maxSize rebalances the path it shortened, which
+    // ends at the node physically unlinked (the inorder successor when key has two children)
+    int pathKey = key;
+    if (size - 1 < alpha * maxSize) {
+        SGNode *node = root;
+        while (node && node->key != key) {
+            node = (key < node->key) ? node->left : node->right;
+        }
+        if (node && node->left && node->right) {
+            pathKey = findMin(node->right)->key;
+        }
+    }
+    
     root = deleteRecursive(root, key);
     
-    // check if rebuild is needed after deletion
+    if (incremental) {
+        recordUpdate(key, false);
+        // as for inserts, no scapegoat is searched for while a rebuild is in flight
+        if (size > 0 && size < alpha * maxSize && phase == REBUILD_IDLE) {
+            long long low, high;
+            SGNode **scapegoat = findDeleteScapegoatLink(pathKey, low, high);
+            if (!scapegoat) {
+                maxSize = size;
+            } else if ((*scapegoat)->size <= syncRebuildLimit()) {
+                *scapegoat = rebuildSubtree(*scapegoat);
+                maxSize = size;
+            } else {
+                startIncrementalRebuild(low, high, (*scapegoat)->size);
+                maxSize = size;
+            }
+        }
+        advanceRebuild(false);
+        if (size == 0 && phase == REBUILD_IDLE) {
+            maxSize = 0;
+        }
+        noteWrite();
+        return;
+    }
+    
+    // check if rebuild is needed after deletion, only the highest unbalanced subtree on the
+    // deletion path is rebuilt
     if (size > 0 && maxSize > 0 && size < alpha * maxSize) {
-        if (root) {
-            root = rebuildSubtree(root);
-            maxSize = size;
+        long long low, high;
+        SGNode **scapegoat = findDeleteScapegoatLink(pathKey, low, high);
+        if (scapegoat) {
+            if (*scapegoat == root) {
+                deepestInsert = balancedHeight(size);
+            }
+            *scapegoat = rebuildSubtree(*scapegoat);
         }
+        maxSize = size;
     }
     
     // handle the special case where tree becomes empty
     if (size == 0) {
         maxSize = 0;
         root = nullptr;
+        deepestInsert = 0;
     }
+    noteWrite();
 }
 
 bool ScapegoatTree::search(int key) const {
-    return searchRecursive(root, key) != nullptr;
+    noteReads(1);
+    if (!adaptive || windowReads % LOOKUP_SAMPLE != 0) return searchRecursive(root, key) != nullptr;
+    
+    // a sampled lookup counts the nodes it visits, the cost a full rebuild would cut
+    SGNode *node = root;
+    long long visited = 0;
+    while (node && node->key != key) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        visited++;
+        node = (key < node->key) ? node->left : node->right;
+    }
+    if (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        visited++;
+    }
+    windowLookups++;
+    windowLookupDepth += visited;
+    return node != nullptr && !node->dead;
+}
+
+void ScapegoatTree::searchBatch(const int* keys, size_t count, bool* found) const {
+    noteReads(count);
+    // each slot holds one in-flight lookup, a finished slot is refilled with the next key
+    const size_t width = std::min(SEARCH_BATCH_WIDTH, count);
+    const SGNode* current[SEARCH_BATCH_WIDTH];
+    size_t index[SEARCH_BATCH_WIDTH];
+    size_t next = 0;
+    size_t active = width;
+
+    for (size_t s = 0; s < width; ++s) {
+        index[s] = next++;
+        current[s] = root;
+    }
+
+    while (active > 0) {
+        for (size_t s = 0; s < width; ++s) {
+            if (index[s] == count) continue; // slot drained
+
+            const SGNode* node = current[s];
+            int key = keys[index[s]];
+
+            if (node) {
+                TREE_STATS(stats.nodesVisited++);
+                TREE_STATS(stats.comparisons++);
+            }
+            if (node && node->key != key) {
+                // descend one level and start loading the child while the other slots advance
+                node = key < node->key ? node->left : node->right;
+                if (node) {
+                    __builtin_prefetch(node);
+                }
+                current[s] = node;
+                continue;
+            }
+
+            // lookup finished (hit or fell off the tree)
+            found[index[s]] = node != nullptr && !node->dead;
+            if (next < count) {
+                index[s] = next++;
+                current[s] = root;
+            } else {
+                index[s] = count;
+                active--;
+            }
+        }
+    }
 }
 
 bool ScapegoatTree::isEmpty() const {
@@ -315,7 +1141,9 @@ bool ScapegoatTree::isEmpty() const {
 }
 
 ScapegoatTree ScapegoatTree::join(const ScapegoatTree& other) {
-    ScapegoatTree result(alpha);
+    ScapegoatTree result(alpha, incremental);
+    result.setAdaptiveAlpha(adaptive);
+    result.setLazyDelete(lazyDelete);
     
     // get all nodes from both trees in sorted order
     std::vector<SGNode*> thisNodes;
@@ -323,22 +1151,24 @@ ScapegoatTree ScapegoatTree::join(const ScapegoatTree& other) {
     
     flattenToVector(root, thisNodes);
     flattenToVector(other.root, otherNodes);
+    scratchPeak = std::max(scratchPeak, (thisNodes.capacity() + otherNodes.capacity()) * sizeof(SGNode*));
     
     // insert all keys into the new tree
     // first from this tree
     for (auto node : thisNodes) {
-        result.insert(node->key);
+        if (!node->dead) result.insert(node->key);
     }
     
     // then from the other tree (duplicates will be handled by insert)
     for (auto node : otherNodes) {
-        result.insert(node->key);
+        if (!node->dead) result.insert(node->key);
     }
     
     return result;
 }
 
 int ScapegoatTree::floor(int key) const {
+    noteReads(1);
     SGNode* floorNode = floorRecursive(root, key);
     if (!floorNode) {
         throw std::runtime_error("No floor value exists");
@@ -347,6 +1177,7 @@ int ScapegoatTree::floor(int key) const {
 }
 
 int ScapegoatTree::ceiling(int key) const {
+    noteReads(1);
     SGNode* ceilingNode = ceilingRecursive(root, key);
     if (!ceilingNode) {
         throw std::runtime_error("No ceiling value exists");
@@ -354,12 +1185,135 @@ int ScapegoatTree::ceiling(int key) const {
     return ceilingNode->key;
 }
 
+std::optional<int> ScapegoatTree::tryFloor(int key) const {
+    noteReads(1);
+    SGNode* node = root;
+    SGNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) {
+            if (!node->dead) return node->key;
+            // a dead match, the floor is the largest live key below it
+            if (SGNode* below = findMax(node->left)) return below->key;
+            break;
+        }
+        if (key < node->key) {
+            node = node->left;
+        } else {
+            // node and its left subtree hold floor candidates unless all of them are dead
+            if (!node->dead || liveOf(node->left) > 0) best = node;
+            node = node->right;
+        }
+    }
+    if (best && best->dead) best = findMax(best->left);
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> ScapegoatTree::tryCeiling(int key) const {
+    noteReads(1);
+    SGNode* node = root;
+    SGNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) {
+            if (!node->dead) return node->key;
+            // a dead match, the ceiling is the smallest live key above it
+            if (SGNode* above = findMin(node->right)) return above->key;
+            break;
+        }
+        if (key > node->key) {
+            node = node->right;
+        } else {
+            // node and its right subtree hold ceiling candidates unless all of them are dead
+            if (!node->dead || liveOf(node->right) > 0) best = node;
+            node = node->left;
+        }
+    }
+    if (best && best->dead) best = findMin(best->right);
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> ScapegoatTree::predecessor(int key) const {
+    noteReads(1);
+    SGNode* node = root;
+    SGNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key < key) {
+            if (!node->dead || liveOf(node->left) > 0) best = node;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    if (best && best->dead) best = findMax(best->left);
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> ScapegoatTree::successor(int key) const {
+    noteReads(1);
+    SGNode* node = root;
+    SGNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key > key) {
+            if (!node->dead || liveOf(node->right) > 0) best = node;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+    if (best && best->dead) best = findMin(best->right);
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::vector<std::optional<int>> ScapegoatTree::floorBatch(const std::vector<int>& probes) const {
+    noteReads(probes.size());
+    std::vector<std::optional<int>> result(probes.size());
+    floorBatchRecursive(root, probes, 0, probes.size(), nullptr, result);
+    return result;
+}
+
+std::vector<std::optional<int>> ScapegoatTree::ceilingBatch(const std::vector<int>& probes) const {
+    noteReads(probes.size());
+    std::vector<std::optional<int>> result(probes.size());
+    ceilingBatchRecursive(root, probes, 0, probes.size(), nullptr, result);
+    return result;
+}
+
 std::vector<int> ScapegoatTree::rangeQuery(int x, int y) const {
+    noteReads(1);
     std::vector<int> result;
     rangeQueryRecursive(root, x, y, result);
     return result;
 }
 
+void ScapegoatTree::loadSorted(const std::vector<int>& sortedKeys) {
+    abortIncrementalRebuild();
+    destroyRecursive(root);
+    std::vector<SGNode*> nodes;
+    nodes.reserve(sortedKeys.size());
+    for (int key : sortedKeys) {
+        nodes.push_back(new SGNode(key));
+    }
+    root = rebuildTree(nodes, 0, static_cast<int>(nodes.size()) - 1);
+    scratchPeak = std::max(scratchPeak, nodes.capacity() * sizeof(SGNode*));
+    size = maxSize = static_cast<int>(nodes.size());
+    deadCount = 0;
+    deepestInsert = balancedHeight(size);
+    readsSinceFullRebuild = 0;
+}
+
+void ScapegoatTree::save(const std::string& path) const {
+    std::vector<int> keys;
+    rangeQueryRecursive(root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), keys);
+    TreeSnapshot::write(path, keys);
+}
+
 void ScapegoatTree::printRange(int x, int y) const {
     std::vector<int> rangeValues = rangeQuery(x, y);
     
@@ -376,4 +1330,68 @@ void ScapegoatTree::printRange(int x, int y) const {
         }
     }
     std::cout << std::endl;
-} 
\ No newline at end of file
+} 
+
+long long ScapegoatTree::getRebuildCount() const {
+    return rebuilds;
+}
+
+size_t ScapegoatTree::memoryUsage() const {
+    // the size field counts every node below, tombstones included
+    size_t nodes = root ? root->size : 0;
+    nodes += countNodes(shadowRoot);
+    for (const SGNode *retired : reclaimStack) {
+        nodes += countNodes(retired);
+    }
+    return nodes * sizeof(SGNode) + ownedDepthThresholds.capacity() * sizeof(int) +
+           shadowKeys.capacity() * sizeof(int) + buildStack.capacity() * sizeof(BuildRange) +
+           pendingOps.capacity() * sizeof(std::pair<int, bool>) + reclaimStack.capacity() * sizeof(SGNode*);
+}
+
+size_t ScapegoatTree::peakScratchBytes() const {
+    return scratchPeak;
+}
+
+bool ScapegoatTree::isRebuilding() const {
+    return phase != REBUILD_IDLE;
+}
+
+void ScapegoatTree::setAdaptiveAlpha(bool enabled) {
+    adaptive = enabled;
+    windowReads = 0;
+    windowWrites = 0;
+    windowInserts = 0;
+    windowInsertDepth = 0;
+    windowLookups = 0;
+    windowLookupDepth = 0;
+    windowNodesRebuilt = 0;
+}
+
+void ScapegoatTree::setLazyDelete(bool enabled) {
+    lazyDelete = enabled;
+    if (!enabled && deadCount > 0) {
+        if (incremental) {
+            // the in-flight shadow may still be swapped over tombstones, drop it first
+            abortIncrementalRebuild();
+        }
+        purgeTombstones();
+    }
+}
+
+double ScapegoatTree::getAlpha() const {
+    return alpha;
+}
+
+TreeStats ScapegoatTree::getStats() const {
+#ifdef HEAPURI_TREE_STATS
+    return stats;
+#else
+    return TreeStats();
+#endif
+}
+
+void ScapegoatTree::resetStats() {
+#ifdef HEAPURI_TREE_STATS
+    stats = TreeStats();
+#endif
+}
@@ -0,0 +1,227 @@
+#include "snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'H', 'E', 'A', 'P', 'U', 'R', 'I', '\0'};
+
+// lays sorted[next..] out in Eytzinger order below slot k
+void fillEytzinger(const std::vector<int>& sorted, std::vector<int>& slots, size_t& next, size_t k) {
+    if (k >= slots.size()) return;
+    fillEytzinger(sorted, slots, next, 2 * k);
+    slots[k] = sorted[next++];
+    fillEytzinger(sorted, slots, next, 2 * k + 1);
+}
+
+}
+
+// PRIVATE METHODS
+TreeSnapshot::TreeSnapshot(void* mapping, size_t mappingBytes, const int* keys, size_t count, uint32_t layout)
+    : mapping(mapping), mappingBytes(mappingBytes), keys(keys), count(count), layout(layout) {}
+
+size_t TreeSnapshot::lowerBoundSlot(int key) const {
+    if (layout == SNAPSHOT_SORTED) {
+        size_t slot = std::lower_bound(keys + 1, keys + count + 1, key) - keys;
+        return slot <= count ? slot : 0;
+    }
+    // branch-free descent, the prefetch pulls in the cache line holding the 16
+    // great-grandchildren four levels down while the current level is compared
+    unsigned long long k = 1;
+    while (k <= count) {
+        __builtin_prefetch(keys + 16 * k);
+        k = 2 * k + (keys[k] < key);
+    }
+    // drop the trailing right turns and the last left turn: the node we turned left at
+    return k >> __builtin_ffsll(~k);
+}
+
+size_t TreeSnapshot::floorSlot(int key) const {
+    if (layout == SNAPSHOT_SORTED) {
+        return std::upper_bound(keys + 1, keys + count + 1, key) - keys - 1;
+    }
+    unsigned long long k = 1;
+    while (k <= count) {
+        __builtin_prefetch(keys + 16 * k);
+        k = 2 * k + (keys[k] <= key);
+    }
+    // drop the trailing left turns and the last right turn: the node we turned right at
+    return k >> __builtin_ffsll(k);
+}
+
+size_t TreeSnapshot::nextSlot(size_t slot) const {
+    if (layout == SNAPSHOT_SORTED) {
+        return slot < count ? slot + 1 : 0;
+    }
+    if (2 * slot + 1 <= count) {
+        slot = 2 * slot + 1;
+        while (2 * slot <= count) slot = 2 * slot;
+        return slot;
+    }
+    // climb while we are a right child, then once more to the parent we are left of
+    while (slot & 1) slot >>= 1;
+    return slot >> 1;
+}
+
+uint64_t TreeSnapshot::checksumOf(const int* keys, size_t count, uint64_t hash) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(keys);
+    for (size_t i = 0; i < count * sizeof(int); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+SnapshotHeader TreeSnapshot::makeHeader(uint32_t layout, uint64_t keyCount, uint64_t checksum) {
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.keyBytes = sizeof(int);
+    header.layout = layout;
+    header.keyCount = keyCount;
+    header.checksum = checksum;
+    header.keysOffset = (sizeof(SnapshotHeader) + KEYS_ALIGNMENT - 1) / KEYS_ALIGNMENT * KEYS_ALIGNMENT;
+    return header;
+}
+
+// PUBLIC METHODS
+TreeSnapshot::TreeSnapshot(TreeSnapshot&& other) noexcept
+    : mapping(other.mapping), mappingBytes(other.mappingBytes), keys(other.keys), count(other.count),
+      layout(other.layout) {
+    other.mapping = nullptr;
+    other.mappingBytes = 0;
+    other.keys = nullptr;
+    other.count = 0;
+}
+
+TreeSnapshot& TreeSnapshot::operator=(TreeSnapshot&& other) noexcept {
+    if (this != &other) {
+        if (mapping) munmap(mapping, mappingBytes);
+        mapping = std::exchange(other.mapping, nullptr);
+        mappingBytes = std::exchange(other.mappingBytes, 0);
+        keys = std::exchange(other.keys, nullptr);
+        count = std::exchange(other.count, 0);
+        layout = other.layout;
+    }
+    return *this;
+}
+
+TreeSnapshot::~TreeSnapshot() {
+    if (mapping) munmap(mapping, mappingBytes);
+}
+
+void TreeSnapshot::write(const std::string& path, const std::vector<int>& sortedKeys) {
+    std::vector<int> slots(sortedKeys.size() + 1, 0);
+    size_t next = 0;
+    fillEytzinger(sortedKeys, slots, next, 1);
+
+    SnapshotHeader header = makeHeader(SNAPSHOT_EYTZINGER, sortedKeys.size(), checksumOf(slots.data() + 1, sortedKeys.size()));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot create snapshot file " + path);
+    }
+    const char padding[KEYS_ALIGNMENT] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(padding, header.keysOffset - sizeof(header));
+    out.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(int));
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Cannot write snapshot file " + path);
+    }
+}
+
+TreeSnapshot TreeSnapshot::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open snapshot file " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Truncated snapshot file " + path);
+    }
+    size_t bytes = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map snapshot file " + path);
+    }
+
+    const SnapshotHeader* header = static_cast<const SnapshotHeader*>(mapping);
+    const char* error = nullptr;
+    if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        error = "Not a snapshot file ";
+    } else if (header->version != SNAPSHOT_VERSION || header->keyBytes != sizeof(int) ||
+               (header->layout != SNAPSHOT_EYTZINGER && header->layout != SNAPSHOT_SORTED)) {
+        error = "Unsupported snapshot version in ";
+    } else if (header->keysOffset % KEYS_ALIGNMENT != 0 || header->keysOffset > bytes ||
+               header->keyCount >= (bytes - header->keysOffset) / sizeof(int)) { // keys[0] is unused, keyCount + 1 could wrap
+        error = "Truncated snapshot file ";
+    }
+    if (error) {
+        munmap(mapping, bytes);
+        throw std::runtime_error(error + path);
+    }
+
+    const int* keys = reinterpret_cast<const int*>(static_cast<const char*>(mapping) + header->keysOffset);
+    return TreeSnapshot(mapping, bytes, keys, header->keyCount, header->layout);
+}
+
+bool TreeSnapshot::verifyChecksum() const {
+    const SnapshotHeader* header = static_cast<const SnapshotHeader*>(mapping);
+    return header && checksumOf(keys + 1, count) == header->checksum;
+}
+
+size_t TreeSnapshot::size() const {
+    return count;
+}
+
+bool TreeSnapshot::isEmpty() const {
+    return count == 0;
+}
+
+bool TreeSnapshot::search(int key) const {
+    size_t slot = lowerBoundSlot(key);
+    return slot != 0 && keys[slot] == key;
+}
+
+int TreeSnapshot::floor(int key) const {
+    size_t slot = floorSlot(key);
+    if (slot == 0) {
+        throw std::runtime_error("No floor value exists");
+    }
+    return keys[slot];
+}
+
+int TreeSnapshot::ceiling(int key) const {
+    size_t slot = lowerBoundSlot(key);
+    if (slot == 0) {
+        throw std::runtime_error("No ceiling value exists");
+    }
+    return keys[slot];
+}
+
+std::optional<int> TreeSnapshot::tryFloor(int key) const {
+    size_t slot = floorSlot(key);
+    return slot ? std::optional<int>(keys[slot]) : std::nullopt;
+}
+
+std::optional<int> TreeSnapshot::tryCeiling(int key) const {
+    size_t slot = lowerBoundSlot(key);
+    return slot ? std::optional<int>(keys[slot]) : std::nullopt;
+}
+
+std::vector<int> TreeSnapshot::rangeQuery(int x, int y) const {
+    std::vector<int> result;
+    for (size_t slot = lowerBoundSlot(x); slot != 0 && keys[slot] <= y; slot = nextSlot(slot)) {
+        result.push_back(keys[slot]);
+    }
+    return result;
+}
@@ -0,0 +1,322 @@
+#include "splay.h"
+#include "snapshot.h"
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+// PRIVATE
+
+// walks down towards key, splitting the path into a left tree of the keys below it and a right
+// tree of the keys above it, then reassembles them under the last node reached. two steps in
+// the same direction rotate first (zig-zig), which is what halves the depth of the whole path
+SplayNode* SplayTree::splay(SplayNode *node, int key) const {
+    if (!node) return nullptr;
+
+    // header.right collects the left tree, header.left the right tree
+    SplayNode header(0);
+    SplayNode *leftMax = &header;
+    SplayNode *rightMin = &header;
+
+    while (true) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (key < node->key) {
+            if (!node->left) break;
+            if (key < node->left->key) {
+                TREE_STATS(stats.rotationsLL++);
+                SplayNode *child = node->left;
+                node->left = child->right;
+                child->right = node;
+                node = child;
+                if (!node->left) break;
+            }
+            rightMin->left = node;
+            rightMin = node;
+            node = node->left;
+        } else if (key > node->key) {
+            if (!node->right) break;
+            if (key > node->right->key) {
+                TREE_STATS(stats.rotationsRR++);
+                SplayNode *child = node->right;
+                node->right = child->left;
+                child->left = node;
+                node = child;
+                if (!node->right) break;
+            }
+            leftMax->right = node;
+            leftMax = node;
+            node = node->right;
+        } else {
+            break;
+        }
+    }
+
+    leftMax->right = node->left;
+    rightMin->left = node->right;
+    node->left = header.right;
+    node->right = header.left;
+    return node;
+}
+
+// rotates every left child away before deleting, so a path of n nodes needs no stack
+void SplayTree::destroyTree(SplayNode *node) {
+    while (node) {
+        if (node->left) {
+            SplayNode *child = node->left;
+            node->left = child->right;
+            child->right = node;
+            node = child;
+        } else {
+            SplayNode *next = node->right;
+            delete node;
+            node = next;
+        }
+    }
+}
+
+// in-order walk with an explicit stack, the tree may be far deeper than the call stack allows
+void SplayTree::rangeQueryIterative(const SplayNode* node, int x, int y, std::vector<int>& result) const {
+    std::vector<const SplayNode*> path;
+    while (node || !path.empty()) {
+        if (node) {
+            TREE_STATS(stats.nodesVisited++);
+            if (node->key < x) {
+                node = node->right; // node and its left subtree are below the range
+            } else {
+                path.push_back(node);
+                node = node->key == x ? nullptr : node->left;
+            }
+            continue;
+        }
+        node = path.back();
+        path.pop_back();
+        if (node->key > y) break; // every key still to come is larger
+        result.push_back(node->key);
+        node = node->right;
+    }
+}
+
+SplayNode* SplayTree::buildBalancedTree(const std::vector<int>& keys, int start, int end) {
+    if (start > end) return nullptr;
+
+    int mid = (start + end) / 2;
+    SplayNode* node = new SplayNode(keys[mid]);
+    node->left = buildBalancedTree(keys, start, mid - 1);
+    node->right = buildBalancedTree(keys, mid + 1, end);
+    return node;
+}
+
+// PUBLIC
+SplayTree::SplayTree() : root(nullptr), count(0), scratchPeak(0) {}
+
+SplayTree::~SplayTree() {
+    destroyTree(root);
+}
+
+SplayTree::SplayTree(SplayTree&& other) noexcept
+    : root(std::exchange(other.root, nullptr)), count(std::exchange(other.count, 0)), scratchPeak(other.scratchPeak) {
+#ifdef HEAPURI_TREE_STATS
+    stats = other.stats;
+#endif
+}
+
+SplayTree& SplayTree::operator=(SplayTree&& other) noexcept {
+    if (this != &other) {
+        destroyTree(root);
+        root = std::exchange(other.root, nullptr);
+        count = std::exchange(other.count, 0);
+        scratchPeak = other.scratchPeak;
+#ifdef HEAPURI_TREE_STATS
+        stats = other.stats;
+#endif
+    }
+    return *this;
+}
+
+void SplayTree::insert(int key) {
+    if (!root) {
+        root = new SplayNode(key);
+        count++;
+        return;
+    }
+
+    // after the splay the root is key's neighbour, the new node takes its place on top
+    root = splay(root, key);
+    if (root->key == key) return; // duplicate keys are not allowed
+
+    SplayNode *node = new SplayNode(key);
+    if (key < root->key) {
+        node->left = root->left;
+        node->right = root;
+        root->left = nullptr;
+    } else {
+        node->right = root->right;
+        node->left = root;
+        root->right = nullptr;
+    }
+    root = node;
+    count++;
+}
+
+void SplayTree::remove(int key) {
+    if (!root) return;
+
+    root = splay(root, key);
+    if (root->key != key) return; // key not found
+
+    SplayNode *left = root->left;
+    SplayNode *right = root->right;
+    delete root;
+    count--;
+
+    // splaying the left subtree for key brings its maximum up, which has no right child
+    if (!left) {
+        root = right;
+    } else {
+        root = splay(left, key);
+        root->right = right;
+    }
+}
+
+bool SplayTree::search(int key) const {
+    root = splay(root, key);
+    return root && root->key == key;
+}
+
+bool SplayTree::isEmpty() const {
+    return root == nullptr;
+}
+
+SplayTree SplayTree::join(const SplayTree& other) {
+    std::vector<int> thisKeys;
+    std::vector<int> otherKeys;
+    rangeQueryIterative(root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), thisKeys);
+    other.rangeQueryIterative(other.root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), otherKeys);
+
+    // merge the sorted key lists, a key in both trees is kept once
+    std::vector<int> mergedKeys;
+    mergedKeys.reserve(thisKeys.size() + otherKeys.size());
+    std::set_union(thisKeys.begin(), thisKeys.end(), otherKeys.begin(), otherKeys.end(), std::back_inserter(mergedKeys));
+    scratchPeak = std::max(scratchPeak, (thisKeys.capacity() + otherKeys.capacity() + mergedKeys.capacity()) * sizeof(int));
+
+    SplayTree result;
+    result.root = result.buildBalancedTree(mergedKeys, 0, static_cast<int>(mergedKeys.size()) - 1);
+    result.count = mergedKeys.size();
+    return result;
+}
+
+int SplayTree::floor(int key) const {
+    std::optional<int> result = tryFloor(key);
+    if (!result) {
+        throw std::runtime_error("No floor value exists");
+    }
+    return *result;
+}
+
+int SplayTree::ceiling(int key) const {
+    std::optional<int> result = tryCeiling(key);
+    if (!result) {
+        throw std::runtime_error("No ceiling value exists");
+    }
+    return *result;
+}
+
+// after splaying for key the root is key itself or one of its two neighbours; when it is the
+// wrong one, the answer is the extreme key of the root's subtree on the other side, which a
+// splay of that subtree for the same key brings up
+std::optional<int> SplayTree::tryFloor(int key) const {
+    if (!root) return std::nullopt;
+    root = splay(root, key);
+    if (root->key <= key) return root->key;
+    if (!root->left) return std::nullopt;
+    root->left = splay(root->left, key);
+    return root->left->key;
+}
+
+std::optional<int> SplayTree::tryCeiling(int key) const {
+    if (!root) return std::nullopt;
+    root = splay(root, key);
+    if (root->key >= key) return root->key;
+    if (!root->right) return std::nullopt;
+    root->right = splay(root->right, key);
+    return root->right->key;
+}
+
+std::optional<int> SplayTree::predecessor(int key) const {
+    if (!root) return std::nullopt;
+    root = splay(root, key);
+    if (root->key < key) return root->key;
+    if (!root->left) return std::nullopt;
+    root->left = splay(root->left, key);
+    return root->left->key;
+}
+
+std::optional<int> SplayTree::successor(int key) const {
+    if (!root) return std::nullopt;
+    root = splay(root, key);
+    if (root->key > key) return root->key;
+    if (!root->right) return std::nullopt;
+    root->right = splay(root->right, key);
+    return root->right->key;
+}
+
+std::vector<int> SplayTree::rangeQuery(int x, int y) const {
+    std::vector<int> result;
+    // the splay pays for the walk down to x, the range then starts at or next to the root
+    root = splay(root, x);
+    rangeQueryIterative(root, x, y, result);
+    return result;
+}
+
+void SplayTree::loadSorted(const std::vector<int>& sortedKeys) {
+    destroyTree(root);
+    root = buildBalancedTree(sortedKeys, 0, static_cast<int>(sortedKeys.size()) - 1);
+    count = sortedKeys.size();
+}
+
+void SplayTree::save(const std::string& path) const {
+    std::vector<int> keys;
+    rangeQueryIterative(root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), keys);
+    TreeSnapshot::write(path, keys);
+}
+
+void SplayTree::printRange(int x, int y) const {
+    std::vector<int> rangeValues = rangeQuery(x, y);
+
+    if (rangeValues.empty()) {
+        std::cout << "No values in range [" << x << ", " << y << "]" << std::endl;
+        return;
+    }
+
+    std::cout << "Values in range [" << x << ", " << y << "]: ";
+    for (size_t i = 0; i < rangeValues.size(); ++i) {
+        std::cout << rangeValues[i];
+        if (i < rangeValues.size() - 1) {
+            std::cout << ", ";
+        }
+    }
+    std::cout << std::endl;
+}
+
+size_t SplayTree::memoryUsage() const {
+    return count * sizeof(SplayNode);
+}
+
+size_t SplayTree::peakScratchBytes() const {
+    return scratchPeak;
+}
+
+TreeStats SplayTree::getStats() const {
+#ifdef HEAPURI_TREE_STATS
+    return stats;
+#else
+    return TreeStats();
+#endif
+}
+
+void SplayTree::resetStats() {
+#ifdef HEAPURI_TREE_STATS
+    stats = TreeStats();
+#endif
+}
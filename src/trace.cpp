@@ -0,0 +1,101 @@
+#include "trace.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char TRACE_MAGIC[8] = {'H', 'P', 'T', 'R', 'A', 'C', 'E', '\0'};
+
+}
+
+// PRIVATE METHODS
+OperationTrace::OperationTrace(void* mapping, size_t mappingBytes, const TraceRecord* records, size_t count)
+    : mapping(mapping), mappingBytes(mappingBytes), records(records), count(count) {}
+
+// PUBLIC METHODS
+OperationTrace::OperationTrace(OperationTrace&& other) noexcept
+    : mapping(std::exchange(other.mapping, nullptr)), mappingBytes(std::exchange(other.mappingBytes, 0)),
+      records(std::exchange(other.records, nullptr)), count(std::exchange(other.count, 0)) {}
+
+OperationTrace& OperationTrace::operator=(OperationTrace&& other) noexcept {
+    if (this != &other) {
+        if (mapping) munmap(mapping, mappingBytes);
+        mapping = std::exchange(other.mapping, nullptr);
+        mappingBytes = std::exchange(other.mappingBytes, 0);
+        records = std::exchange(other.records, nullptr);
+        count = std::exchange(other.count, 0);
+    }
+    return *this;
+}
+
+OperationTrace::~OperationTrace() {
+    if (mapping) munmap(mapping, mappingBytes);
+}
+
+void OperationTrace::write(const std::string& path, const std::vector<TraceRecord>& records) {
+    TraceHeader header = {};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.recordBytes = sizeof(TraceRecord);
+    header.recordCount = records.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot create trace file " + path);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(TraceRecord));
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Cannot write trace file " + path);
+    }
+}
+
+OperationTrace OperationTrace::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open trace file " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TraceHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Truncated trace file " + path);
+    }
+    size_t bytes = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map trace file " + path);
+    }
+    // replays walk the records front to back
+    madvise(mapping, bytes, MADV_SEQUENTIAL);
+
+    const TraceHeader* header = static_cast<const TraceHeader*>(mapping);
+    const char* error = nullptr;
+    if (std::memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0) {
+        error = "Not a trace file ";
+    } else if (header->version != TRACE_VERSION || header->recordBytes != sizeof(TraceRecord)) {
+        error = "Unsupported trace version in ";
+    } else if ((bytes - sizeof(TraceHeader)) / sizeof(TraceRecord) < header->recordCount) {
+        error = "Truncated trace file ";
+    }
+
+    const TraceRecord* records = reinterpret_cast<const TraceRecord*>(static_cast<const char*>(mapping) + sizeof(TraceHeader));
+    // replayTrace trusts the op codes, a record it would not recognise fails here
+    for (uint64_t i = 0; !error && i < header->recordCount; ++i) {
+        if (records[i].op > TRACE_RANGE) {
+            error = "Unknown operation in trace file ";
+        }
+    }
+    if (error) {
+        munmap(mapping, bytes);
+        throw std::runtime_error(error + path);
+    }
+    return OperationTrace(mapping, bytes, records, header->recordCount);
+}
@@ -0,0 +1,534 @@
+#include "treap.h"
+#include "snapshot.h"
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+uint64_t splitMix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+}
+
+// PRIVATE
+uint32_t TreapTree::nextPriority() {
+    // xorshift64*, the high half of the product is the best mixed
+    priorityState ^= priorityState >> 12;
+    priorityState ^= priorityState << 25;
+    priorityState ^= priorityState >> 27;
+    return static_cast<uint32_t>((priorityState * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+// seed for a treap created from this one, so that split and join results do not repeat its stream
+uint64_t TreapTree::forkSeed() {
+    uint64_t high = nextPriority();
+    return (high << 32) | nextPriority();
+}
+
+TreapNode* TreapTree::rotateRight(TreapNode *node) {
+    TreapNode *child = node->left;
+    node->left = child->right;
+    child->right = node;
+    return child;
+}
+
+TreapNode* TreapTree::rotateLeft(TreapNode *node) {
+    TreapNode *child = node->right;
+    node->right = child->left;
+    child->left = node;
+    return child;
+}
+
+TreapNode* TreapTree::insertRecursive(TreapNode *node, int key, int depth) {
+    if (!node) {
+        TREE_STATS(stats.maxDepth = std::max(stats.maxDepth, depth));
+        return new TreapNode(key, nextPriority());
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    // the new node goes in as a leaf and rises while its priority beats its parent's
+    if (key < node->key) {
+        node->left = insertRecursive(node->left, key, depth + 1);
+        if (node->left->priority > node->priority) {
+            TREE_STATS(stats.rotationsLL++);
+            return rotateRight(node);
+        }
+    } else if (key > node->key) {
+        node->right = insertRecursive(node->right, key, depth + 1);
+        if (node->right->priority > node->priority) {
+            TREE_STATS(stats.rotationsRR++);
+            return rotateLeft(node);
+        }
+    }
+    // duplicate keys are not allowed
+    return node;
+}
+
+TreapNode* TreapTree::deleteRecursive(TreapNode *node, int key) {
+    if (!node) {
+        return nullptr; // key not found
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    if (key < node->key) {
+        node->left = deleteRecursive(node->left, key);
+        return node;
+    }
+    if (key > node->key) {
+        node->right = deleteRecursive(node->right, key);
+        return node;
+    }
+
+    // every key on the left is smaller than every key on the right, so the two subtrees merge
+    TreapNode *merged = mergeRecursive(node->left, node->right);
+    delete node;
+    return merged;
+}
+
+// less gets the keys below key, greaterEqual the rest; only the nodes on the search path for key
+// are relinked
+void TreapTree::splitRecursive(TreapNode *node, int key, TreapNode *&less, TreapNode *&greaterEqual) {
+    if (!node) {
+        less = greaterEqual = nullptr;
+        return;
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    if (node->key < key) {
+        splitRecursive(node->right, key, node->right, greaterEqual);
+        less = node;
+    } else {
+        splitRecursive(node->left, key, less, node->left);
+        greaterEqual = node;
+    }
+}
+
+// every key in less must be smaller than every key in greater; walks down the right spine of
+// less and the left spine of greater, the higher priority goes on top
+TreapNode* TreapTree::mergeRecursive(TreapNode *less, TreapNode *greater) {
+    if (!less) return greater;
+    if (!greater) return less;
+
+    TREE_STATS(stats.nodesVisited++);
+
+    if (less->priority > greater->priority) {
+        less->right = mergeRecursive(less->right, greater);
+        return less;
+    }
+    greater->left = mergeRecursive(less, greater->left);
+    return greater;
+}
+
+// key ranges may interleave: the root with the higher priority stays on top and the other treap
+// is split around its key, each half is merged into one side
+TreapNode* TreapTree::unionRecursive(TreapNode *a, TreapNode *b) {
+    if (!a) return b;
+    if (!b) return a;
+
+    if (a->priority < b->priority) {
+        std::swap(a, b);
+    }
+    TreapNode *less;
+    TreapNode *greaterEqual;
+    splitRecursive(b, a->key, less, greaterEqual);
+    // a copy of a's key can only be the smallest key of greaterEqual
+    greaterEqual = deleteRecursive(greaterEqual, a->key);
+
+    a->left = unionRecursive(a->left, less);
+    a->right = unionRecursive(a->right, greaterEqual);
+    return a;
+}
+
+void TreapTree::destroyRecursive(TreapNode *node) {
+    if (node) {
+        destroyRecursive(node->left);
+        destroyRecursive(node->right);
+        delete node;
+    }
+}
+
+void TreapTree::rangeQueryRecursive(const TreapNode* node, int x, int y, std::vector<int>& result) const {
+    if (!node) return;
+    TREE_STATS(stats.nodesVisited++);
+
+    if (x < node->key) {
+        rangeQueryRecursive(node->left, x, y, result);
+    }
+    if (x <= node->key && node->key <= y) {
+        result.push_back(node->key);
+    }
+    if (node->key < y) {
+        rangeQueryRecursive(node->right, x, y, result);
+    }
+}
+
+void TreapTree::floorBatchRecursive(const TreapNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                                   const TreapNode* best, std::vector<std::optional<int>>& result) const {
+    if (lo >= hi) return;
+
+    // fell off the tree, every probe still in [lo, hi) shares the same floor
+    if (!node) {
+        for (size_t i = lo; i < hi; ++i) {
+            result[i] = best ? std::optional<int>(best->key) : std::nullopt;
+        }
+        return;
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    // probes smaller than node's key continue left, the rest have node as floor candidate
+    size_t split = std::lower_bound(probes.begin() + lo, probes.begin() + hi, node->key) - probes.begin();
+    floorBatchRecursive(node->left, probes, lo, split, best, result);
+    floorBatchRecursive(node->right, probes, split, hi, node, result);
+}
+
+void TreapTree::ceilingBatchRecursive(const TreapNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                                     const TreapNode* best, std::vector<std::optional<int>>& result) const {
+    if (lo >= hi) return;
+
+    // fell off the tree, every probe still in [lo, hi) shares the same ceiling
+    if (!node) {
+        for (size_t i = lo; i < hi; ++i) {
+            result[i] = best ? std::optional<int>(best->key) : std::nullopt;
+        }
+        return;
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    // probes up to node's key have node as ceiling candidate and continue left, the rest go right
+    size_t split = std::upper_bound(probes.begin() + lo, probes.begin() + hi, node->key) - probes.begin();
+    ceilingBatchRecursive(node->left, probes, lo, split, node, result);
+    ceilingBatchRecursive(node->right, probes, split, hi, best, result);
+}
+
+// bottom-up Cartesian tree over the sorted keys: each new key becomes the right child of the
+// last node on the right spine whose priority beats its own, the nodes it passes become its left
+TreapNode* TreapTree::buildFromSorted(const std::vector<int>& keys) {
+    std::vector<TreapNode*> spine;
+    for (int key : keys) {
+        TreapNode *node = new TreapNode(key, nextPriority());
+        TreapNode *last = nullptr;
+        while (!spine.empty() && spine.back()->priority < node->priority) {
+            last = spine.back();
+            spine.pop_back();
+        }
+        node->left = last;
+        if (!spine.empty()) {
+            spine.back()->right = node;
+        }
+        spine.push_back(node);
+    }
+    scratchPeak = std::max(scratchPeak, spine.capacity() * sizeof(TreapNode*));
+    return spine.empty() ? nullptr : spine.front();
+}
+
+size_t TreapTree::countNodes(const TreapNode* node) const {
+    return node ? 1 + countNodes(node->left) + countNodes(node->right) : 0;
+}
+
+// PUBLIC
+TreapTree::TreapTree(uint64_t seed) : root(nullptr), priorityState(splitMix64(seed)), scratchPeak(0) {
+    if (priorityState == 0) {
+        priorityState = 1; // xorshift never leaves zero
+    }
+}
+
+TreapTree::~TreapTree() {
+    destroyRecursive(root);
+}
+
+TreapTree::TreapTree(TreapTree&& other) noexcept
+    : root(std::exchange(other.root, nullptr)), priorityState(other.priorityState), scratchPeak(other.scratchPeak) {
+#ifdef HEAPURI_TREE_STATS
+    stats = other.stats;
+#endif
+}
+
+TreapTree& TreapTree::operator=(TreapTree&& other) noexcept {
+    if (this != &other) {
+        destroyRecursive(root);
+        root = std::exchange(other.root, nullptr);
+        priorityState = other.priorityState;
+        scratchPeak = other.scratchPeak;
+#ifdef HEAPURI_TREE_STATS
+        stats = other.stats;
+#endif
+    }
+    return *this;
+}
+
+void TreapTree::insert(int key) {
+    root = insertRecursive(root, key, 1);
+}
+
+void TreapTree::remove(int key) {
+    root = deleteRecursive(root, key);
+}
+
+bool TreapTree::search(int key) const {
+    const TreapNode* node = root;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) return true;
+        node = key < node->key ? node->left : node->right;
+    }
+    return false;
+}
+
+void TreapTree::searchBatch(const int* keys, size_t count, bool* found) const {
+    // each slot holds one in-flight lookup, a finished slot is refilled with the next key
+    const size_t width = std::min(SEARCH_BATCH_WIDTH, count);
+    const TreapNode* current[SEARCH_BATCH_WIDTH];
+    size_t index[SEARCH_BATCH_WIDTH];
+    size_t next = 0;
+    size_t active = width;
+
+    for (size_t s = 0; s < width; ++s) {
+        index[s] = next++;
+        current[s] = root;
+    }
+
+    while (active > 0) {
+        for (size_t s = 0; s < width; ++s) {
+            if (index[s] == count) continue; // slot drained
+
+            const TreapNode* node = current[s];
+            int key = keys[index[s]];
+
+            if (node) {
+                TREE_STATS(stats.nodesVisited++);
+                TREE_STATS(stats.comparisons++);
+            }
+            if (node && node->key != key) {
+                // descend one level and start loading the child while the other slots advance
+                node = key < node->key ? node->left : node->right;
+                if (node) {
+                    __builtin_prefetch(node);
+                }
+                current[s] = node;
+                continue;
+            }
+
+            // lookup finished (hit or fell off the tree)
+            found[index[s]] = node != nullptr;
+            if (next < count) {
+                index[s] = next++;
+                current[s] = root;
+            } else {
+                index[s] = count;
+                active--;
+            }
+        }
+    }
+}
+
+bool TreapTree::isEmpty() const {
+    return root == nullptr;
+}
+
+TreapTree TreapTree::join(const TreapTree& other) {
+    std::vector<int> thisKeys;
+    std::vector<int> otherKeys;
+    rangeQueryRecursive(root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), thisKeys);
+    other.rangeQueryRecursive(other.root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), otherKeys);
+
+    // merge the sorted key lists, a key in both trees is kept once
+    std::vector<int> mergedKeys;
+    mergedKeys.reserve(thisKeys.size() + otherKeys.size());
+    std::set_union(thisKeys.begin(), thisKeys.end(), otherKeys.begin(), otherKeys.end(), std::back_inserter(mergedKeys));
+    scratchPeak = std::max(scratchPeak, (thisKeys.capacity() + otherKeys.capacity() + mergedKeys.capacity()) * sizeof(int));
+
+    TreapTree result(forkSeed());
+    result.root = result.buildFromSorted(mergedKeys);
+    return result;
+}
+
+TreapTree TreapTree::split(int key) {
+    TreapTree result(forkSeed());
+    splitRecursive(root, key, root, result.root);
+    return result;
+}
+
+void TreapTree::merge(TreapTree& other) {
+    if (this == &other || !other.root) return;
+
+    // disjoint key ranges only need the spines relinked, interleaved ones take a union
+    std::optional<int> thisMax = tryFloor(std::numeric_limits<int>::max());
+    std::optional<int> otherMin = other.tryCeiling(std::numeric_limits<int>::min());
+    std::optional<int> thisMin = tryCeiling(std::numeric_limits<int>::min());
+    std::optional<int> otherMax = other.tryFloor(std::numeric_limits<int>::max());
+    if (!root || *thisMax < *otherMin) {
+        root = mergeRecursive(root, other.root);
+    } else if (*otherMax < *thisMin) {
+        root = mergeRecursive(other.root, root);
+    } else {
+        root = unionRecursive(root, other.root);
+    }
+    other.root = nullptr;
+}
+
+int TreapTree::floor(int key) const {
+    std::optional<int> result = tryFloor(key);
+    if (!result) {
+        throw std::runtime_error("No floor value exists");
+    }
+    return *result;
+}
+
+int TreapTree::ceiling(int key) const {
+    std::optional<int> result = tryCeiling(key);
+    if (!result) {
+        throw std::runtime_error("No ceiling value exists");
+    }
+    return *result;
+}
+
+std::optional<int> TreapTree::tryFloor(int key) const {
+    const TreapNode* node = root;
+    const TreapNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) return node->key;
+        if (key < node->key) {
+            node = node->left;
+        } else {
+            best = node;
+            node = node->right;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> TreapTree::tryCeiling(int key) const {
+    const TreapNode* node = root;
+    const TreapNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) return node->key;
+        if (key > node->key) {
+            node = node->right;
+        } else {
+            best = node;
+            node = node->left;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> TreapTree::predecessor(int key) const {
+    const TreapNode* node = root;
+    const TreapNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key < key) {
+            best = node;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> TreapTree::successor(int key) const {
+    const TreapNode* node = root;
+    const TreapNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key > key) {
+            best = node;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::vector<std::optional<int>> TreapTree::floorBatch(const std::vector<int>& probes) const {
+    std::vector<std::optional<int>> result(probes.size());
+    floorBatchRecursive(root, probes, 0, probes.size(), nullptr, result);
+    return result;
+}
+
+std::vector<std::optional<int>> TreapTree::ceilingBatch(const std::vector<int>& probes) const {
+    std::vector<std::optional<int>> result(probes.size());
+    ceilingBatchRecursive(root, probes, 0, probes.size(), nullptr, result);
+    return result;
+}
+
+std::vector<int> TreapTree::rangeQuery(int x, int y) const {
+    std::vector<int> result;
+    rangeQueryRecursive(root, x, y, result);
+    return result;
+}
+
+void TreapTree::loadSorted(const std::vector<int>& sortedKeys) {
+    destroyRecursive(root);
+    root = buildFromSorted(sortedKeys);
+}
+
+void TreapTree::save(const std::string& path) const {
+    std::vector<int> keys;
+    rangeQueryRecursive(root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), keys);
+    TreeSnapshot::write(path, keys);
+}
+
+void TreapTree::printRange(int x, int y) const {
+    std::vector<int> rangeValues = rangeQuery(x, y);
+
+    if (rangeValues.empty()) {
+        std::cout << "No values in range [" << x << ", " << y << "]" << std::endl;
+        return;
+    }
+
+    std::cout << "Values in range [" << x << ", " << y << "]: ";
+    for (size_t i = 0; i < rangeValues.size(); ++i) {
+        std::cout << rangeValues[i];
+        if (i < rangeValues.size() - 1) {
+            std::cout << ", ";
+        }
+    }
+    std::cout << std::endl;
+}
+
+size_t TreapTree::memoryUsage() const {
+    return countNodes(root) * sizeof(TreapNode);
+}
+
+size_t TreapTree::peakScratchBytes() const {
+    return scratchPeak;
+}
+
+TreeStats TreapTree::getStats() const {
+#ifdef HEAPURI_TREE_STATS
+    return stats;
+#else
+    return TreeStats();
+#endif
+}
+
+void TreapTree::resetStats() {
+#ifdef HEAPURI_TREE_STATS
+    stats = TreeStats();
+#endif
+}
@@ -0,0 +1,182 @@
+#include "wal.h"
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char WAL_MAGIC[8] = {'H', 'E', 'A', 'P', 'W', 'A', 'L', '\0'};
+
+struct LogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+// precedes every group commit
+struct BatchHeader {
+    uint32_t count;
+    uint32_t checksum; // FNV-1a over the records, seeded with count
+};
+
+// a batch larger than this is taken as a corrupt count rather than read
+constexpr uint32_t MAX_BATCH_RECORDS = 1u << 24;
+
+uint32_t batchChecksum(const LogRecord* records, uint32_t count) {
+    uint32_t hash = 2166136261u ^ count;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(records);
+    for (size_t i = 0; i < count * sizeof(LogRecord); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void writeAll(int fd, const void* data, size_t bytes, const std::string& path) {
+    const char* cursor = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t written = ::write(fd, cursor, bytes);
+        if (written < 0) {
+            throw std::runtime_error("Cannot write log file " + path);
+        }
+        cursor += written;
+        bytes -= written;
+    }
+}
+
+}
+
+// PUBLIC METHODS
+WriteAheadLog::WriteAheadLog(const std::string& path, const WalOptions& options)
+    : path(path), fd(-1), options(options), commits(0) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open log file " + path);
+    }
+    // every failure below closes the file before the exception leaves the constructor
+    try {
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            throw std::runtime_error("Cannot open log file " + path);
+        }
+
+        uint64_t validEnd = 0;
+        if (static_cast<size_t>(info.st_size) >= sizeof(LogHeader)) {
+            validEnd = scan(path, nullptr);
+            if (validEnd == 0) {
+                throw std::runtime_error("Not a log file " + path);
+            }
+        }
+        if (validEnd == 0) {
+            // new file, or one whose header itself was torn
+            LogHeader header = {};
+            std::memcpy(header.magic, WAL_MAGIC, sizeof(header.magic));
+            header.version = WAL_VERSION;
+            if (ftruncate(fd, 0) != 0) {
+                throw std::runtime_error("Cannot truncate log file " + path);
+            }
+            writeAll(fd, &header, sizeof(header), path);
+            validEnd = sizeof(header);
+        } else if (static_cast<uint64_t>(info.st_size) > validEnd && ftruncate(fd, validEnd) != 0) {
+            throw std::runtime_error("Cannot truncate log file " + path);
+        }
+        lseek(fd, validEnd, SEEK_SET);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    if (options.sync) fdatasync(fd);
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    try {
+        commit();
+    } catch (const std::runtime_error&) {
+        // nothing to report to from a destructor, the group is lost as in a crash
+    }
+    ::close(fd);
+}
+
+void WriteAheadLog::append(LogOp op, int key) {
+    auto now = std::chrono::steady_clock::now();
+    if (pending.empty()) oldestPending = now;
+    pending.push_back({key, op});
+    // compared in microseconds so that groupCommitDelay may be microseconds::max()
+    auto waited = std::chrono::duration_cast<std::chrono::microseconds>(now - oldestPending);
+    if (pending.size() >= options.groupCommitOps || waited >= options.groupCommitDelay) {
+        commit();
+    }
+}
+
+void WriteAheadLog::commit() {
+    if (pending.empty()) return;
+    BatchHeader batch = {static_cast<uint32_t>(pending.size()),
+                         batchChecksum(pending.data(), static_cast<uint32_t>(pending.size()))};
+    // one write per group, so a crash tears at most this batch
+    std::vector<char> buffer(sizeof(batch) + pending.size() * sizeof(LogRecord));
+    std::memcpy(buffer.data(), &batch, sizeof(batch));
+    std::memcpy(buffer.data() + sizeof(batch), pending.data(), pending.size() * sizeof(LogRecord));
+    // on failure the group stays pending and the file is cut back to where the batch began,
+    // so the next commit is not appended behind torn bytes that recovery would stop at
+    off_t batchStart = lseek(fd, 0, SEEK_CUR);
+    if (batchStart < 0) {
+        throw std::runtime_error("Cannot seek log file " + path);
+    }
+    try {
+        writeAll(fd, buffer.data(), buffer.size(), path);
+        if (options.sync && fdatasync(fd) != 0) {
+            throw std::runtime_error("Cannot sync log file " + path);
+        }
+    } catch (const std::runtime_error&) {
+        if (ftruncate(fd, batchStart) == 0) lseek(fd, batchStart, SEEK_SET);
+        throw;
+    }
+    pending.clear();
+    commits++;
+}
+
+void WriteAheadLog::truncate() {
+    pending.clear();
+    if (ftruncate(fd, sizeof(LogHeader)) != 0) {
+        throw std::runtime_error("Cannot truncate log file " + path);
+    }
+    lseek(fd, sizeof(LogHeader), SEEK_SET);
+    if (options.sync) fdatasync(fd);
+}
+
+uint64_t WriteAheadLog::scan(const std::string& path, std::vector<LogRecord>* records) {
+    std::ifstream in(path, std::ios::binary);
+    LogHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, WAL_MAGIC, sizeof(header.magic)) != 0 || header.version != WAL_VERSION) {
+        return 0;
+    }
+
+    uint64_t validEnd = sizeof(header);
+    std::vector<LogRecord> batchRecords;
+    BatchHeader batch;
+    while (in.read(reinterpret_cast<char*>(&batch), sizeof(batch))) {
+        if (batch.count == 0 || batch.count > MAX_BATCH_RECORDS) break;
+        batchRecords.resize(batch.count);
+        if (!in.read(reinterpret_cast<char*>(batchRecords.data()), batch.count * sizeof(LogRecord))) break;
+        if (batchChecksum(batchRecords.data(), batch.count) != batch.checksum) break;
+        if (records) records->insert(records->end(), batchRecords.begin(), batchRecords.end());
+        validEnd += sizeof(batch) + batch.count * sizeof(LogRecord);
+    }
+    return validEnd;
+}
+
+void WriteAheadLog::syncPath(const std::string& path, bool directory) {
+    std::string target = path;
+    if (directory) {
+        size_t slash = path.find_last_of('/');
+        target = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    }
+    int fd = ::open(target.c_str(), O_RDONLY);
+    if (fd < 0 || fsync(fd) != 0) {
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("Cannot sync " + target);
+    }
+    ::close(fd);
+}
@@ -0,0 +1,543 @@
+#include "wavl.h"
+#include "snapshot.h"
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+// PRIVATE
+int WAVLTree::rankOf(const WAVLNode *node) {
+    return node ? node->rank : -1;
+}
+
+// rotations only relink, the callers set the ranks
+WAVLNode* WAVLTree::rotateRight(WAVLNode *node) {
+    WAVLNode *child = node->left;
+    node->left = child->right;
+    child->right = node;
+    return child;
+}
+
+WAVLNode* WAVLTree::rotateLeft(WAVLNode *node) {
+    WAVLNode *child = node->right;
+    node->right = child->left;
+    child->left = node;
+    return child;
+}
+
+// after an insert below node->left: the only possible violation is a left 0-child
+WAVLNode* WAVLTree::fixInsertLeft(WAVLNode *node) {
+    if (node->rank != rankOf(node->left)) return node;
+
+    // 0,1 node: promote, the violation may move up to the parent
+    if (node->rank - rankOf(node->right) == 1) {
+        node->rank++;
+        return node;
+    }
+
+    // 0,2 node: one single or double rotation ends the insert
+    WAVLNode *child = node->left;
+    if (child->rank - rankOf(child->left) == 1) {
+        TREE_STATS(stats.rotationsLL++);
+        node->rank--;
+        return rotateRight(node);
+    }
+    TREE_STATS(stats.rotationsLR++);
+    child->right->rank++;
+    child->rank--;
+    node->rank--;
+    node->left = rotateLeft(child);
+    return rotateRight(node);
+}
+
+WAVLNode* WAVLTree::fixInsertRight(WAVLNode *node) {
+    if (node->rank != rankOf(node->right)) return node;
+
+    if (node->rank - rankOf(node->left) == 1) {
+        node->rank++;
+        return node;
+    }
+
+    WAVLNode *child = node->right;
+    if (child->rank - rankOf(child->right) == 1) {
+        TREE_STATS(stats.rotationsRR++);
+        node->rank--;
+        return rotateLeft(node);
+    }
+    TREE_STATS(stats.rotationsRL++);
+    child->left->rank++;
+    child->rank--;
+    node->rank--;
+    node->right = rotateRight(child);
+    return rotateLeft(node);
+}
+
+// after a delete below node->left: node may be a 2,2 leaf or have a left 3-child
+WAVLNode* WAVLTree::fixDeleteLeft(WAVLNode *node) {
+    // a leaf must have rank 0, demoting it may leave a 3-child at the parent
+    if (!node->left && !node->right) {
+        node->rank = 0;
+        return node;
+    }
+    if (node->rank - rankOf(node->left) < 3) return node;
+
+    // the sibling exists, a rank difference of 3 needs node->rank >= 2
+    WAVLNode *sibling = node->right;
+    if (node->rank - sibling->rank == 2) {
+        node->rank--;
+        return node;
+    }
+    if (sibling->rank - rankOf(sibling->left) == 2 && sibling->rank - rankOf(sibling->right) == 2) {
+        node->rank--;
+        sibling->rank--;
+        return node;
+    }
+
+    // sibling has a 1-child: one single or double rotation ends the delete
+    if (sibling->rank - rankOf(sibling->right) == 1) {
+        TREE_STATS(stats.rotationsRR++);
+        WAVLNode *top = rotateLeft(node);
+        top->rank++;
+        node->rank -= (!node->left && !node->right) ? 2 : 1;
+        return top;
+    }
+    TREE_STATS(stats.rotationsRL++);
+    sibling->left->rank += 2;
+    sibling->rank--;
+    node->rank -= 2;
+    node->right = rotateRight(sibling);
+    return rotateLeft(node);
+}
+
+WAVLNode* WAVLTree::fixDeleteRight(WAVLNode *node) {
+    if (!node->left && !node->right) {
+        node->rank = 0;
+        return node;
+    }
+    if (node->rank - rankOf(node->right) < 3) return node;
+
+    WAVLNode *sibling = node->left;
+    if (node->rank - sibling->rank == 2) {
+        node->rank--;
+        return node;
+    }
+    if (sibling->rank - rankOf(sibling->left) == 2 && sibling->rank - rankOf(sibling->right) == 2) {
+        node->rank--;
+        sibling->rank--;
+        return node;
+    }
+
+    if (sibling->rank - rankOf(sibling->left) == 1) {
+        TREE_STATS(stats.rotationsLL++);
+        WAVLNode *top = rotateRight(node);
+        top->rank++;
+        node->rank -= (!node->left && !node->right) ? 2 : 1;
+        return top;
+    }
+    TREE_STATS(stats.rotationsLR++);
+    sibling->right->rank += 2;
+    sibling->rank--;
+    node->rank -= 2;
+    node->left = rotateLeft(sibling);
+    return rotateRight(node);
+}
+
+WAVLNode* WAVLTree::insertRecursive(WAVLNode *node, int key, int depth) {
+    if (!node) {
+        TREE_STATS(stats.maxDepth = std::max(stats.maxDepth, depth));
+        return new WAVLNode(key);
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    if (key < node->key) {
+        node->left = insertRecursive(node->left, key, depth + 1);
+        return fixInsertLeft(node);
+    }
+    if (key > node->key) {
+        node->right = insertRecursive(node->right, key, depth + 1);
+        return fixInsertRight(node);
+    }
+    // duplicate keys are not allowed
+    return node;
+}
+
+WAVLNode* WAVLTree::deleteRecursive(WAVLNode *node, int key) {
+    if (!node) {
+        return nullptr; // key not found
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    if (key < node->key) {
+        node->left = deleteRecursive(node->left, key);
+        return fixDeleteLeft(node);
+    }
+    if (key > node->key) {
+        node->right = deleteRecursive(node->right, key);
+        return fixDeleteRight(node);
+    }
+
+    // leaf or unary node: the child takes its place with its own rank, the parent repairs
+    if (!node->left || !node->right) {
+        WAVLNode *child = node->left ? node->left : node->right;
+        delete node;
+        return child;
+    }
+
+    // two children: take the in-order successor's key and delete the successor instead
+    WAVLNode *successor = node->right;
+    while (successor->left) {
+        successor = successor->left;
+    }
+    node->key = successor->key;
+    node->right = deleteRecursive(node->right, successor->key);
+    return fixDeleteRight(node);
+}
+
+void WAVLTree::destroyRecursive(WAVLNode *node) {
+    if (node) {
+        destroyRecursive(node->left);
+        destroyRecursive(node->right);
+        delete node;
+    }
+}
+
+void WAVLTree::rangeQueryRecursive(const WAVLNode* node, int x, int y, std::vector<int>& result) const {
+    if (!node) return;
+    TREE_STATS(stats.nodesVisited++);
+
+    if (x < node->key) {
+        rangeQueryRecursive(node->left, x, y, result);
+    }
+    if (x <= node->key && node->key <= y) {
+        result.push_back(node->key);
+    }
+    if (node->key < y) {
+        rangeQueryRecursive(node->right, x, y, result);
+    }
+}
+
+void WAVLTree::floorBatchRecursive(const WAVLNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                                   const WAVLNode* best, std::vector<std::optional<int>>& result) const {
+    if (lo >= hi) return;
+
+    // fell off the tree, every probe still in [lo, hi) shares the same floor
+    if (!node) {
+        for (size_t i = lo; i < hi; ++i) {
+            result[i] = best ? std::optional<int>(best->key) : std::nullopt;
+        }
+        return;
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    // probes smaller than node's key continue left, the rest have node as floor candidate
+    size_t split = std::lower_bound(probes.begin() + lo, probes.begin() + hi, node->key) - probes.begin();
+    floorBatchRecursive(node->left, probes, lo, split, best, result);
+    floorBatchRecursive(node->right, probes, split, hi, node, result);
+}
+
+void WAVLTree::ceilingBatchRecursive(const WAVLNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                                     const WAVLNode* best, std::vector<std::optional<int>>& result) const {
+    if (lo >= hi) return;
+
+    // fell off the tree, every probe still in [lo, hi) shares the same ceiling
+    if (!node) {
+        for (size_t i = lo; i < hi; ++i) {
+            result[i] = best ? std::optional<int>(best->key) : std::nullopt;
+        }
+        return;
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    // probes up to node's key have node as ceiling candidate and continue left, the rest go right
+    size_t split = std::upper_bound(probes.begin() + lo, probes.begin() + hi, node->key) - probes.begin();
+    ceilingBatchRecursive(node->left, probes, lo, split, node, result);
+    ceilingBatchRecursive(node->right, probes, split, hi, best, result);
+}
+
+// a midpoint split keeps sibling heights within one, so rank = height - 1 is a valid ranking
+WAVLNode* WAVLTree::buildBalancedTree(const std::vector<int>& keys, int start, int end) {
+    if (start > end) return nullptr;
+
+    int mid = (start + end) / 2;
+    WAVLNode* node = new WAVLNode(keys[mid]);
+    node->left = buildBalancedTree(keys, start, mid - 1);
+    node->right = buildBalancedTree(keys, mid + 1, end);
+    node->rank = 1 + std::max(rankOf(node->left), rankOf(node->right));
+    return node;
+}
+
+size_t WAVLTree::countNodes(const WAVLNode* node) const {
+    return node ? 1 + countNodes(node->left) + countNodes(node->right) : 0;
+}
+
+// PUBLIC
+WAVLTree::WAVLTree() : root(nullptr), scratchPeak(0) {}
+
+WAVLTree::~WAVLTree() {
+    destroyRecursive(root);
+}
+
+WAVLTree::WAVLTree(WAVLTree&& other) noexcept
+    : root(std::exchange(other.root, nullptr)), scratchPeak(other.scratchPeak) {
+#ifdef HEAPURI_TREE_STATS
+    stats = other.stats;
+#endif
+}
+
+WAVLTree& WAVLTree::operator=(WAVLTree&& other) noexcept {
+    if (this != &other) {
+        destroyRecursive(root);
+        root = std::exchange(other.root, nullptr);
+        scratchPeak = other.scratchPeak;
+#ifdef HEAPURI_TREE_STATS
+        stats = other.stats;
+#endif
+    }
+    return *this;
+}
+
+void WAVLTree::insert(int key) {
+    root = insertRecursive(root, key, 1);
+}
+
+void WAVLTree::remove(int key) {
+    root = deleteRecursive(root, key);
+}
+
+bool WAVLTree::search(int key) const {
+    const WAVLNode* node = root;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) return true;
+        node = key < node->key ? node->left : node->right;
+    }
+    return false;
+}
+
+void WAVLTree::searchBatch(const int* keys, size_t count, bool* found) const {
+    // each slot holds one in-flight lookup, a finished slot is refilled with the next key
+    const size_t width = std::min(SEARCH_BATCH_WIDTH, count);
+    const WAVLNode* current[SEARCH_BATCH_WIDTH];
+    size_t index[SEARCH_BATCH_WIDTH];
+    size_t next = 0;
+    size_t active = width;
+
+    for (size_t s = 0; s < width; ++s) {
+        index[s] = next++;
+        current[s] = root;
+    }
+
+    while (active > 0) {
+        for (size_t s = 0; s < width; ++s) {
+            if (index[s] == count) continue; // slot drained
+
+            const WAVLNode* node = current[s];
+            int key = keys[index[s]];
+
+            if (node) {
+                TREE_STATS(stats.nodesVisited++);
+                TREE_STATS(stats.comparisons++);
+            }
+            if (node && node->key != key) {
+                // descend one level and start loading the child while the other slots advance
+                node = key < node->key ? node->left : node->right;
+                if (node) {
+                    __builtin_prefetch(node);
+                }
+                current[s] = node;
+                continue;
+            }
+
+            // lookup finished (hit or fell off the tree)
+            found[index[s]] = node != nullptr;
+            if (next < count) {
+                index[s] = next++;
+                current[s] = root;
+            } else {
+                index[s] = count;
+                active--;
+            }
+        }
+    }
+}
+
+bool WAVLTree::isEmpty() const {
+    return root == nullptr;
+}
+
+WAVLTree WAVLTree::join(const WAVLTree& other) {
+    std::vector<int> thisKeys;
+    std::vector<int> otherKeys;
+    rangeQueryRecursive(root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), thisKeys);
+    other.rangeQueryRecursive(other.root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), otherKeys);
+
+    // merge the sorted key lists, a key in both trees is kept once
+    std::vector<int> mergedKeys;
+    mergedKeys.reserve(thisKeys.size() + otherKeys.size());
+    std::set_union(thisKeys.begin(), thisKeys.end(), otherKeys.begin(), otherKeys.end(), std::back_inserter(mergedKeys));
+    scratchPeak = std::max(scratchPeak, (thisKeys.capacity() + otherKeys.capacity() + mergedKeys.capacity()) * sizeof(int));
+
+    WAVLTree result;
+    result.root = result.buildBalancedTree(mergedKeys, 0, static_cast<int>(mergedKeys.size()) - 1);
+    return result;
+}
+
+int WAVLTree::floor(int key) const {
+    std::optional<int> result = tryFloor(key);
+    if (!result) {
+        throw std::runtime_error("No floor value exists");
+    }
+    return *result;
+}
+
+int WAVLTree::ceiling(int key) const {
+    std::optional<int> result = tryCeiling(key);
+    if (!result) {
+        throw std::runtime_error("No ceiling value exists");
+    }
+    return *result;
+}
+
+std::optional<int> WAVLTree::tryFloor(int key) const {
+    const WAVLNode* node = root;
+    const WAVLNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) return node->key;
+        if (key < node->key) {
+            node = node->left;
+        } else {
+            best = node;
+            node = node->right;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> WAVLTree::tryCeiling(int key) const {
+    const WAVLNode* node = root;
+    const WAVLNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) return node->key;
+        if (key > node->key) {
+            node = node->right;
+        } else {
+            best = node;
+            node = node->left;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> WAVLTree::predecessor(int key) const {
+    const WAVLNode* node = root;
+    const WAVLNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key < key) {
+            best = node;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> WAVLTree::successor(int key) const {
+    const WAVLNode* node = root;
+    const WAVLNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key > key) {
+            best = node;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::vector<std::optional<int>> WAVLTree::floorBatch(const std::vector<int>& probes) const {
+    std::vector<std::optional<int>> result(probes.size());
+    floorBatchRecursive(root, probes, 0, probes.size(), nullptr, result);
+    return result;
+}
+
+std::vector<std::optional<int>> WAVLTree::ceilingBatch(const std::vector<int>& probes) const {
+    std::vector<std::optional<int>> result(probes.size());
+    ceilingBatchRecursive(root, probes, 0, probes.size(), nullptr, result);
+    return result;
+}
+
+std::vector<int> WAVLTree::rangeQuery(int x, int y) const {
+    std::vector<int> result;
+    rangeQueryRecursive(root, x, y, result);
+    return result;
+}
+
+void WAVLTree::loadSorted(const std::vector<int>& sortedKeys) {
+    destroyRecursive(root);
+    root = buildBalancedTree(sortedKeys, 0, static_cast<int>(sortedKeys.size()) - 1);
+}
+
+void WAVLTree::save(const std::string& path) const {
+    std::vector<int> keys;
+    rangeQueryRecursive(root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), keys);
+    TreeSnapshot::write(path, keys);
+}
+
+void WAVLTree::printRange(int x, int y) const {
+    std::vector<int> rangeValues = rangeQuery(x, y);
+
+    if (rangeValues.empty()) {
+        std::cout << "No values in range [" << x << ", " << y << "]" << std::endl;
+        return;
+    }
+
+    std::cout << "Values in range [" << x << ", " << y << "]: ";
+    for (size_t i = 0; i < rangeValues.size(); ++i) {
+        std::cout << rangeValues[i];
+        if (i < rangeValues.size() - 1) {
+            std::cout << ", ";
+        }
+    }
+    std::cout << std::endl;
+}
+
+size_t WAVLTree::memoryUsage() const {
+    return countNodes(root) * sizeof(WAVLNode);
+}
+
+size_t WAVLTree::peakScratchBytes() const {
+    return scratchPeak;
+}
+
+TreeStats WAVLTree::getStats() const {
+#ifdef HEAPURI_TREE_STATS
+    return stats;
+#else
+    return TreeStats();
+#endif
+}
+
+void WAVLTree::resetStats() {
+#ifdef HEAPURI_TREE_STATS
+    stats = TreeStats();
+#endif
+}
@@ -0,0 +1,554 @@
+#include "weight_balanced.h"
+#include "snapshot.h"
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+// PRIVATE
+int WeightBalancedTree::sizeOf(const WBNode *node) {
+    return node ? node->size : 0;
+}
+
+void WeightBalancedTree::updateSize(WBNode *node) {
+    node->size = 1 + sizeOf(node->left) + sizeOf(node->right);
+}
+
+// the scapegoat condition: neither child holds more than alpha of the node's subtree
+bool WeightBalancedTree::isBalanced(const WBNode *node) const {
+    double limit = alpha * node->size;
+    return sizeOf(node->left) <= limit && sizeOf(node->right) <= limit;
+}
+
+WBNode* WeightBalancedTree::rotateRight(WBNode *node) {
+    WBNode *child = node->left;
+    node->left = child->right;
+    child->right = node;
+    child->size = node->size;
+    updateSize(node);
+    return child;
+}
+
+WBNode* WeightBalancedTree::rotateLeft(WBNode *node) {
+    WBNode *child = node->right;
+    node->right = child->left;
+    child->left = node;
+    child->size = node->size;
+    updateSize(node);
+    return child;
+}
+
+// rotates the heavy side up, single or double depending on which grandchild is the larger.
+// a rotation can leave the demoted node or the new root out of balance, so both children and
+// then the node itself are checked again; rotations never change the subtree's size, so the
+// ancestors are not affected. rounds only run out for alpha below about 2/3
+WBNode* WeightBalancedTree::rebalance(WBNode *node, int round) {
+    if (!node || isBalanced(node)) return node;
+    if (round == MAX_REBALANCE_ROUNDS) return rebuildSubtree(node);
+
+    if (sizeOf(node->left) > sizeOf(node->right)) {
+        WBNode *child = node->left;
+        if (sizeOf(child->right) > sizeOf(child->left)) {
+            TREE_STATS(stats.rotationsLR++);
+            node->left = rotateLeft(child);
+        } else {
+            TREE_STATS(stats.rotationsLL++);
+        }
+        node = rotateRight(node);
+    } else {
+        WBNode *child = node->right;
+        if (sizeOf(child->left) > sizeOf(child->right)) {
+            TREE_STATS(stats.rotationsRL++);
+            node->right = rotateRight(child);
+        } else {
+            TREE_STATS(stats.rotationsRR++);
+        }
+        node = rotateLeft(node);
+    }
+
+    node->left = rebalance(node->left, round + 1);
+    node->right = rebalance(node->right, round + 1);
+    return rebalance(node, round + 1);
+}
+
+void WeightBalancedTree::flattenToVector(WBNode *node, std::vector<WBNode*> &nodes) {
+    if (!node) return;
+    TREE_STATS(stats.nodesVisited++);
+
+    flattenToVector(node->left, nodes);
+    nodes.push_back(node);
+    flattenToVector(node->right, nodes);
+}
+
+WBNode* WeightBalancedTree::rebuildTree(const std::vector<WBNode*> &nodes, int start, int end) {
+    if (start > end) return nullptr;
+
+    int mid = (start + end) / 2;
+    WBNode *node = nodes[mid];
+    node->left = rebuildTree(nodes, start, mid - 1);
+    node->right = rebuildTree(nodes, mid + 1, end);
+    updateSize(node);
+    return node;
+}
+
+WBNode* WeightBalancedTree::rebuildSubtree(WBNode *node) {
+    std::vector<WBNode*> nodes;
+    nodes.reserve(node->size);
+    flattenToVector(node, nodes);
+    scratchPeak = std::max(scratchPeak, nodes.capacity() * sizeof(WBNode*));
+
+    rebuilds++;
+    TREE_STATS(stats.rebuilds++);
+    TREE_STATS(stats.nodesRebuilt += nodes.size());
+    return rebuildTree(nodes, 0, static_cast<int>(nodes.size()) - 1);
+}
+
+WBNode* WeightBalancedTree::insertRecursive(WBNode *node, int key, int depth, bool &inserted) {
+    if (!node) {
+        TREE_STATS(stats.maxDepth = std::max(stats.maxDepth, depth));
+        inserted = true;
+        return new WBNode(key);
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    if (key < node->key) {
+        node->left = insertRecursive(node->left, key, depth + 1, inserted);
+    } else if (key > node->key) {
+        node->right = insertRecursive(node->right, key, depth + 1, inserted);
+    }
+    // duplicate keys are not allowed, the sizes on the path only change if a node was added
+    if (!inserted) return node;
+
+    node->size++;
+    return rebalance(node, 0);
+}
+
+WBNode* WeightBalancedTree::deleteRecursive(WBNode *node, int key, bool &removed) {
+    if (!node) {
+        return nullptr; // key not found
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    if (key < node->key) {
+        node->left = deleteRecursive(node->left, key, removed);
+    } else if (key > node->key) {
+        node->right = deleteRecursive(node->right, key, removed);
+    } else if (!node->left || !node->right) {
+        // leaf or unary node: the child takes its place
+        WBNode *child = node->left ? node->left : node->right;
+        delete node;
+        removed = true;
+        return child;
+    } else {
+        // two children: take the in-order successor's key and delete the successor instead
+        WBNode *successor = node->right;
+        while (successor->left) {
+            successor = successor->left;
+        }
+        node->key = successor->key;
+        node->right = deleteRecursive(node->right, successor->key, removed);
+    }
+    if (!removed) return node;
+
+    node->size--;
+    return rebalance(node, 0);
+}
+
+void WeightBalancedTree::destroyRecursive(WBNode *node) {
+    if (node) {
+        destroyRecursive(node->left);
+        destroyRecursive(node->right);
+        delete node;
+    }
+}
+
+void WeightBalancedTree::rangeQueryRecursive(const WBNode* node, int x, int y, std::vector<int>& result) const {
+    if (!node) return;
+    TREE_STATS(stats.nodesVisited++);
+
+    if (x < node->key) {
+        rangeQueryRecursive(node->left, x, y, result);
+    }
+    if (x <= node->key && node->key <= y) {
+        result.push_back(node->key);
+    }
+    if (node->key < y) {
+        rangeQueryRecursive(node->right, x, y, result);
+    }
+}
+
+void WeightBalancedTree::floorBatchRecursive(const WBNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                                   const WBNode* best, std::vector<std::optional<int>>& result) const {
+    if (lo >= hi) return;
+
+    // fell off the tree, every probe still in [lo, hi) shares the same floor
+    if (!node) {
+        for (size_t i = lo; i < hi; ++i) {
+            result[i] = best ? std::optional<int>(best->key) : std::nullopt;
+        }
+        return;
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    // probes smaller than node's key continue left, the rest have node as floor candidate
+    size_t split = std::lower_bound(probes.begin() + lo, probes.begin() + hi, node->key) - probes.begin();
+    floorBatchRecursive(node->left, probes, lo, split, best, result);
+    floorBatchRecursive(node->right, probes, split, hi, node, result);
+}
+
+void WeightBalancedTree::ceilingBatchRecursive(const WBNode* node, const std::vector<int>& probes, size_t lo, size_t hi,
+                                     const WBNode* best, std::vector<std::optional<int>>& result) const {
+    if (lo >= hi) return;
+
+    // fell off the tree, every probe still in [lo, hi) shares the same ceiling
+    if (!node) {
+        for (size_t i = lo; i < hi; ++i) {
+            result[i] = best ? std::optional<int>(best->key) : std::nullopt;
+        }
+        return;
+    }
+
+    TREE_STATS(stats.nodesVisited++);
+    TREE_STATS(stats.comparisons++);
+
+    // probes up to node's key have node as ceiling candidate and continue left, the rest go right
+    size_t split = std::upper_bound(probes.begin() + lo, probes.begin() + hi, node->key) - probes.begin();
+    ceilingBatchRecursive(node->left, probes, lo, split, node, result);
+    ceilingBatchRecursive(node->right, probes, split, hi, best, result);
+}
+
+WBNode* WeightBalancedTree::buildBalancedTree(const std::vector<int>& keys, int start, int end) {
+    if (start > end) return nullptr;
+
+    int mid = (start + end) / 2;
+    WBNode* node = new WBNode(keys[mid]);
+    node->left = buildBalancedTree(keys, start, mid - 1);
+    node->right = buildBalancedTree(keys, mid + 1, end);
+    updateSize(node);
+    return node;
+}
+
+// PUBLIC
+WeightBalancedTree::WeightBalancedTree(double a) : root(nullptr), alpha(a), rebuilds(0), scratchPeak(0) {
+    if (alpha <= 0.5 || alpha >= 1.0) {
+        alpha = 0.7; // default to 0.7 if given an invalid alpha
+    }
+}
+
+WeightBalancedTree::~WeightBalancedTree() {
+    destroyRecursive(root);
+}
+
+WeightBalancedTree::WeightBalancedTree(WeightBalancedTree&& other) noexcept
+    : root(std::exchange(other.root, nullptr)), alpha(other.alpha), rebuilds(other.rebuilds),
+      scratchPeak(other.scratchPeak) {
+#ifdef HEAPURI_TREE_STATS
+    stats = other.stats;
+#endif
+}
+
+WeightBalancedTree& WeightBalancedTree::operator=(WeightBalancedTree&& other) noexcept {
+    if (this != &other) {
+        destroyRecursive(root);
+        root = std::exchange(other.root, nullptr);
+        alpha = other.alpha;
+        rebuilds = other.rebuilds;
+        scratchPeak = other.scratchPeak;
+#ifdef HEAPURI_TREE_STATS
+        stats = other.stats;
+#endif
+    }
+    return *this;
+}
+
+void WeightBalancedTree::insert(int key) {
+    bool inserted = false;
+    root = insertRecursive(root, key, 1, inserted);
+}
+
+void WeightBalancedTree::remove(int key) {
+    bool removed = false;
+    root = deleteRecursive(root, key, removed);
+}
+
+bool WeightBalancedTree::search(int key) const {
+    const WBNode* node = root;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) return true;
+        node = key < node->key ? node->left : node->right;
+    }
+    return false;
+}
+
+void WeightBalancedTree::searchBatch(const int* keys, size_t count, bool* found) const {
+    // each slot holds one in-flight lookup, a finished slot is refilled with the next key
+    const size_t width = std::min(SEARCH_BATCH_WIDTH, count);
+    const WBNode* current[SEARCH_BATCH_WIDTH];
+    size_t index[SEARCH_BATCH_WIDTH];
+    size_t next = 0;
+    size_t active = width;
+
+    for (size_t s = 0; s < width; ++s) {
+        index[s] = next++;
+        current[s] = root;
+    }
+
+    while (active > 0) {
+        for (size_t s = 0; s < width; ++s) {
+            if (index[s] == count) continue; // slot drained
+
+            const WBNode* node = current[s];
+            int key = keys[index[s]];
+
+            if (node) {
+                TREE_STATS(stats.nodesVisited++);
+                TREE_STATS(stats.comparisons++);
+            }
+            if (node && node->key != key) {
+                // descend one level and start loading the child while the other slots advance
+                node = key < node->key ? node->left : node->right;
+                if (node) {
+                    __builtin_prefetch(node);
+                }
+                current[s] = node;
+                continue;
+            }
+
+            // lookup finished (hit or fell off the tree)
+            found[index[s]] = node != nullptr;
+            if (next < count) {
+                index[s] = next++;
+                current[s] = root;
+            } else {
+                index[s] = count;
+                active--;
+            }
+        }
+    }
+}
+
+bool WeightBalancedTree::isEmpty() const {
+    return root == nullptr;
+}
+
+size_t WeightBalancedTree::size() const {
+    return sizeOf(root);
+}
+
+WeightBalancedTree WeightBalancedTree::join(const WeightBalancedTree& other) {
+    std::vector<int> thisKeys;
+    std::vector<int> otherKeys;
+    rangeQueryRecursive(root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), thisKeys);
+    other.rangeQueryRecursive(other.root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), otherKeys);
+
+    // merge the sorted key lists, a key in both trees is kept once
+    std::vector<int> mergedKeys;
+    mergedKeys.reserve(thisKeys.size() + otherKeys.size());
+    std::set_union(thisKeys.begin(), thisKeys.end(), otherKeys.begin(), otherKeys.end(), std::back_inserter(mergedKeys));
+    scratchPeak = std::max(scratchPeak, (thisKeys.capacity() + otherKeys.capacity() + mergedKeys.capacity()) * sizeof(int));
+
+    WeightBalancedTree result(alpha);
+    result.root = result.buildBalancedTree(mergedKeys, 0, static_cast<int>(mergedKeys.size()) - 1);
+    return result;
+}
+
+int WeightBalancedTree::floor(int key) const {
+    std::optional<int> result = tryFloor(key);
+    if (!result) {
+        throw std::runtime_error("No floor value exists");
+    }
+    return *result;
+}
+
+int WeightBalancedTree::ceiling(int key) const {
+    std::optional<int> result = tryCeiling(key);
+    if (!result) {
+        throw std::runtime_error("No ceiling value exists");
+    }
+    return *result;
+}
+
+std::optional<int> WeightBalancedTree::tryFloor(int key) const {
+    const WBNode* node = root;
+    const WBNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) return node->key;
+        if (key < node->key) {
+            node = node->left;
+        } else {
+            best = node;
+            node = node->right;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> WeightBalancedTree::tryCeiling(int key) const {
+    const WBNode* node = root;
+    const WBNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key == key) return node->key;
+        if (key > node->key) {
+            node = node->right;
+        } else {
+            best = node;
+            node = node->left;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> WeightBalancedTree::predecessor(int key) const {
+    const WBNode* node = root;
+    const WBNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key < key) {
+            best = node;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+std::optional<int> WeightBalancedTree::successor(int key) const {
+    const WBNode* node = root;
+    const WBNode* best = nullptr;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (node->key > key) {
+            best = node;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+    return best ? std::optional<int>(best->key) : std::nullopt;
+}
+
+size_t WeightBalancedTree::rank(int key) const {
+    const WBNode* node = root;
+    size_t result = 0;
+    while (node) {
+        TREE_STATS(stats.nodesVisited++);
+        TREE_STATS(stats.comparisons++);
+        if (key <= node->key) {
+            node = node->left;
+        } else {
+            result += sizeOf(node->left) + 1;
+            node = node->right;
+        }
+    }
+    return result;
+}
+
+int WeightBalancedTree::select(size_t index) const {
+    if (index >= size()) {
+        throw std::runtime_error("Index out of range");
+    }
+    const WBNode* node = root;
+    while (true) {
+        TREE_STATS(stats.nodesVisited++);
+        size_t leftSize = sizeOf(node->left);
+        if (index == leftSize) return node->key;
+        if (index < leftSize) {
+            node = node->left;
+        } else {
+            index -= leftSize + 1;
+            node = node->right;
+        }
+    }
+}
+
+std::vector<std::optional<int>> WeightBalancedTree::floorBatch(const std::vector<int>& probes) const {
+    std::vector<std::optional<int>> result(probes.size());
+    floorBatchRecursive(root, probes, 0, probes.size(), nullptr, result);
+    return result;
+}
+
+std::vector<std::optional<int>> WeightBalancedTree::ceilingBatch(const std::vector<int>& probes) const {
+    std::vector<std::optional<int>> result(probes.size());
+    ceilingBatchRecursive(root, probes, 0, probes.size(), nullptr, result);
+    return result;
+}
+
+std::vector<int> WeightBalancedTree::rangeQuery(int x, int y) const {
+    std::vector<int> result;
+    rangeQueryRecursive(root, x, y, result);
+    return result;
+}
+
+void WeightBalancedTree::loadSorted(const std::vector<int>& sortedKeys) {
+    destroyRecursive(root);
+    root = buildBalancedTree(sortedKeys, 0, static_cast<int>(sortedKeys.size()) - 1);
+}
+
+void WeightBalancedTree::save(const std::string& path) const {
+    std::vector<int> keys;
+    rangeQueryRecursive(root, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), keys);
+    TreeSnapshot::write(path, keys);
+}
+
+void WeightBalancedTree::printRange(int x, int y) const {
+    std::vector<int> rangeValues = rangeQuery(x, y);
+
+    if (rangeValues.empty()) {
+        std::cout << "No values in range [" << x << ", " << y << "]" << std::endl;
+        return;
+    }
+
+    std::cout << "Values in range [" << x << ", " << y << "]: ";
+    for (size_t i = 0; i < rangeValues.size(); ++i) {
+        std::cout << rangeValues[i];
+        if (i < rangeValues.size() - 1) {
+            std::cout << ", ";
+        }
+    }
+    std::cout << std::endl;
+}
+
+size_t WeightBalancedTree::memoryUsage() const {
+    return size() * sizeof(WBNode);
+}
+
+size_t WeightBalancedTree::peakScratchBytes() const {
+    return scratchPeak;
+}
+
+double WeightBalancedTree::getAlpha() const {
+    return alpha;
+}
+
+long long WeightBalancedTree::getRebuildCount() const {
+    return rebuilds;
+}
+
+TreeStats WeightBalancedTree::getStats() const {
+#ifdef HEAPURI_TREE_STATS
+    return stats;
+#else
+    return TreeStats();
+#endif
+}
+
+void WeightBalancedTree::resetStats() {
+#ifdef HEAPURI_TREE_STATS
+    stats = TreeStats();
+#endif
+}